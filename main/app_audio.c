@@ -6,15 +6,56 @@ IMNP 441 data format is Phillips MSB format, 1 CLK cycle delayed data from WS ed
 
 Pins 4, 5, 6 GPIO
 
-Task reads data into a buffer and enqueues that in turn into a ringbuffer for use in other tasks
+Task reads data into a buffer and enqueues that in turn into a ringbuffer for use in other tasks.
+Every chunk is an audio_rec_t tagged with the language of the button state and the I2S slots
+it holds, so the net task never has to guess either from the state at send time.
+
+With APP_AUDIO_ACTIVE_MIC_ONLY the slot mask follows the buttons: the held language's mic
+alone (LANG1 left, LANG2 right), both while idle. Before the channel is stopped for the new
+mask every DMA buffer already filled is read out in the old layout and the task waits for the
+buffer being filled to complete, so the channel restarts on a buffer boundary and only the
+few samples the restart takes are lost. Chunks are a fixed 24 ms either way.
+
+With APP_AUDIO_PREPROC every chunk goes through app_preproc (high-pass, AGC, limiter) before it
+is stored, each mic with its own state, idle audio included so the gain has settled by the time
+a button is pressed. With APP_AUDIO_XTALK (stereo capture only) app_xtalk removes the wearer's
+voice from the forward mic between the high-pass and the AGC. The time both take is in
+audio_get_stats.
+
+With APP_AUDIO_CONVERSATION, in conversation mode (both languages at once) a voice activity
+detector per mic (app_vad) runs between the canceller and the AGC and the chunk is tagged with
+the languages that have voice, so the net task sends a LANG1 stream from the left mic and a
+LANG2 stream from the right one and neither while nobody talks. Capture stays stereo.
+
+With APP_AUDIO_MEL the processed chunk is then replaced by the log-mel frames (app_mel) it
+completes for the mic of its language, the left one while idle, and stored as a CODEC_SLOTS_MEL
+record; a chunk that completes none is not stored. The features follow one mic continuously and
+restart from silence when the mic changes.
+
+With APP_KWS the wearer's mic of every processed chunk (the captured mic when there is only one)
+is copied into a small ring of its own for kws_task, which runs the keyword spotter (app_kws)
+on core 1 below the capture task's priority and hands keywords to gpio_voice_trigger. When that
+ring is full the chunk is lost to the spotter only, capture never waits for it.
+
+When the ring is full (network stalled) the chunk is handled per APP_AUDIO_OVERFLOW:
+drop the oldest audio in the ring, drop the new chunk, or wait for room up to one
+DMA buffer period and then drop the new chunk. The DMA keeps filling meanwhile, so
+the task never waits longer than that. DMA overruns are counted from the driver's
+on_recv_q_ovf event; all counters are in audio_get_stats.
+
+The DMA buffering is APP_AUDIO_DMA_DESC_NUM buffers of APP_AUDIO_DMA_FRAME_NUM frames: shorter
+buffers bring audio to the task sooner, more of them ride out longer stalls. To size them the
+stats hold a histogram of how long each chunk read waited, one of the time between filled DMA
+buffers (the driver's on_recv event), and the reads that came back short.
 
 INPUTS: none
-OUTPUTS: ringbuffer audio_rb interfaces with app_tcp_tx
+OUTPUTS: ringbuffer audio_rb interfaces with app_tcp_tx, keywords to app_gpio
 
 */
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -24,7 +65,16 @@ OUTPUTS: ringbuffer audio_rb interfaces with app_tcp_tx
 #include "esp_err.h"
 #include "sdkconfig.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "freertos/ringbuf.h"
+#include "app_audio.h"
+#include "app_gpio.h"
+#include "app_kws.h"
+#include "app_mel.h"
+#include "app_preproc.h"
+#include "app_vad.h"
+#include "app_xtalk.h"
 
 /* pins */
 
@@ -34,14 +84,59 @@ OUTPUTS: ringbuffer audio_rb interfaces with app_tcp_tx
 
 /* buffer size */
 //multiple of 2 and 3 so it's very multipurpose works with frame depth of any size
-#define INTERMEDIARY_BUF_SIZE   3072
+#define INTERMEDIARY_BUF_SIZE   (AUDIO_CHUNK_FRAMES * CODEC_RAW_FRAME)
 #define RINGBUFFER_SIZE         32768 
+#define I2S_READ_TIMEOUT_MS     CONFIG_APP_AUDIO_READ_TIMEOUT_MS
+#define XTALK_FORWARD           0       // slot of the forward (subject, LANG1) mic; the other is the wearer's
+#define KWS_RB_SIZE             8192    // five chunks of one mic for kws_task
+#define KWS_TASK_PRIO           4       // under the capture, button and display tasks
+
+#if CONFIG_APP_AUDIO_BLOCK
+#define AUDIO_PUSH_WAIT_MS      CONFIG_APP_AUDIO_PUSH_WAIT_MS
+#else
+#define AUDIO_PUSH_WAIT_MS      0
+#endif
 
 static const char *TAG = "audio_task";
 
 static i2s_chan_handle_t rx_handle; 
 
 static RingbufHandle_t audio_rb;
+static volatile audio_stats_t stats;     // written by i2s_read_task and the ISR, read by anyone
+static TickType_t push_wait;             // APP_AUDIO_BLOCK wait, at most one DMA buffer period
+static uint8_t cur_slots = CODEC_SLOTS_STEREO; // layout the DMA delivers, CODEC_SLOTS_*
+static uint8_t last_lang;                // tag of the last chunk that had the button's mic
+static int64_t dma_last_us;              // last on_recv event, ISR only
+#if CONFIG_APP_AUDIO_PREPROC
+static preproc_t preproc;
+#endif
+#if CONFIG_APP_AUDIO_XTALK
+static xtalk_t xtalk;
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+static vad_t vad[2];                     // LANG1 (left) and LANG2 (right) mic
+static bool vad_on;                      // detectors have state from conversation mode
+#endif
+#if CONFIG_APP_AUDIO_MEL
+static mel_t mel;                        // tables and window, too big for the task stack
+static int16_t mel_out[(AUDIO_CHUNK_FRAMES / MEL_HOP + 1) * MEL_BINS];
+static uint8_t mel_mic;                  // slot mel follows, 0 left 1 right
+#endif
+#if CONFIG_APP_KWS
+/* one mic of a chunk in kws_rb (no-split) */
+typedef struct {
+    uint32_t seq;                        // chunks offered, a gap means the spotter missed audio
+    uint16_t frames;
+    uint8_t mic;                         // 0 left 1 right
+    int32_t samples[];
+} kws_rec_t;
+
+extern const uint8_t kws_model_start[] asm("_binary_kws_model_bin_start");
+extern const uint8_t kws_model_end[] asm("_binary_kws_model_bin_end");
+static kws_t kws;                        // tables and feature window, too big for the task stack
+static RingbufHandle_t kws_rb;
+static uint32_t kws_seq;
+#endif
 
 /* initialization settings deviations from example norm are stated below*/
 /* picked to be valid for ESP-32 S3 (I2S0 and 1 available, using system available)*/
@@ -49,11 +144,18 @@ static RingbufHandle_t audio_rb;
 /* deviation: i2s_std_clk_config_t: sample_rate_hz 16000 for low mem use + for openai-whisper*/
 /* deviation: mclk_multiple I2S_MCLK_MULTIPLE_384 since i2s_std_slot_config has .data_bit_width 24*/
 
-static const i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+/* deviation: DMA buffer count and length from Kconfig, the driver default is 6 x 240 frames */
+static const i2s_chan_config_t chan_cfg = {
+    .id            = I2S_NUM_AUTO,
+    .role          = I2S_ROLE_MASTER,
+    .dma_desc_num  = CONFIG_APP_AUDIO_DMA_DESC_NUM,
+    .dma_frame_num = CONFIG_APP_AUDIO_DMA_FRAME_NUM,
+    .auto_clear    = false,
+};
 
 static const i2s_std_config_t std_cfg = {
     .clk_cfg  = {
-        .sample_rate_hz = 16000,
+        .sample_rate_hz = AUDIO_CAPTURE_RATE,
         .clk_src        = I2S_CLK_SRC_DEFAULT,
         .mclk_multiple  = I2S_MCLK_MULTIPLE_384,
         .bclk_div       = 8,
@@ -74,17 +176,75 @@ static const i2s_std_config_t std_cfg = {
 };
 
 
+/* histogram bucket of a time: under 1 ms, under 2, 4 ... 64, longer. In IRAM for the ISR */
+static IRAM_ATTR uint32_t audio_hist_bucket(uint32_t us)
+{
+    uint32_t ms = us / 1000;
+    uint32_t bucket = ms == 0 ? 0 : 32 - (uint32_t)__builtin_clz(ms);
+    return bucket < AUDIO_HIST_BUCKETS ? bucket : AUDIO_HIST_BUCKETS - 1;
+}
+
+/* ISR: DMA filled a buffer nobody had room to take, the oldest DMA data is gone */
+static IRAM_ATTR bool i2s_rx_overrun(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    stats.dma_overruns++;
+    return false;
+}
+
+/* ISR: DMA filled a buffer; times the gap since the last one */
+static IRAM_ATTR bool i2s_rx_done(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    int64_t now = esp_timer_get_time();
+    if (dma_last_us != 0) {
+        uint32_t gap = (uint32_t)(now - dma_last_us);
+        stats.dma_gap_hist[audio_hist_bucket(gap)]++;
+        if (gap > stats.dma_gap_us_max) {
+            stats.dma_gap_us_max = gap;
+        }
+    }
+    dma_last_us = now;
+    stats.dma_buffers++;
+    return false;
+}
+
 static void i2s_init_std(void)
 {
     /* Channel configs are set for IMNP441 microphone*/
     /* Channel configs tend to be plug and play*/
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx_handle));
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle, &std_cfg));
+
+    const i2s_event_callbacks_t cbs = {
+        .on_recv = i2s_rx_done,
+        .on_recv_q_ovf = i2s_rx_overrun,
+    };
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(rx_handle, &cbs, NULL));
+
+    uint32_t dma_period_ms = chan_cfg.dma_frame_num * 1000 / std_cfg.clk_cfg.sample_rate_hz;
+    uint32_t wait_ms = AUDIO_PUSH_WAIT_MS < dma_period_ms ? AUDIO_PUSH_WAIT_MS : dma_period_ms;
+    push_wait = pdMS_TO_TICKS(wait_ms);
+    ESP_LOGI(TAG, "DMA %lu buffers of %lu ms, capture ring push wait %lu ms", (unsigned long)chan_cfg.dma_desc_num,
+             (unsigned long)dma_period_ms, (unsigned long)wait_ms);
+#if CONFIG_APP_AUDIO_PREPROC
+    preproc_init(&preproc, std_cfg.clk_cfg.sample_rate_hz, CONFIG_APP_AUDIO_HPF_HZ, CONFIG_APP_AUDIO_AGC_MAX_DB);
+#endif
+#if CONFIG_APP_AUDIO_XTALK
+    xtalk_init(&xtalk, CONFIG_APP_AUDIO_XTALK_TAPS);
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+    uint32_t chunk_ms = AUDIO_CHUNK_FRAMES * 1000 / AUDIO_CAPTURE_RATE;
+    uint16_t hang = (uint16_t)((CONFIG_APP_AUDIO_VAD_HANG_MS + chunk_ms - 1) / chunk_ms);
+    vad_init(&vad[0], CONFIG_APP_AUDIO_VAD_THRESHOLD_DB, AUDIO_VAD_FORWARD_LEAD_DB, hang);
+    vad_init(&vad[1], CONFIG_APP_AUDIO_VAD_THRESHOLD_DB, AUDIO_VAD_WEARER_LEAD_DB, hang);
+#endif
+#if CONFIG_APP_AUDIO_MEL
+    mel_init(&mel);
+#endif
 }
 
 static void init_audio_rb(void)
 {
-    audio_rb = xRingbufferCreate(RINGBUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
+    audio_rb = xRingbufferCreate(RINGBUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
     assert(audio_rb);
     ESP_LOGD(TAG, "interface audio ringbuffer initialized");
 }
@@ -95,11 +255,255 @@ RingbufHandle_t audio_get_rb(void)
     return audio_rb;
 }
 
+void audio_get_stats(audio_stats_t *out)
+{
+    /* plain 32 bit counters, each read is atomic; a snapshot across them does not need to be */
+    *out = stats;
+}
+
+/* a chunk with audio of these languages is lost */
+static void audio_count_drop(uint8_t lang)
+{
+    if (lang & MSG_FLAG_LANG1) {
+        stats.lang_dropped[0]++;
+    }
+    if (lang & MSG_FLAG_LANG2) {
+        stats.lang_dropped[1]++;
+    }
+}
+
+/* ring full: makes room for the record by dropping the oldest audio (if that policy is set), then
+ * stores the chunk or drops it. Never waits longer than push_wait */
+static void audio_push(const audio_rec_t *rec)
+{
+    size_t size = sizeof(*rec) + rec->len;
+#if CONFIG_APP_AUDIO_DROP_OLDEST
+    size_t free_size;
+    while ((free_size = xRingbufferGetCurFreeSize(audio_rb)) < size) {
+        size_t old_size = 0;
+        audio_rec_t *old = (audio_rec_t *)xRingbufferReceive(audio_rb, &old_size, 0);
+        if (!old) {
+            break;
+        }
+        stats.dropped_oldest += old->len;
+        audio_count_drop(old->lang);
+        vRingbufferReturnItem(audio_rb, old);
+        /* space comes back in ring order: nothing frees up while the net task holds an older record */
+        if (xRingbufferGetCurFreeSize(audio_rb) == free_size) {
+            break;
+        }
+    }
+#endif
+    if (xRingbufferSend(audio_rb, rec, size, 0) == pdTRUE) {
+        return;
+    }
+    if (push_wait > 0) {
+        stats.push_waits++;
+        if (xRingbufferSend(audio_rb, rec, size, push_wait) == pdTRUE) {
+            return;
+        }
+    }
+    stats.dropped_newest++;
+    audio_count_drop(rec->lang);
+    ESP_LOGD(TAG, "failed ringbuffer push"); //remove logging for live
+}
+
+#if CONFIG_APP_AUDIO_CONVERSATION
+/* conversation mode: the chunk's tag becomes the languages whose mic has voice (always stereo);
+ * other chunks only end the detectors' run */
+static void audio_vad(audio_rec_t *rec, const int32_t *slots, size_t frames)
+{
+    if (rec->lang != AUDIO_LANG_BOTH) {
+        if (vad_on) {
+            vad_reset(&vad[0]);
+            vad_reset(&vad[1]);
+            vad_on = false;
+        }
+        return;
+    }
+    vad_on = true;
+    uint32_t left = vad_level(slots, frames, 2);
+    uint32_t right = vad_level(slots + 1, frames, 2);
+    uint8_t lang = 0;
+    if (vad_update(&vad[0], left, right)) {
+        lang |= MSG_FLAG_LANG1;
+        stats.voiced[0]++;
+    }
+    if (vad_update(&vad[1], right, left)) {
+        lang |= MSG_FLAG_LANG2;
+        stats.voiced[1]++;
+    }
+    stats.conv_chunks++;
+    rec->lang = lang;
+}
+#endif
+
+/* pre-processing in place, APP_AUDIO_PREPROC and APP_AUDIO_XTALK. Stereo chunks get the high-pass
+ * on both mics, then the canceller, then the AGC, so the canceller sees neither DC nor gain changes;
+ * the conversation mode detectors go before the AGC too, they compare levels */
+static void audio_process(audio_rec_t *rec, size_t len)
+{
+#if CONFIG_APP_AUDIO_PREPROC || CONFIG_APP_AUDIO_XTALK || CONFIG_APP_AUDIO_CONVERSATION
+    int64_t start = esp_timer_get_time();
+    int32_t *slots = (int32_t *)rec->data;
+    size_t frames = len / codec_slot_frame(cur_slots);
+    if (cur_slots == CODEC_SLOTS_STEREO) {
+#if CONFIG_APP_AUDIO_PREPROC
+        preproc_hpf(&preproc, 0, slots, frames, 2);
+        preproc_hpf(&preproc, 1, slots + 1, frames, 2);
+#endif
+#if CONFIG_APP_AUDIO_XTALK
+        int64_t xtalk_start = esp_timer_get_time();
+        xtalk_run(&xtalk, slots, frames, XTALK_FORWARD);
+        uint32_t xtalk_us = (uint32_t)(esp_timer_get_time() - xtalk_start);
+        xtalk_pace(&xtalk, xtalk_us, CONFIG_APP_AUDIO_XTALK_BUDGET_US);
+        stats.xtalk_us += xtalk_us;
+        stats.xtalk_atten_db10 = xtalk.atten_db10;
+        stats.xtalk_adapt_shift = xtalk.adapt_shift;
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+        audio_vad(rec, slots, frames);
+#endif
+#if CONFIG_APP_AUDIO_PREPROC
+        preproc_agc(&preproc, 0, slots, frames, 2);
+        preproc_agc(&preproc, 1, slots + 1, frames, 2);
+#endif
+    } else {
+#if CONFIG_APP_AUDIO_CONVERSATION
+        audio_vad(rec, slots, frames);
+#endif
+#if CONFIG_APP_AUDIO_PREPROC
+        preproc_run(&preproc, cur_slots == CODEC_SLOTS_RIGHT, slots, frames, 1);
+#endif
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    stats.preproc_us += us;
+    if (us > stats.preproc_us_max) {
+        stats.preproc_us_max = us;
+    }
+#endif
+}
+
+#if CONFIG_APP_AUDIO_MEL
+/* replaces the len bytes of audio in rec with the log-mel frames they complete, of the mic that
+ * captures rec->lang; false when there are none */
+static bool audio_mel(audio_rec_t *rec, size_t len)
+{
+    int64_t start = esp_timer_get_time();
+    uint8_t mic = cur_slots == CODEC_SLOTS_STEREO ? rec->lang == MSG_FLAG_LANG2 : cur_slots == CODEC_SLOTS_RIGHT;
+    if (mic != mel_mic) {
+        mel_reset(&mel);
+        mel_mic = mic;
+    }
+    const int32_t *slots = (const int32_t *)rec->data;
+    size_t stride = 1;
+    if (cur_slots == CODEC_SLOTS_STEREO) {
+        slots += mic;
+        stride = 2;
+    }
+    size_t frames = mel_push(&mel, slots, len / codec_slot_frame(cur_slots), stride, mel_out);
+    memcpy(rec->data, mel_out, frames * MEL_FRAME_BYTES);
+    rec->slots = CODEC_SLOTS_MEL;
+    rec->len = (uint16_t)(frames * MEL_FRAME_BYTES);
+    stats.mel_frames += frames;
+    stats.mel_us += (uint32_t)(esp_timer_get_time() - start);
+    return frames > 0;
+}
+#endif
+
+#if CONFIG_APP_KWS
+/* copies the mic kws_task listens to out of a processed chunk, the wearer's when both are there */
+static void audio_kws_feed(const audio_rec_t *rec, size_t len)
+{
+    size_t frames = len / codec_slot_frame(cur_slots);
+    uint8_t mic = cur_slots == CODEC_SLOTS_STEREO ? 1 - XTALK_FORWARD : cur_slots == CODEC_SLOTS_RIGHT;
+    uint32_t seq = kws_seq++;
+    kws_rec_t *k = NULL;
+    if (xRingbufferSendAcquire(kws_rb, (void **)&k, sizeof(*k) + frames * sizeof(int32_t), 0) != pdTRUE) {
+        stats.kws_dropped++;
+        return;
+    }
+    k->seq = seq;
+    k->frames = (uint16_t)frames;
+    k->mic = mic;
+    const int32_t *slots = (const int32_t *)rec->data;
+    if (cur_slots == CODEC_SLOTS_STEREO) {
+        for (size_t i = 0; i < frames; i++) {
+            k->samples[i] = slots[2 * i + mic];
+        }
+    } else {
+        memcpy(k->samples, slots, frames * sizeof(int32_t));
+    }
+    xRingbufferSendComplete(kws_rb, k);
+}
+#endif
+
+/* tags and stores len bytes read into rec. The chunk belongs to the button state if it holds that
+ * language's mic; one captured from the other mic (LANG1 straight to LANG2) still belongs to the last */
+static void audio_store(audio_rec_t *rec, size_t len, uint8_t lang)
+{
+    if (len == 0) {
+        return;
+    }
+    if (lang != 0 && cur_slots != CODEC_SLOTS_STEREO && cur_slots != audio_lang_slots(lang)) {
+        lang = last_lang;
+    } else {
+        last_lang = lang;
+    }
+    rec->lang = lang;
+    rec->slots = cur_slots;
+    rec->len = (uint16_t)len;
+    rec->ts_us = (uint32_t)esp_timer_get_time();
+    stats.chunks++;
+    audio_process(rec, len);
+#if CONFIG_APP_KWS
+    audio_kws_feed(rec, len);
+#endif
+#if CONFIG_APP_AUDIO_MEL
+    if (!audio_mel(rec, len)) {
+        return;
+    }
+#endif
+    audio_push(rec);
+}
+
+/* changes the slot mask without losing audio: stores every DMA buffer already filled, waits for
+ * the one being filled, then restarts the channel on that buffer boundary */
+static void audio_switch_slots(audio_rec_t *rec, uint8_t lang, uint8_t slots)
+{
+    size_t frame = codec_slot_frame(cur_slots);
+    size_t got = 0;
+    esp_err_t err;
+    do {
+        err = i2s_channel_read(rx_handle, rec->data, AUDIO_CHUNK_FRAMES * frame, &got, 0);
+        audio_store(rec, got, lang);
+    } while (err == ESP_OK);
+    err = i2s_channel_read(rx_handle, rec->data, chan_cfg.dma_frame_num * frame, &got, I2S_READ_TIMEOUT_MS);
+    audio_store(rec, got, lang);
+    if (err != ESP_OK) {
+        stats.read_errors++;
+    }
+
+    int64_t start = esp_timer_get_time();
+    i2s_std_slot_config_t slot_cfg = std_cfg.slot_cfg;
+    if (slots != CODEC_SLOTS_STEREO) {
+        slot_cfg.slot_mode = I2S_SLOT_MODE_MONO;
+        slot_cfg.slot_mask = slots == CODEC_SLOTS_LEFT ? I2S_STD_SLOT_LEFT : I2S_STD_SLOT_RIGHT;
+    }
+    ESP_ERROR_CHECK(i2s_channel_disable(rx_handle));
+    dma_last_us = 0;                     // the restart is no gap between buffers
+    ESP_ERROR_CHECK(i2s_channel_reconfig_std_slot(rx_handle, &slot_cfg));
+    ESP_ERROR_CHECK(i2s_channel_enable(rx_handle));
+    cur_slots = slots;
+    stats.slot_switches++;
+    ESP_LOGD(TAG, "slots -> %d in %lld us", slots, (long long)(esp_timer_get_time() - start));
+}
+
 static void i2s_read_task(void *args)
 {   
     /* init intermed buffer*/
-    uint8_t *int_buf = (uint8_t *)calloc(1, INTERMEDIARY_BUF_SIZE);
-    assert(int_buf);
+    audio_rec_t *rec = (audio_rec_t *)calloc(1, sizeof(audio_rec_t) + INTERMEDIARY_BUF_SIZE);
+    assert(rec);
     size_t int_bytes = 0;
     ESP_LOGI(TAG, "intermediary buffer initialized");
 
@@ -108,29 +512,111 @@ static void i2s_read_task(void *args)
     ESP_LOGI(TAG, "audio task running");
 
     /* IMPORTANT: next bit must be very fast to avoid DMA buffer overflow data loss*/
-    /* around 30 ms expected, timeout 500*/
+    /* around 24 ms expected, timeout APP_AUDIO_READ_TIMEOUT_MS*/
     while(1){
-        if (i2s_channel_read(rx_handle, int_buf, INTERMEDIARY_BUF_SIZE, &int_bytes, 500) == ESP_OK) {
+        size_t frame = codec_slot_frame(cur_slots);
+        size_t chunk_bytes = AUDIO_CHUNK_FRAMES * frame;
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = i2s_channel_read(rx_handle, rec->data, chunk_bytes, &int_bytes, I2S_READ_TIMEOUT_MS);
+        uint32_t read_us = (uint32_t)(esp_timer_get_time() - start);
+        stats.read_hist[audio_hist_bucket(read_us)]++;
+        if (read_us > stats.read_us_max) {
+            stats.read_us_max = read_us;
+        }
+        if (int_bytes < chunk_bytes) {
+            stats.short_reads++;
+        }
+        if (err != ESP_OK) {
+            stats.read_errors++;
+            ESP_LOGD(TAG, "audio read task FAILED");
+        }
+        /* a timed out read keeps what arrived */
+        int_bytes -= int_bytes % frame;
+        if (int_bytes > 0) {
             ESP_LOGD(TAG, "audio read task read %zu bytes", int_bytes);
 
-            BaseType_t ok = xRingbufferSend(audio_rb, int_buf, int_bytes, pdMS_TO_TICKS(5));
-            if (ok != pdTRUE) {
-                ESP_LOGD(TAG, "failed ringbuffer push"); //remove logging for live
+            uint8_t lang = audio_state_lang(gpio_get_state());
+            audio_store(rec, int_bytes, lang);
+            if (audio_lang_slots(lang) != cur_slots) {
+                audio_switch_slots(rec, lang, audio_lang_slots(lang));
             }
         }
-        else {
-            ESP_LOGD(TAG, "audio read task FAILED");
-        }
         /*here put vTaskDelay for testing*/ 
         //vTaskDelay(30);
     }
-    free(int_buf);
+    free(rec);
     vTaskDelete(NULL);
 }
 
+#if CONFIG_APP_KWS
+/* the keyword a label stands for, as a button state; false for labels the headset only counts */
+static bool kws_label_state(const char *label, app_gpio_state_t *state)
+{
+    if (!strcmp(label, "lang1")) {
+        *state = APP_GPIO_STATE_TRANSLATE_LANG1;
+    } else if (!strcmp(label, "lang2")) {
+        *state = APP_GPIO_STATE_TRANSLATE_LANG2;
+    } else if (!strcmp(label, "stop")) {
+        *state = APP_GPIO_STATE_IDLE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* runs the keyword spotter on what audio_kws_feed hands over, paced to APP_KWS_BUDGET_PCT */
+static void kws_task(void *args)
+{
+    if (!kws_init(&kws, kws_model_start, (size_t)(kws_model_end - kws_model_start), CONFIG_APP_KWS_THRESHOLD)) {
+        ESP_LOGE(TAG, "keyword model does not load, spotter off");
+        vTaskDelete(NULL);
+        return;
+    }
+    ESP_LOGI(TAG, "keyword spotter running, %d classes, %d ms window", kws.n_classes,
+             kws.in_frames * KWS_FRAME_MS);
+    uint32_t next_seq = 0;
+    uint8_t mic = 0;
+    while (1) {
+        size_t size = 0;
+        kws_rec_t *k = (kws_rec_t *)xRingbufferReceive(kws_rb, &size, portMAX_DELAY);
+        if (!k) {
+            continue;
+        }
+        if (k->seq != next_seq || k->mic != mic) {
+            kws_restart(&kws);
+            mic = k->mic;
+        }
+        next_seq = k->seq + 1;
+        int64_t start = esp_timer_get_time();
+        int hit = kws_push(&kws, k->samples, k->frames, 1);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        uint32_t audio_us = (uint32_t)k->frames * 1000 / (AUDIO_CAPTURE_RATE / 1000);
+        vRingbufferReturnItem(kws_rb, k);
+        kws_pace(&kws, us, audio_us, CONFIG_APP_KWS_BUDGET_PCT);
+        stats.kws_us += us;
+        stats.kws_period_ms = kws.period * KWS_FRAME_MS;
+        stats.kws_inferences = kws.inferences;
+
+        app_gpio_state_t state;
+        if (hit != KWS_NONE) {
+            ESP_LOGI(TAG, "keyword %s, %d%%", kws.labels[hit], (int)(kws.last_prob * 100.0f));
+            if (kws_label_state(kws.labels[hit], &state)) {
+                stats.kws_triggers++;
+                gpio_voice_trigger(state);
+            }
+        }
+    }
+}
+#endif
+
 void audio_make_tasks(void)
 {
     init_audio_rb();
     i2s_init_std();
+#if CONFIG_APP_KWS
+    kws_rb = xRingbufferCreate(KWS_RB_SIZE, RINGBUF_TYPE_NOSPLIT);
+    assert(kws_rb);
+    xTaskCreatePinnedToCore(kws_task, "kws_task", 3072, NULL, KWS_TASK_PRIO, NULL, 1);
+#endif
     xTaskCreatePinnedToCore(i2s_read_task, "i2s_read_task", 4096, NULL, 8, NULL, 1);
 }
@@ -1,6 +1,93 @@
 #pragma once
+#include <stdint.h>
+#include "sdkconfig.h"
 #include "freertos/ringbuf.h"
+#include "app_codec.h"
+#include "app_frame.h"
+#include "app_gpio.h"
+
+#define AUDIO_CAPTURE_RATE 16000 // I2S sample rate, Hz; the link's rate is the encoder's (app_codec.c)
+#define AUDIO_CHUNK_FRAMES (AUDIO_CAPTURE_RATE * 24 / 1000) // sample frames per record, 24 ms
+#define AUDIO_LANG_BOTH (MSG_FLAG_LANG1 | MSG_FLAG_LANG2) // conversation mode, LANG1 left mic, LANG2 right
+#define AUDIO_MEL_BUDGET_US 1000 // per log-mel frame, a tenth of core 1 at one frame per 10 ms
+#define AUDIO_VAD_FORWARD_LEAD_DB (-6) // conversation mode: forward mic voice may be this far under the wearer's
+#define AUDIO_VAD_WEARER_LEAD_DB 6       // and the wearer mic's has to be this far over the forward one
+#define AUDIO_HIST_BUCKETS 8     // I2S timing histograms: under 1, 2, 4 ... 64 ms, and longer
 
 void audio_make_tasks();
 
-RingbufHandle_t audio_get_rb();
\ No newline at end of file
+RingbufHandle_t audio_get_rb();
+
+/* one capture chunk in audio_rb (no-split), read in place */
+typedef struct {
+    uint8_t lang;         // MSG_FLAG_LANG1/2 of the button state it was captured in, 0 idle; in
+                          // conversation mode the languages whose mic has voice, none, one or both
+    uint8_t slots;        // CODEC_SLOTS_*: mics the DMA delivered, or CODEC_SLOTS_MEL
+    uint16_t len;         // bytes in data, whole sample (or log-mel) frames
+    uint32_t ts_us;       // esp_timer time the chunk was read (low 32 bits): latency stats, frame capture time
+    uint8_t data[];       // 32 bit I2S slots, or log-mel frames
+} audio_rec_t;
+
+typedef struct {
+    uint32_t chunks;             // read from I2S
+    uint32_t dropped_newest;     // chunks not stored, audio_rb was full
+    uint32_t dropped_oldest;     // bytes of older audio discarded to make room
+    uint32_t push_waits;         // chunks that had to wait for room
+    uint32_t dma_overruns;       // I2S receive queue overflowed, DMA data lost before it was read
+    uint32_t read_errors;
+    uint32_t short_reads;        // reads that returned less than a chunk
+    uint32_t read_hist[AUDIO_HIST_BUCKETS]; // time i2s_channel_read waited for a chunk
+    uint32_t read_us_max;
+    uint32_t dma_buffers;        // DMA buffers filled, I2S on_recv events
+    uint32_t dma_gap_hist[AUDIO_HIST_BUCKETS]; // time between them
+    uint32_t dma_gap_us_max;
+    uint32_t slot_switches;      // I2S slot mask changes, APP_AUDIO_ACTIVE_MIC_ONLY
+    uint32_t preproc_us;         // time in app_preproc, app_xtalk and app_vad, wraps
+    uint32_t preproc_us_max;     // longest chunk
+    uint32_t xtalk_us;           // app_xtalk's part of preproc_us, wraps; APP_AUDIO_XTALK
+    int32_t xtalk_atten_db10;    // forward mic attenuation while the wearer talks alone, 0.1 dB
+    uint32_t xtalk_adapt_shift;  // budget pacing: adapts on 1 block in 2^shift
+    uint32_t mel_frames;         // log-mel frames made, APP_AUDIO_MEL
+    uint32_t mel_us;             // time making them, wraps
+    uint32_t conv_chunks;        // chunks captured in conversation mode
+    uint32_t voiced[2];          // of those, with voice on the LANG1 / LANG2 mic
+    uint32_t lang_dropped[2];    // chunks with LANG1 / LANG2 audio lost in the capture ring
+    uint32_t kws_us;             // time in the keyword spotter, wraps; APP_KWS
+    uint32_t kws_period_ms;      // budget pacing: audio per model run
+    uint32_t kws_inferences;     // model runs
+    uint32_t kws_triggers;       // keywords acted on
+    uint32_t kws_dropped;        // chunks the spotter missed, its ring was full
+} audio_stats_t;
+
+/* capture counters since boot, written by i2s_read_task, kws_task and the I2S ISR */
+void audio_get_stats(audio_stats_t *stats);
+
+/* language a button state captures for, 0 when idle */
+static inline uint8_t audio_state_lang(app_gpio_state_t state)
+{
+    if (state == APP_GPIO_STATE_TRANSLATE_LANG1) {
+        return MSG_FLAG_LANG1;
+    }
+    if (state == APP_GPIO_STATE_TRANSLATE_LANG2) {
+        return MSG_FLAG_LANG2;
+    }
+    if (state == APP_GPIO_STATE_CONVERSATION) {
+        return AUDIO_LANG_BOTH;
+    }
+    return 0;
+}
+
+/* slots to capture for a language: its mic with APP_AUDIO_ACTIVE_MIC_ONLY, else (and idle, and
+ * in conversation mode) both */
+static inline uint8_t audio_lang_slots(uint8_t lang)
+{
+#if CONFIG_APP_AUDIO_ACTIVE_MIC_ONLY
+    if (lang == MSG_FLAG_LANG1) {
+        return CODEC_SLOTS_LEFT;
+    }
+    if (lang == MSG_FLAG_LANG2) {
+        return CODEC_SLOTS_RIGHT;
+    }
+#endif
+    return CODEC_SLOTS_STEREO;
+}
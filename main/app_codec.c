@@ -0,0 +1,245 @@
+/* Eric Liu 2026
+
+Uplink audio encoder. Takes raw capture (32 bit I2S slots with 24 bit samples
+left aligned, both mics or only the active one, at in_rate) and produces the
+AUDIO_FMT_* payloads the link quality controller picks between; at 16 kHz
+capture:
+
+  RAW       both slots as captured, 128 bytes/ms
+  S16       active mic as mono s16 at s16_rate (8, 12 or 16 kHz), 16-32 bytes/ms
+  S16_8K    mono s16 at 8 kHz, 16 bytes/ms
+  ADPCM_8K  the 8 kHz stream as IMA ADPCM, 4 bytes/ms plus a 4 byte header
+
+Rates below the capture rate go through the polyphase resampler
+(app_resample.c), which keeps speech above the new Nyquist frequency from
+folding back. Every frame's header carries its rate (AUDIO_RATE_*).
+ADPCM frames start with the predictor and step index, so a server can decode
+any frame without the ones before it (lost UDP datagrams, resend gaps).
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: raw capture chunks
+OUTPUTS: encoded AUDIO payloads
+
+*/
+
+#include "app_codec.h"
+#include "app_frame.h"
+
+#include <string.h>
+
+static const int16_t ima_step[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t ima_index[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static uint8_t rate_code(uint32_t rate)
+{
+    switch (rate) {
+    case 16000:
+        return AUDIO_RATE_16K;
+    case 12000:
+        return AUDIO_RATE_12K;
+    case 8000:
+        return AUDIO_RATE_8K;
+    default:
+        return AUDIO_RATE_NONE;
+    }
+}
+
+bool codec_init(codec_t *c, uint32_t in_rate, uint32_t s16_rate)
+{
+    *c = (codec_t) { .in_rate = in_rate, .s16_rate = s16_rate };
+    if (rate_code(in_rate) == AUDIO_RATE_NONE || rate_code(s16_rate) == AUDIO_RATE_NONE || s16_rate > in_rate) {
+        return false;
+    }
+    bool ok = resample_init(&c->to_8k, in_rate, CODEC_8K_RATE);
+    if (ok && s16_rate < in_rate) {
+        ok = resample_init(&c->s16, in_rate, s16_rate);
+    }
+    if (!ok) {
+        codec_free(c);
+    }
+    return ok;
+}
+
+void codec_free(codec_t *c)
+{
+    resample_free(&c->s16);
+    resample_free(&c->to_8k);
+}
+
+/* new stream: a format or mic change starts every filter from silence */
+static void codec_reset(codec_t *c, uint8_t fmt, uint8_t mic)
+{
+    c->fmt = fmt;
+    c->mic = mic;
+    if (c->s16.taps) {
+        resample_reset(&c->s16);
+    }
+    resample_reset(&c->to_8k);
+    c->predictor = 0;
+    c->index = 0;
+}
+
+uint32_t codec_rate(const codec_t *c, uint8_t fmt)
+{
+    switch (fmt) {
+    case AUDIO_FMT_S16:
+        return c->s16_rate;
+    case AUDIO_FMT_S16_8K:
+    case AUDIO_FMT_ADPCM_8K:
+        return CODEC_8K_RATE;
+    default:
+        return c->in_rate;
+    }
+}
+
+uint8_t codec_rate_code(const codec_t *c, uint8_t fmt)
+{
+    return rate_code(codec_rate(c, fmt));
+}
+
+uint32_t codec_bytes_per_ms(const codec_t *c, uint8_t fmt)
+{
+    uint32_t rate = codec_rate(c, fmt);
+    switch (fmt) {
+    case AUDIO_FMT_S16:
+    case AUDIO_FMT_S16_8K:
+        return rate * 2 / 1000;
+    case AUDIO_FMT_ADPCM_8K:
+        return rate / 2 / 1000;
+    default:
+        return rate * CODEC_RAW_FRAME / 1000;
+    }
+}
+
+static inline int16_t clamp16(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+/* top 16 bits of a 32 bit slot */
+static inline int16_t raw_s16(const uint8_t *slot)
+{
+    int32_t v;
+    memcpy(&v, slot, sizeof(v));
+    return (int16_t)(v >> 16);
+}
+
+static inline void put_le16(uint8_t *dst, int16_t v)
+{
+    dst[0] = (uint8_t)v;
+    dst[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static uint8_t adpcm_code(codec_t *c, int16_t sample)
+{
+    int32_t diff = sample - c->predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    int32_t step = ima_step[c->index];
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+    c->predictor = clamp16(c->predictor + ((code & 8) ? -delta : delta));
+    int32_t index = c->index + ima_index[code];
+    c->index = (int8_t)(index < 0 ? 0 : (index > 88 ? 88 : index));
+    return code;
+}
+
+size_t codec_encode(codec_t *c, uint8_t fmt, uint8_t slots, uint8_t lang, const uint8_t *raw, size_t len,
+                    uint8_t *dst)
+{
+    uint8_t mic = slots == CODEC_SLOTS_STEREO ? (lang == MSG_FLAG_LANG2) : (slots == CODEC_SLOTS_RIGHT);
+    if (fmt != c->fmt || mic != c->mic) {
+        codec_reset(c, fmt, mic);
+    }
+    size_t stride = codec_slot_frame(slots);
+    size_t frames = len / stride;
+    /* the wanted mic's slot in the first frame */
+    const uint8_t *slot = raw + (slots == CODEC_SLOTS_STEREO ? mic * 4 : 0);
+    size_t out = 0;
+    switch (fmt) {
+    case AUDIO_FMT_S16:
+        if (!c->s16.taps) {
+            for (size_t i = 0; i < frames; i++) {
+                put_le16(dst + out, raw_s16(slot + i * stride));
+                out += 2;
+            }
+            return out;
+        }
+        for (size_t i = 0; i < frames; i++) {
+            int16_t s;
+            if (resample_push(&c->s16, raw_s16(slot + i * stride), &s)) {
+                put_le16(dst + out, s);
+                out += 2;
+            }
+        }
+        return out;
+    case AUDIO_FMT_S16_8K:
+        for (size_t i = 0; i < frames; i++) {
+            int16_t s;
+            if (resample_push(&c->to_8k, raw_s16(slot + i * stride), &s)) {
+                put_le16(dst + out, s);
+                out += 2;
+            }
+        }
+        return out;
+    case AUDIO_FMT_ADPCM_8K: {
+        put_le16(dst, (int16_t)c->predictor);
+        dst[2] = (uint8_t)c->index;
+        dst[3] = 0;
+        out = CODEC_ADPCM_HDR;
+        bool high = false;
+        for (size_t i = 0; i < frames; i++) {
+            int16_t s;
+            if (!resample_push(&c->to_8k, raw_s16(slot + i * stride), &s)) {
+                continue;
+            }
+            uint8_t code = adpcm_code(c, s);
+            if (high) {
+                dst[out++] |= (uint8_t)(code << 4);
+            } else {
+                dst[out] = code;
+            }
+            high = !high;
+        }
+        /* odd sample count: the last byte's high nibble is a padding 0 */
+        return high ? out + 1 : out;
+    }
+    default:
+        if (slots == CODEC_SLOTS_STEREO) {
+            memcpy(dst, raw, frames * CODEC_RAW_FRAME);
+            return frames * CODEC_RAW_FRAME;
+        }
+        memset(dst, 0, frames * CODEC_RAW_FRAME);
+        for (size_t i = 0; i < frames; i++) {
+            memcpy(dst + i * CODEC_RAW_FRAME + mic * 4, raw + i * stride, 4);
+        }
+        return frames * CODEC_RAW_FRAME;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "app_mel.h"
+#include "app_resample.h"
+
+/* Uplink audio formats (AUDIO_FMT_* in app_frame.h) made from raw capture */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CODEC_RAW_FRAME 8        // bytes per AUDIO_FMT_RAW sample frame: two 32 bit slots
+#define CODEC_ADPCM_HDR 4
+#define CODEC_8K_RATE 8000       // AUDIO_FMT_S16_8K and AUDIO_FMT_ADPCM_8K
+
+/* I2S slots in captured audio. MSG_FLAG_LANG1 is the left mic, MSG_FLAG_LANG2 the right one */
+#define CODEC_SLOTS_STEREO 0     // both mics, CODEC_RAW_FRAME bytes per frame
+#define CODEC_SLOTS_LEFT   1     // one mic, one 32 bit slot per frame
+#define CODEC_SLOTS_RIGHT  2
+#define CODEC_SLOTS_MEL    3     // not audio: log-mel frames of one mic (APP_AUDIO_MEL), sent as they are
+
+typedef struct {
+    uint8_t fmt;                 // format of the last frame, state restarts on a change
+    uint8_t mic;                 // slot encoded last, 0 left 1 right; state restarts on a change too
+    uint32_t in_rate;            // capture, also AUDIO_FMT_RAW
+    uint32_t s16_rate;           // AUDIO_FMT_S16
+    resample_t s16;              // in_rate to s16_rate, unused when they are equal
+    resample_t to_8k;            // in_rate to CODEC_8K_RATE
+    int32_t predictor;           // IMA ADPCM
+    int8_t index;
+} codec_t;
+
+/* capture at in_rate, AUDIO_FMT_S16 at s16_rate (at most in_rate); both have to be one of the
+ * AUDIO_RATE_* rates. False for other rates or out of memory */
+bool codec_init(codec_t *c, uint32_t in_rate, uint32_t s16_rate);
+void codec_free(codec_t *c);
+
+/* bytes per captured sample frame, per log-mel frame for CODEC_SLOTS_MEL */
+static inline size_t codec_slot_frame(uint8_t slots)
+{
+    if (slots == CODEC_SLOTS_MEL) {
+        return MEL_FRAME_BYTES;
+    }
+    return slots == CODEC_SLOTS_STEREO ? CODEC_RAW_FRAME : CODEC_RAW_FRAME / 2;
+}
+
+/* encodes len bytes of capture in the slots layout (whole frames) as fmt into dst, which holds
+ * at least codec_max_len() of the frame count; returns the payload length. lang picks the mic
+ * of stereo capture. AUDIO_FMT_RAW is always two slots, a single mic goes out with the other
+ * slot zero */
+size_t codec_encode(codec_t *c, uint8_t fmt, uint8_t slots, uint8_t lang, const uint8_t *raw, size_t len,
+                    uint8_t *dst);
+
+static inline size_t codec_max_len(size_t frames)
+{
+    return frames * CODEC_RAW_FRAME + CODEC_ADPCM_HDR;
+}
+
+/* sample rate of fmt payloads, Hz */
+uint32_t codec_rate(const codec_t *c, uint8_t fmt);
+
+/* AUDIO_RATE_* of fmt payloads, for the header flags */
+uint8_t codec_rate_code(const codec_t *c, uint8_t fmt);
+
+/* payload bytes per ms of audio in fmt, ADPCM without its header */
+uint32_t codec_bytes_per_ms(const codec_t *c, uint8_t fmt);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,443 @@
+/* Eric Liu 2026
+
+Display flush path shared by both panels.
+
+esp_lvgl_port creates the LVGL displays and runs the LVGL task; this module takes
+over the flush callback so pixel conversion before esp_lcd_panel_draw_bitmap goes
+through app_pixel instead of LVGL's per-pixel software swap.
+
+Two paths per panel:
+- direct: RGB565 without tile diff. LVGL renders into the port's DMA buffers,
+  we swap in place and send. The buffer is handed back to LVGL from the
+  colour-done callback.
+- staged: L8 / I1 render formats and/or tile diff. The flush converts the area
+  stripe by stripe (swap, or palette expansion for L8/I1) into two DMA staging
+  buffers and sends each stripe while the next one is converted, so the render
+  buffer is free as soon as the callback returns. L8/I1 render into small
+  internal-RAM buffers owned here: captions are one colour on black, so nothing
+  is lost, and the buffers are 2x (L8) or 16x (I1) smaller than RGB565.
+
+Tile diff (optional, app_tile.c): the panel is split into tiles and we keep a
+32-bit hash of what each tile currently shows. Tiles completely covered by a
+flushed area are hashed from the render buffer and only sent when the hash
+changed; runs of changed tiles in a tile row go out as one transfer. Partly
+covered tiles are always sent and forgotten. Counters for tiles/bytes sent and
+skipped are kept per panel and logged periodically.
+
+Frame time is measured from the first flush callback of a frame until the
+last transfer of that frame has left the SPI bus, and logged with the counters.
+
+The panel IO colour-done callback is re-registered here as well, so this module
+is the only place that tells LVGL a buffer is free again.
+
+INPUTS: rendered areas from LVGL
+OUTPUTS: SPI transfers through esp_lcd
+
+*/
+
+#include "app_disp_flush.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+
+#include "app_pixel.h"
+#include "app_tile.h"
+
+#define DISP_FLUSH_STAGING_BUFS 2
+#define DISP_FLUSH_STATS_LOG_US (10 * 1000 * 1000)
+
+static const char *TAG = "disp_flush";
+
+typedef struct {
+    lv_display_t *disp;
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    bool swap_bytes;
+    lv_color_format_t cf;
+    /* staged path only */
+    bool staged;
+    uint8_t *render_buf[2];           // L8/I1 only, RGB565 keeps the port's buffers
+    size_t render_size;
+    uint16_t *staging[DISP_FLUSH_STAGING_BUFS];
+    uint32_t staging_lines;
+    uint8_t next_staging;
+    SemaphoreHandle_t staging_free;   // counts staging buffers not owned by the SPI driver
+    uint16_t palette[256];            // panel byte order
+    tile_map_t tiles;                 // tile diff only, hash NULL without it
+    disp_flush_stats_t stats;
+    disp_flush_stats_t stats_logged;
+    int64_t stats_log_us;
+    /* frame timing, the done callback closes the frame */
+    bool in_frame;
+    uint32_t frame_start_us;
+    uint32_t frame_end_start_us;      // start of the frame waiting for its last transfer
+    atomic_uint inflight;             // colour transfers queued and not done
+    atomic_bool frame_end_pending;    // last area queued, whoever clears this records the frame
+    disp_flush_frame_cb_t frame_cb;
+    void *frame_cb_arg;
+} disp_flush_ctx_t;
+
+/* runs in the done ISR or the LVGL task; 32-bit fields so the task never reads a torn value */
+static void disp_flush_frame_done(disp_flush_ctx_t *ctx)
+{
+    uint32_t us = (uint32_t)esp_timer_get_time() - ctx->frame_end_start_us;
+    ctx->stats.frames++;
+    ctx->stats.frame_us_sum += us;
+    if (us > ctx->stats.frame_us_max) {
+        ctx->stats.frame_us_max = us;
+    }
+}
+
+static bool disp_flush_io_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    disp_flush_ctx_t *ctx = (disp_flush_ctx_t *)user_ctx;
+    if (atomic_fetch_sub(&ctx->inflight, 1) == 1 && atomic_exchange(&ctx->frame_end_pending, false)) {
+        disp_flush_frame_done(ctx);
+    }
+    if (!ctx->staged) {
+        lv_display_flush_ready(ctx->disp);
+        return false;
+    }
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(ctx->staging_free, &woken);
+    return woken == pdTRUE;
+}
+
+static esp_err_t disp_flush_draw(disp_flush_ctx_t *ctx, int x1, int y1, int x2, int y2, const void *data)
+{
+    atomic_fetch_add(&ctx->inflight, 1);
+    esp_err_t ret = esp_lcd_panel_draw_bitmap(ctx->panel, x1, y1, x2, y2, data);
+    if (ret != ESP_OK) {
+        atomic_fetch_sub(&ctx->inflight, 1);
+    }
+    return ret;
+}
+
+static void disp_flush_direct(disp_flush_ctx_t *ctx, const lv_area_t *area, uint8_t *px_map)
+{
+    if (ctx->swap_bytes) {
+        pixel_rgb565_swap((uint16_t *)px_map, lv_area_get_size(area));
+    }
+    esp_err_t ret = disp_flush_draw(ctx, area->x1, area->y1, area->x2 + 1, area->y2 + 1, px_map);
+    if (ret != ESP_OK) {
+        /* nothing was queued, so the done callback will never fire for this area */
+        ESP_LOGE(TAG, "draw_bitmap failed: %s", esp_err_to_name(ret));
+        lv_display_flush_ready(ctx->disp);
+        return;
+    }
+    ctx->stats.bytes_sent += lv_area_get_size(area) * sizeof(uint16_t);
+}
+
+/* view of the render buffer for one flushed area */
+typedef struct {
+    disp_flush_ctx_t *ctx;
+    const uint8_t *px;
+    uint32_t stride;
+    const lv_area_t *area;
+} disp_flush_src_t;
+
+/* converts the area-relative rect (x, y, w, h) to panel RGB565 in one staging
+ * buffer and queues it; the staging buffer comes back through the done callback */
+static void disp_flush_emit(disp_flush_ctx_t *ctx, const disp_flush_src_t *src,
+                            int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    xSemaphoreTake(ctx->staging_free, portMAX_DELAY);
+    uint16_t *dst = ctx->staging[ctx->next_staging];
+    ctx->next_staging = (ctx->next_staging + 1) % DISP_FLUSH_STAGING_BUFS;
+
+    const uint8_t *row = src->px + (size_t)y * src->stride;
+    for (int32_t r = 0; r < h; r++) {
+        switch (ctx->cf) {
+        case LV_COLOR_FORMAT_I1:
+            pixel_expand_i1(dst + r * w, row, x, w, ctx->palette[0], ctx->palette[255]);
+            break;
+        case LV_COLOR_FORMAT_L8:
+            pixel_expand_l8(dst + r * w, row + x, w, ctx->palette);
+            break;
+        default:
+            memcpy(dst + r * w, row + x * sizeof(uint16_t), w * sizeof(uint16_t));
+            break;
+        }
+        row += src->stride;
+    }
+    if (ctx->cf == LV_COLOR_FORMAT_RGB565 && ctx->swap_bytes) {
+        pixel_rgb565_swap(dst, (size_t)w * h);
+    }
+
+    int32_t x1 = src->area->x1 + x;
+    int32_t y1 = src->area->y1 + y;
+    esp_err_t ret = disp_flush_draw(ctx, x1, y1, x1 + w, y1 + h, dst);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "draw_bitmap failed: %s", esp_err_to_name(ret));
+        xSemaphoreGive(ctx->staging_free);
+        return;
+    }
+    ctx->stats.bytes_sent += (uint64_t)w * h * sizeof(uint16_t);
+}
+
+/* tile_map_flush callback: a run of changed tiles */
+static void disp_flush_emit_run(void *arg, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    const disp_flush_src_t *src = (const disp_flush_src_t *)arg;
+    disp_flush_emit(src->ctx, src, x, y, w, h);
+}
+
+static void disp_flush_staged(disp_flush_ctx_t *ctx, const lv_area_t *area, uint8_t *px_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    const int32_t h = lv_area_get_height(area);
+
+    if (ctx->cf == LV_COLOR_FORMAT_I1) {
+        /* I1 buffers start with the 2 entry palette; we use our own */
+        px_map += LV_COLOR_INDEXED_PALETTE_SIZE(LV_COLOR_FORMAT_I1) * sizeof(lv_color32_t);
+    }
+    const disp_flush_src_t src = {
+        .ctx = ctx,
+        .px = px_map,
+        .stride = lv_draw_buf_width_to_stride(w, ctx->cf),
+        .area = area,
+    };
+
+    if (ctx->tiles.hash) {
+        const tile_src_t tile_src = {
+            .px = px_map,
+            .stride = src.stride,
+            .x1 = area->x1,
+            .y1 = area->y1,
+            .x2 = area->x2,
+            .y2 = area->y2,
+        };
+        tile_map_flush(&ctx->tiles, &tile_src, disp_flush_emit_run, (void *)&src);
+        ctx->stats.tiles_sent = ctx->tiles.tiles_sent;
+        ctx->stats.tiles_skipped = ctx->tiles.tiles_skipped;
+        ctx->stats.bytes_skipped = ctx->tiles.bytes_skipped;
+    } else {
+        for (int32_t y = 0; y < h; y += ctx->staging_lines) {
+            int32_t rows = LV_MIN(h - y, (int32_t)ctx->staging_lines);
+            disp_flush_emit(ctx, &src, 0, y, w, rows);
+        }
+    }
+    /* everything has been copied out of the render buffer */
+    lv_display_flush_ready(ctx->disp);
+}
+
+static void disp_flush_log_stats(disp_flush_ctx_t *ctx)
+{
+    int64_t now = esp_timer_get_time();
+    if (now - ctx->stats_log_us < DISP_FLUSH_STATS_LOG_US ||
+        memcmp(&ctx->stats, &ctx->stats_logged, sizeof(ctx->stats)) == 0) {
+        return;
+    }
+    const disp_flush_stats_t cur = ctx->stats;
+    const disp_flush_stats_t *prev = &ctx->stats_logged;
+    uint32_t frames = cur.frames - prev->frames;
+    uint32_t avg_us = frames ? (cur.frame_us_sum - prev->frame_us_sum) / frames : 0;
+    ESP_LOGI(TAG, "%p frames %lu, flush avg %lu us max %lu us, bytes sent %llu", ctx->panel,
+             (unsigned long)frames, (unsigned long)avg_us, (unsigned long)cur.frame_us_max,
+             (unsigned long long)cur.bytes_sent);
+    if (ctx->tiles.hash) {
+        ESP_LOGI(TAG, "%p tiles sent %lu skipped %lu, bytes saved %llu", ctx->panel,
+                 (unsigned long)cur.tiles_sent, (unsigned long)cur.tiles_skipped,
+                 (unsigned long long)cur.bytes_skipped);
+    }
+    ctx->stats_log_us = now;
+    ctx->stats_logged = cur;
+}
+
+static void disp_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    disp_flush_ctx_t *ctx = (disp_flush_ctx_t *)lv_display_get_user_data(disp);
+    if (!ctx->in_frame) {
+        ctx->in_frame = true;
+        ctx->frame_start_us = (uint32_t)esp_timer_get_time();
+    }
+    if (ctx->staged) {
+        disp_flush_staged(ctx, area, px_map);
+    } else {
+        disp_flush_direct(ctx, area, px_map);
+    }
+    if (lv_display_flush_is_last(disp)) {
+        ctx->in_frame = false;
+        ctx->frame_end_start_us = ctx->frame_start_us;
+        atomic_store(&ctx->frame_end_pending, true);
+        /* everything may already be on the panel (skipped tiles, fast bus) */
+        if (atomic_load(&ctx->inflight) == 0 && atomic_exchange(&ctx->frame_end_pending, false)) {
+            disp_flush_frame_done(ctx);
+        }
+        if (ctx->frame_cb) {
+            ctx->frame_cb(disp, ctx->frame_cb_arg);
+        }
+        disp_flush_log_stats(ctx);
+    }
+}
+
+/* palette[i] is the panel colour for L8 value i; I1 uses entries 0 and 255.
+ * LVGL stores the luminance of the text colour in L8, so full coverage of fg
+ * maps to lum(fg), not 255; scale the ramp so that value expands back to fg */
+static void disp_flush_build_palette(disp_flush_ctx_t *ctx, lv_color_t fg, lv_color_t bg)
+{
+    uint8_t alpha[256];
+    uint32_t fg_lum = lv_color_luminance(fg);
+    if (fg_lum == 0) {
+        fg_lum = 255;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t a = (i >= fg_lum) ? 255 : (i * 255) / fg_lum;
+        alpha[i] = (uint8_t)a;
+    }
+    pixel_rgb565_fill(ctx->palette, 256, lv_color_to_u16(bg));
+    pixel_rgb565_blend(ctx->palette, alpha, 256, lv_color_to_u16(fg));
+    if (ctx->swap_bytes) {
+        pixel_rgb565_swap(ctx->palette, 256);
+    }
+}
+
+static void disp_flush_free(disp_flush_ctx_t *ctx)
+{
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(ctx->render_buf[i]);
+    }
+    for (int i = 0; i < DISP_FLUSH_STAGING_BUFS; i++) {
+        heap_caps_free(ctx->staging[i]);
+    }
+    if (ctx->staging_free) {
+        vSemaphoreDelete(ctx->staging_free);
+    }
+    tile_map_free(&ctx->tiles);
+    free(ctx);
+}
+
+static esp_err_t disp_flush_setup_staged(disp_flush_ctx_t *ctx, const disp_flush_cfg_t *cfg)
+{
+    const int32_t hres = lv_display_get_horizontal_resolution(ctx->disp);
+    const int32_t vres = lv_display_get_vertical_resolution(ctx->disp);
+
+    ctx->staged = true;
+    ctx->staging_lines = cfg->staging_lines ? cfg->staging_lines : 1;
+
+    if (cfg->tile_diff) {
+        const uint8_t bpp = ctx->cf == LV_COLOR_FORMAT_I1 ? 1 : ctx->cf == LV_COLOR_FORMAT_L8 ? 8 : 16;
+        ESP_RETURN_ON_FALSE(tile_map_init(&ctx->tiles, (uint16_t)hres, (uint16_t)vres, cfg->tile_size, bpp),
+                            ESP_ERR_NO_MEM, TAG, "no mem for tile hashes");
+        /* a changed run is at most one tile row high */
+        if (ctx->staging_lines < ctx->tiles.size) {
+            ctx->staging_lines = ctx->tiles.size;
+        }
+    }
+
+    if (ctx->cf != LV_COLOR_FORMAT_RGB565) {
+        const size_t render_size = LV_DRAW_BUF_SIZE(hres, cfg->render_lines, ctx->cf);
+        for (int i = 0; i < (cfg->render_double ? 2 : 1); i++) {
+            ctx->render_buf[i] = heap_caps_malloc(render_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            ESP_RETURN_ON_FALSE(ctx->render_buf[i], ESP_ERR_NO_MEM, TAG, "no mem for render buffer");
+        }
+        ctx->render_size = render_size;
+        disp_flush_build_palette(ctx, cfg->fg, cfg->bg);
+    }
+
+    const size_t staging_size = (size_t)hres * ctx->staging_lines * sizeof(uint16_t);
+    for (int i = 0; i < DISP_FLUSH_STAGING_BUFS; i++) {
+        ctx->staging[i] = heap_caps_aligned_alloc(16, staging_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_RETURN_ON_FALSE(ctx->staging[i], ESP_ERR_NO_MEM, TAG, "no mem for staging buffer");
+    }
+    ctx->staging_free = xSemaphoreCreateCounting(DISP_FLUSH_STAGING_BUFS, DISP_FLUSH_STAGING_BUFS);
+    ESP_RETURN_ON_FALSE(ctx->staging_free, ESP_ERR_NO_MEM, TAG, "no mem for staging semaphore");
+
+    ESP_LOGI(TAG, "staged flush: cf %d, render %u bytes x %d, staging %u lines, tiles %ux%u",
+             (int)ctx->cf, (unsigned)ctx->render_size, cfg->render_double ? 2 : 1,
+             (unsigned)ctx->staging_lines, ctx->tiles.tiles_x, ctx->tiles.tiles_y);
+    return ESP_OK;
+}
+
+esp_err_t disp_flush_attach(lv_display_t *disp, const disp_flush_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(disp && cfg && cfg->io && cfg->panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(cfg->render_cf == LV_COLOR_FORMAT_RGB565 || cfg->render_cf == LV_COLOR_FORMAT_L8 ||
+                        cfg->render_cf == LV_COLOR_FORMAT_I1, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported render format");
+
+    disp_flush_ctx_t *ctx = (disp_flush_ctx_t *)calloc(1, sizeof(disp_flush_ctx_t));
+    ESP_RETURN_ON_FALSE(ctx, ESP_ERR_NO_MEM, TAG, "no mem for flush ctx");
+    ctx->disp = disp;
+    ctx->io = cfg->io;
+    ctx->panel = cfg->panel;
+    ctx->swap_bytes = cfg->swap_bytes;
+    ctx->cf = cfg->render_cf;
+
+    esp_err_t ret = ESP_OK;
+    if (ctx->cf != LV_COLOR_FORMAT_RGB565 || cfg->tile_diff) {
+        ESP_GOTO_ON_ERROR(disp_flush_setup_staged(ctx, cfg), err, TAG, "staged flush setup failed");
+    }
+
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = disp_flush_io_done,
+    };
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_io_register_event_callbacks(ctx->io, &cbs, ctx), err, TAG,
+                      "register io callbacks failed");
+
+    /* nothing can fail past this point */
+    lv_display_set_color_format(disp, ctx->cf);
+    if (ctx->render_buf[0]) {
+        lv_display_set_buffers(disp, ctx->render_buf[0], ctx->render_buf[1], ctx->render_size,
+                               LV_DISPLAY_RENDER_MODE_PARTIAL);
+    }
+    lv_display_set_user_data(disp, ctx);
+    lv_display_set_flush_cb(disp, disp_flush_cb);
+    ESP_LOGD(TAG, "flush path attached, swap_bytes=%d cf=%d", ctx->swap_bytes, (int)ctx->cf);
+    return ESP_OK;
+
+err:
+    disp_flush_free(ctx);
+    return ret;
+}
+
+void disp_flush_detach(lv_display_t *disp)
+{
+    if (!disp) {
+        return;
+    }
+    disp_flush_ctx_t *ctx = (disp_flush_ctx_t *)lv_display_get_user_data(disp);
+    if (!ctx) {
+        return;
+    }
+    const esp_lcd_panel_io_callbacks_t cbs = { 0 };
+    esp_lcd_panel_io_register_event_callbacks(ctx->io, &cbs, NULL);
+    lv_display_set_user_data(disp, NULL);
+    disp_flush_free(ctx);
+}
+
+void disp_flush_invalidate_tiles(lv_display_t *disp)
+{
+    disp_flush_ctx_t *ctx = disp ? (disp_flush_ctx_t *)lv_display_get_user_data(disp) : NULL;
+    if (ctx) {
+        tile_map_invalidate(&ctx->tiles);
+    }
+}
+
+esp_err_t disp_flush_set_frame_cb(lv_display_t *disp, disp_flush_frame_cb_t cb, void *arg)
+{
+    disp_flush_ctx_t *ctx = disp ? (disp_flush_ctx_t *)lv_display_get_user_data(disp) : NULL;
+    ESP_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_STATE, TAG, "flush path not attached");
+    ctx->frame_cb = cb;
+    ctx->frame_cb_arg = arg;
+    return ESP_OK;
+}
+
+bool disp_flush_get_stats(lv_display_t *disp, disp_flush_stats_t *out)
+{
+    disp_flush_ctx_t *ctx = disp ? (disp_flush_ctx_t *)lv_display_get_user_data(disp) : NULL;
+    if (!ctx || !out) {
+        return false;
+    }
+    *out = ctx->stats;
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "lvgl.h"
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    bool swap_bytes;             // panel expects RGB565 MSB first
+    /* render format. RGB565 renders straight into the esp_lvgl_port DMA buffers.
+     * L8 and I1 render into buffers owned by this module and are expanded to RGB565
+     * through a fg/bg palette while being copied into small DMA staging stripes */
+    lv_color_format_t render_cf;
+    uint32_t render_lines;       // L8/I1: height of each render buffer
+    bool render_double;          // L8/I1: two render buffers
+    uint32_t staging_lines;      // L8/I1/tile diff: height of each DMA staging stripe
+    lv_color_t fg;               // L8/I1: caption colour
+    lv_color_t bg;               // L8/I1: background colour
+    /* tile diff: only send tiles whose content changed since they were last sent.
+     * Forces the staged path for RGB565 too; staging_lines is raised to tile_size */
+    bool tile_diff;
+    uint16_t tile_size;          // tile edge in pixels
+} disp_flush_cfg_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t frame_us_sum;       // first flush callback to last transfer done, wraps
+    uint32_t frame_us_max;
+    uint32_t tiles_sent;
+    uint32_t tiles_skipped;
+    uint64_t bytes_sent;
+    uint64_t bytes_skipped;
+} disp_flush_stats_t;
+
+/* replaces the esp_lvgl_port flush callback of disp with ours; call right after lvgl_port_add_disp */
+esp_err_t disp_flush_attach(lv_display_t *disp, const disp_flush_cfg_t *cfg);
+void disp_flush_detach(lv_display_t *disp);
+
+/* forget what the panel shows, the next flush of every tile is sent.
+ * Call with the LVGL lock held after anything that changes panel memory behind LVGL's back */
+void disp_flush_invalidate_tiles(lv_display_t *disp);
+
+/* called from the LVGL task after the last area of each frame has been queued */
+typedef void (*disp_flush_frame_cb_t)(lv_display_t *disp, void *arg);
+esp_err_t disp_flush_set_frame_cb(lv_display_t *disp, disp_flush_frame_cb_t cb, void *arg);
+
+/* copies the running counters; false if disp has no flush path attached */
+bool disp_flush_get_stats(lv_display_t *disp, disp_flush_stats_t *out);
@@ -0,0 +1,171 @@
+/* Eric Liu 2026
+
+Scrolling transcript on the panel's vertical scroll area (VSCRDEF / VSCRSADD).
+
+The caption band is split into one slot per line, each a label at a fixed row
+in LVGL coordinates, so LVGL coordinates stay equal to panel frame memory and
+LVGL (and the flush tile hashes) never have to know the panel is scrolled. A
+new line is written into the slot that holds the line leaving the top, and the
+scroll start address is moved by one slot, so each line costs one line band of
+SPI traffic instead of a redraw of the whole text area.
+
+Rows above and below the band are the top and bottom fixed areas, which keeps
+the status bar on screen 1 in place. The start address goes out from the flush
+path after the last area of the frame, so the panel scrolls together with the
+new slot content.
+
+Vertical scroll moves physical gate lines. With swap_xy those run across the
+text, so such panels are refused and the caller keeps the textarea.
+
+INPUTS: caption lines from display_task
+OUTPUTS: slot labels, VSCRDEF/VSCRSADD commands
+
+*/
+
+#include "app_disp_scroll.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_lcd_panel_io.h"
+
+#include "app_disp_flush.h"
+
+#define LCD_CMD_VSCRDEF  0x33
+#define LCD_CMD_VSCRSADD 0x37
+
+static const char *TAG = "disp_scroll";
+
+struct disp_scroll_t {
+    esp_lcd_panel_io_handle_t io;
+    lv_obj_t **slots;
+    int lines;
+    int32_t line_h;
+    int head;                    // slot shown at the top of the band
+    uint16_t tfa;                // frame memory rows, after mirror_y
+    uint16_t vsa;
+    bool mirror_y;
+    bool pending;                // start address changed since it was last sent
+};
+
+static esp_err_t disp_scroll_tx16(esp_lcd_panel_io_handle_t io, int cmd, const uint16_t *vals, int count)
+{
+    uint8_t buf[6];
+    for (int i = 0; i < count; i++) {
+        buf[i * 2] = (uint8_t)(vals[i] >> 8);
+        buf[i * 2 + 1] = (uint8_t)vals[i];
+    }
+    return esp_lcd_panel_io_tx_param(io, cmd, buf, count * 2);
+}
+
+/* first frame memory row of the scroll area shown on the panel, for the current head.
+ * With MY set memory rows run bottom to top on screen, so the offset goes the other way */
+static uint16_t disp_scroll_start(const disp_scroll_t *scroll)
+{
+    uint32_t off = (uint32_t)scroll->head * scroll->line_h;
+    if (scroll->mirror_y) {
+        off = (scroll->vsa - off) % scroll->vsa;
+    }
+    return (uint16_t)(scroll->tfa + off);
+}
+
+/* runs in the LVGL task after the last area of a frame was queued; the panel IO
+ * sends parameters only after queued colour transfers, so the new slot is in place */
+static void disp_scroll_frame_done(lv_display_t *disp, void *arg)
+{
+    disp_scroll_t *scroll = (disp_scroll_t *)arg;
+    if (!scroll->pending) {
+        return;
+    }
+    scroll->pending = false;
+    const uint16_t ssa = disp_scroll_start(scroll);
+    esp_err_t ret = disp_scroll_tx16(scroll->io, LCD_CMD_VSCRSADD, &ssa, 1);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "VSCRSADD failed: %s", esp_err_to_name(ret));
+    }
+}
+
+esp_err_t disp_scroll_create(lv_display_t *disp, const disp_scroll_cfg_t *cfg, disp_scroll_t **out)
+{
+    ESP_RETURN_ON_FALSE(disp && cfg && cfg->io && cfg->parent && out, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(cfg->lines > 0 && cfg->line_h > 0, ESP_ERR_INVALID_ARG, TAG, "invalid band");
+    ESP_RETURN_ON_FALSE(!cfg->swap_xy, ESP_ERR_NOT_SUPPORTED, TAG, "scroll axis is horizontal with swap_xy");
+    const uint32_t vsa = (uint32_t)cfg->lines * cfg->line_h;
+    ESP_RETURN_ON_FALSE(cfg->y >= 0 && cfg->y + vsa <= cfg->mem_lines, ESP_ERR_INVALID_SIZE, TAG,
+                        "band rows %ld..%lu outside frame memory", (long)cfg->y, (unsigned long)(cfg->y + vsa));
+
+    disp_scroll_t *scroll = (disp_scroll_t *)calloc(1, sizeof(disp_scroll_t));
+    ESP_RETURN_ON_FALSE(scroll, ESP_ERR_NO_MEM, TAG, "no mem for scroll");
+    scroll->slots = (lv_obj_t **)calloc(cfg->lines, sizeof(lv_obj_t *));
+    if (!scroll->slots) {
+        free(scroll);
+        return ESP_ERR_NO_MEM;
+    }
+    scroll->io = cfg->io;
+    scroll->lines = cfg->lines;
+    scroll->line_h = cfg->line_h;
+    scroll->vsa = (uint16_t)vsa;
+    scroll->mirror_y = cfg->mirror_y;
+    /* fixed areas are counted in frame memory rows, which run the other way with MY */
+    uint16_t top = (uint16_t)cfg->y;
+    uint16_t bottom = (uint16_t)(cfg->mem_lines - cfg->y - vsa);
+    scroll->tfa = cfg->mirror_y ? bottom : top;
+
+    esp_err_t ret = ESP_OK;
+    const uint16_t def[3] = { scroll->tfa, scroll->vsa, cfg->mirror_y ? top : bottom };
+    ESP_GOTO_ON_ERROR(disp_scroll_tx16(scroll->io, LCD_CMD_VSCRDEF, def, 3), err, TAG, "VSCRDEF failed");
+    const uint16_t ssa = disp_scroll_start(scroll);
+    ESP_GOTO_ON_ERROR(disp_scroll_tx16(scroll->io, LCD_CMD_VSCRSADD, &ssa, 1), err, TAG, "VSCRSADD failed");
+    ESP_GOTO_ON_ERROR(disp_flush_set_frame_cb(disp, disp_scroll_frame_done, scroll), err, TAG,
+                      "no flush path on this display");
+
+    for (int i = 0; i < cfg->lines; i++) {
+        lv_obj_t *slot = lv_label_create(cfg->parent);
+        lv_label_set_long_mode(slot, LV_LABEL_LONG_MODE_CLIP);
+        lv_label_set_text(slot, "");
+        lv_obj_set_size(slot, cfg->w, cfg->line_h);
+        lv_obj_set_pos(slot, cfg->x, cfg->y + i * cfg->line_h);
+        lv_obj_set_style_text_font(slot, cfg->font, 0);
+        lv_obj_set_style_text_color(slot, cfg->color, 0);
+        lv_obj_set_style_text_outline_stroke_color(slot, cfg->color, 0);
+        lv_obj_set_style_text_outline_stroke_opa(slot, LV_OPA_COVER, 0);
+        lv_obj_set_style_text_outline_stroke_width(slot, 1, 0);
+        scroll->slots[i] = slot;
+    }
+    ESP_LOGI(TAG, "scroll area tfa %u vsa %u, %d lines of %ld px", scroll->tfa, scroll->vsa,
+             scroll->lines, (long)scroll->line_h);
+    *out = scroll;
+    return ESP_OK;
+
+err:
+    /* back to the whole panel as one scroll area at offset 0, i.e. no scrolling */
+    disp_scroll_tx16(scroll->io, LCD_CMD_VSCRDEF, (const uint16_t[]) { 0, (uint16_t)cfg->mem_lines, 0 }, 3);
+    disp_scroll_tx16(scroll->io, LCD_CMD_VSCRSADD, (const uint16_t[]) { 0 }, 1);
+    free(scroll->slots);
+    free(scroll);
+    return ret;
+}
+
+void disp_scroll_push(disp_scroll_t *scroll, int count)
+{
+    if (!scroll || count <= 0) {
+        return;
+    }
+    scroll->head = (scroll->head + count) % scroll->lines;
+    scroll->pending = true;
+    /* make sure a frame gets flushed even if the new bottom line matches the old top one */
+    lv_obj_invalidate(scroll->slots[(scroll->head + scroll->lines - 1) % scroll->lines]);
+}
+
+void disp_scroll_set_line(disp_scroll_t *scroll, int row, const char *text)
+{
+    if (!scroll || row < 0 || row >= scroll->lines) {
+        return;
+    }
+    lv_obj_t *slot = scroll->slots[(scroll->head + row) % scroll->lines];
+    if (strcmp(lv_label_get_text(slot), text) != 0) {
+        lv_label_set_text(slot, text);
+    }
+}
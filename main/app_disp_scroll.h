@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "lvgl.h"
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io;
+    lv_obj_t *parent;            // screen the caption slots are created on
+    int32_t x;                   // caption band in LVGL coordinates
+    int32_t y;                   // rows [y, y + lines * line_h) scroll, everything else is fixed
+    int32_t w;
+    int lines;                   // number of caption lines (ring slots)
+    int32_t line_h;
+    uint32_t mem_lines;          // frame memory lines of the controller, TFA + VSA + BFA
+    bool swap_xy;                // rotation as applied to the panel
+    bool mirror_y;
+    const lv_font_t *font;
+    lv_color_t color;
+} disp_scroll_cfg_t;
+
+typedef struct disp_scroll_t disp_scroll_t;
+
+/* defines the panel scroll area and creates one label per caption line.
+ * Returns ESP_ERR_NOT_SUPPORTED if the panel's scroll axis is not vertical on screen (swap_xy).
+ * Call with the LVGL lock held, after disp_flush_attach */
+esp_err_t disp_scroll_create(lv_display_t *disp, const disp_scroll_cfg_t *cfg, disp_scroll_t **out);
+
+/* moves the transcript up by count lines; takes effect with the next flush */
+void disp_scroll_push(disp_scroll_t *scroll, int count);
+
+/* sets the text of caption row row (0 = top) */
+void disp_scroll_set_line(disp_scroll_t *scroll, int row, const char *text);
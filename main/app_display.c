@@ -13,12 +13,17 @@ Outputs: None
 #include "app_tcp.h"
 #include "app_wifi.h"
 #include "app_gpio.h"
+#include "app_pixel.h"
+#include "app_disp_flush.h"
+#include "app_disp_scroll.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "esp_err.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -61,11 +66,15 @@ static const char *TAG = "display_task";
 /* LCD one and two specific definitions */
 #define LCD_H_RES 240
 #define LCD_V_RES 240
-#define LCD_DRAW_BUF_HEIGHT 40
+#define LCD_DRAW_BUF_HEIGHT CONFIG_APP_DISP1_DRAW_BUF_LINES
 #define LCD_DRAW_BUF_DOUBLE 1
 #define LCD_CMD_BITS 8
 #define LCD_PARAM_BITS 8
 #define LCD_BITS_PER_PIXEL 16
+#define SCREEN1_SWAP_BYTES true
+#define SCREEN1_SWAP_XY true
+#define SCREEN1_MIRROR_X false
+#define SCREEN1_MIRROR_Y true
 /*--------------------------------------*/
 #define LCD_H_RES_2 480
 #define LCD_V_RES_2 128
@@ -73,15 +82,75 @@ static const char *TAG = "display_task";
 #define LCD_CMD_BITS_2 8
 #define LCD_PARAM_BITS_2 8
 #define LCD_BITS_PER_PIXEL_2 16
-#define LCD_DRAW_BUF_HEIGHT_2 4
+#define LCD_DRAW_BUF_HEIGHT_2 CONFIG_APP_DISP2_DRAW_BUF_LINES
 #define SCREEN2_SWAP_BYTES true
+#define SCREEN2_SWAP_XY false
+#define SCREEN2_MIRROR_X true
+#define SCREEN2_MIRROR_Y true
 #define SCREEN2_LVGL_DMA true
 /*--------------------------------------*/
+#define SCREEN1_TEXT_COLOR 0x00FF00
+#define SCREEN2_TEXT_COLOR 0xFFFFFF
+
+#if CONFIG_APP_DISP1_RENDER_L8
+#define SCREEN1_RENDER_CF LV_COLOR_FORMAT_L8
+#elif CONFIG_APP_DISP1_RENDER_I1
+#define SCREEN1_RENDER_CF LV_COLOR_FORMAT_I1
+#else
+#define SCREEN1_RENDER_CF LV_COLOR_FORMAT_RGB565
+#endif
+
+#if CONFIG_APP_DISP2_RENDER_L8
+#define SCREEN2_RENDER_CF LV_COLOR_FORMAT_L8
+#elif CONFIG_APP_DISP2_RENDER_I1
+#define SCREEN2_RENDER_CF LV_COLOR_FORMAT_I1
+#else
+#define SCREEN2_RENDER_CF LV_COLOR_FORMAT_RGB565
+#endif
+
+/* RGB565 screens render straight into the esp_lvgl_port DMA buffers. L8/I1 screens
+ * render into buffers owned by app_disp_flush, so the port only gets a 1 line
+ * placeholder, and what hits the SPI bus is one staging stripe at a time */
+#define SCREEN1_PORT_BUF_LINES ((SCREEN1_RENDER_CF == LV_COLOR_FORMAT_RGB565) ? LCD_DRAW_BUF_HEIGHT : 1)
+#define SCREEN2_PORT_BUF_LINES ((SCREEN2_RENDER_CF == LV_COLOR_FORMAT_RGB565) ? LCD_DRAW_BUF_HEIGHT_2 : 1)
+#if CONFIG_APP_DISP_TILE_DIFF
+#define LCD_TILE_DIFF true
+#define LCD_TILE_SIZE CONFIG_APP_DISP_TILE_SIZE
+/* tile diff sends every screen through staging, at least one tile row per transfer */
+#define LCD_STAGING_LINES ((CONFIG_APP_DISP_STAGING_LINES > LCD_TILE_SIZE) ? CONFIG_APP_DISP_STAGING_LINES : LCD_TILE_SIZE)
+#define SCREEN1_MAX_TRANS_LINES LCD_STAGING_LINES
+#define SCREEN2_MAX_TRANS_LINES LCD_STAGING_LINES
+#else
+#define LCD_TILE_DIFF false
+#define LCD_TILE_SIZE 0
+#define LCD_STAGING_LINES CONFIG_APP_DISP_STAGING_LINES
+#define SCREEN1_MAX_TRANS_LINES ((SCREEN1_RENDER_CF == LV_COLOR_FORMAT_RGB565) ? LCD_DRAW_BUF_HEIGHT : LCD_STAGING_LINES)
+#define SCREEN2_MAX_TRANS_LINES ((SCREEN2_RENDER_CF == LV_COLOR_FORMAT_RGB565) ? LCD_DRAW_BUF_HEIGHT_2 : LCD_STAGING_LINES)
+#endif
+#define LCD_MAX_TRANS_PIXELS_1 (LCD_H_RES * SCREEN1_MAX_TRANS_LINES)
+#define LCD_MAX_TRANS_PIXELS_2 (LCD_H_RES_2 * SCREEN2_MAX_TRANS_LINES)
+#define LCD_MAX_TRANS_PIXELS ((LCD_MAX_TRANS_PIXELS_1 > LCD_MAX_TRANS_PIXELS_2) ? LCD_MAX_TRANS_PIXELS_1 : LCD_MAX_TRANS_PIXELS_2)
+/*--------------------------------------*/
+#define LOG_LINE_SIZE 128 // bytes of one wrapped line
 #define DISPLAY_MAX_LINES 16
 #define DISPLAY_LINE_MAX_AGE_MS 10000
 /*--------------------------------------*/
 #define DISPLAY_MAX_LINES_2 8
 #define DISPLAY_LINE_MAX_AGE_MS_2 10000
+/*--------------------------------------*/
+#define DISPLAY_NOTIFY_TEXT (1U << 0)
+#define DISPLAY_NOTIFY_STATUS (1U << 1)
+#define DISPLAY_DRAIN_MAX 16
+#define DISPLAY_LATENCY_LOG_US (10 * 1000 * 1000)
+#define DISPLAY_BURST_TEST_MSGS 8
+#if CONFIG_APP_DISP_BURST_TEST
+#define DISPLAY_BURST_TEST true
+#else
+#define DISPLAY_BURST_TEST false
+#endif
+#define DISPLAY_RSSI_HYST_DB 2
+#define DISPLAY_REFR_HOLD_MS 300        // keep LVGL refreshing this long after the last change
+#define DISPLAY_LVGL_MAX_SLEEP_MS 1000  // LVGL task sleep while the refresh timers are parked
 
 /* lcd panel Ios */
 
@@ -95,6 +164,7 @@ static esp_lcd_panel_handle_t panel_handle_2 = NULL;
 
 static lv_display_t *lvgl_disp = NULL;
 static lv_display_t *lvgl_disp_2 = NULL;
+static TaskHandle_t display_task_handle = NULL;
 
 static void screen2_fill_color(uint16_t color);
 
@@ -208,9 +278,7 @@ static void screen1_fill_color(uint16_t color)
     if (!panel_handle || LCD_H_RES <= 0 || LCD_V_RES <= 0) {
         return;
     }
-    for (int x = 0; x < LCD_H_RES; x++) {
-        line[x] = color;
-    }
+    pixel_rgb565_fill(line, LCD_H_RES, color);
     for (int y = 0; y < LCD_V_RES; y++) {
         esp_lcd_panel_draw_bitmap(panel_handle, 0, y, LCD_H_RES, y + 1, line);
     }
@@ -223,9 +291,7 @@ static void screen2_fill_color(uint16_t color)
         ESP_LOGW(TAG, "screen2_fill_color skipped: panel_handle_2=%p", panel_handle_2);
         return;
     }
-    for (int x = 0; x < LCD_H_RES_2; x++) {
-        line[x] = color;
-    }
+    pixel_rgb565_fill(line, LCD_H_RES_2, color);
     int err_count = 0;
     for (int y = 0; y < LCD_V_RES_2; y++) {
         esp_err_t ret = esp_lcd_panel_draw_bitmap(panel_handle_2, 0, y, LCD_H_RES_2, y + 1, line);
@@ -243,7 +309,7 @@ static void screen2_fill_color(uint16_t color)
 
 typedef struct {
     TickType_t ts;
-    char text[TEXT_BUF_SIZE + 1];
+    char text[LOG_LINE_SIZE + 1];
 } log_line_t;
 
 /* terminal line style rendering -> pad all space on top so new lines appear bottom */
@@ -266,7 +332,7 @@ static void rebuild_log_textarea(lv_obj_t *log_area, const log_line_t *lines, in
     }
 
     for (int i = 0; i < line_count && remaining > 0; i++) {
-        size_t len = strnlen(lines[i].text, TEXT_BUF_SIZE);
+        size_t len = strnlen(lines[i].text, LOG_LINE_SIZE);
         if (len > remaining) {
             len = remaining;
         }
@@ -297,60 +363,66 @@ static void drop_oldest_line(log_line_t *lines, int *line_count)
     (*line_count)--;
 }
 
-/* removes expired lines from the log; lifetime is defined by DISPLAY_LINE_MAX_AGE_MS */
-static void prune_expired_lines(log_line_t *lines, int *line_count, TickType_t now)
+/* removes expired lines from the log; lifetime is per screen */
+static void prune_expired_lines_with_age(log_line_t *lines, int *line_count, TickType_t now,
+                                         TickType_t max_age_ticks)
 {
     while (*line_count > 0 &&
-           (now - lines[0].ts) > pdMS_TO_TICKS(DISPLAY_LINE_MAX_AGE_MS)) {
+           (now - lines[0].ts) > max_age_ticks) {
         drop_oldest_line(lines, line_count);
     }
 }
 
-static void prune_expired_lines_with_age(log_line_t *lines, int *line_count, TickType_t now,
-                                         TickType_t max_age_ticks)
+/* appends text[0, len) as one line, leading spaces dropped; returns lines added (0 or 1) */
+static int push_line(log_line_t *lines, int *line_count, int max_lines, const char *text, size_t len,
+                     TickType_t ts)
 {
-    while (*line_count > 0 &&
-           (now - lines[0].ts) > max_age_ticks) {
+    while (len > 0 && *text == ' ') {
+        text++;
+        len--;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    while (*line_count >= max_lines) {
         drop_oldest_line(lines, line_count);
     }
+    lines[*line_count].ts = ts;
+    size_t copy_len = (len > LOG_LINE_SIZE) ? LOG_LINE_SIZE : len;
+    memcpy(lines[*line_count].text, text, copy_len);
+    lines[*line_count].text[copy_len] = '\0';
+    (*line_count)++;
+    return 1;
 }
 
 /* splits incoming log transcript to what fits, invokes functions to trim if needed     */
-static void add_wrapped_lines(log_line_t *lines, int *line_count, int max_lines,
-                              const char *text, TickType_t ts, const lv_font_t *font,
-                              int32_t max_width, int32_t letter_space)
+/* walks UTF-8 letters so multi-byte characters are measured and never split          */
+/* text must be NUL terminated at len; returns the number of lines added               */
+static int add_wrapped_lines(log_line_t *lines, int *line_count, int max_lines,
+                             const char *text, size_t len, TickType_t ts, const lv_font_t *font,
+                             int32_t max_width, int32_t letter_space)
 {
-    size_t len = strnlen(text, TEXT_BUF_SIZE);
+    uint32_t i = 0;
     size_t line_start = 0;
     int32_t line_width = 0;
     size_t line_len = 0;
+    int added = 0;
 
     if (max_width < 1) {
         max_width = 1;
     }
 
-    for (size_t i = 0; i < len; i++) {
-        uint32_t letter = (uint8_t)text[i];
-        uint32_t next = (i + 1 < len) ? (uint8_t)text[i + 1] : 0;
+    while (i < len) {
+        uint32_t letter_start = i;
+        uint32_t letter = lv_text_encoded_next(text, &i);
+        uint32_t next_i = i;
+        uint32_t next = (i < len) ? lv_text_encoded_next(text, &next_i) : 0;
         int32_t glyph_width = lv_font_get_glyph_width(font, letter, next);
         int32_t next_width = line_width + glyph_width;
 
-        if (line_len > 0 && next_width > max_width) {
-            while (line_start < i && text[line_start] == ' ') {
-                line_start++;
-            }
-            size_t seg_len = i - line_start;
-            if (seg_len > 0) {
-                while (*line_count >= max_lines) {
-                    drop_oldest_line(lines, line_count);
-                }
-                lines[*line_count].ts = ts;
-                size_t copy_len = (seg_len > TEXT_BUF_SIZE) ? TEXT_BUF_SIZE : seg_len;
-                memcpy(lines[*line_count].text, text + line_start, copy_len);
-                lines[*line_count].text[copy_len] = '\0';
-                (*line_count)++;
-            }
-            line_start = i;
+        if (line_len > 0 && (next_width > max_width || i - line_start > LOG_LINE_SIZE)) {
+            added += push_line(lines, line_count, max_lines, text + line_start, letter_start - line_start, ts);
+            line_start = letter_start;
             line_width = 0;
             line_len = 0;
         }
@@ -360,20 +432,24 @@ static void add_wrapped_lines(log_line_t *lines, int *line_count, int max_lines,
     }
 
     if (line_len > 0) {
-        while (line_start < len && text[line_start] == ' ') {
-            line_start++;
-        }
-        if (line_start < len) {
-            size_t seg_len = len - line_start;
-            while (*line_count >= max_lines) {
-                drop_oldest_line(lines, line_count);
-            }
-            lines[*line_count].ts = ts;
-            size_t copy_len = (seg_len > TEXT_BUF_SIZE) ? TEXT_BUF_SIZE : seg_len;
-            memcpy(lines[*line_count].text, text + line_start, copy_len);
-            lines[*line_count].text[copy_len] = '\0';
-            (*line_count)++;
-        }
+        added += push_line(lines, line_count, max_lines, text + line_start, len - line_start, ts);
+    }
+    return added;
+}
+
+/* pushes the log to whichever view the screen uses; added = lines appended since the last call.
+ * The scroll view shows the same bottom aligned layout as the textarea, one slot per row */
+static void show_log(lv_obj_t *log_area, disp_scroll_t *scroll, const log_line_t *lines,
+                     int line_count, int max_lines, int added)
+{
+    if (!scroll) {
+        rebuild_log_textarea(log_area, lines, line_count, max_lines);
+        return;
+    }
+    disp_scroll_push(scroll, added);
+    int padding_lines = max_lines - line_count;
+    for (int row = 0; row < max_lines; row++) {
+        disp_scroll_set_line(scroll, row, (row < padding_lines) ? "" : lines[row - padding_lines].text);
     }
 }
 
@@ -392,7 +468,7 @@ esp_err_t app_lcd_init(void)
         .sclk_io_num = PIN_NUM_SCLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = LCD_H_RES * LCD_DRAW_BUF_HEIGHT * sizeof(uint16_t),
+        .max_transfer_sz = LCD_MAX_TRANS_PIXELS * sizeof(uint16_t),
     };
     ESP_RETURN_ON_ERROR(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO), TAG, "Failed to initialize SPI bus");
 
@@ -501,9 +577,21 @@ esp_err_t app_lcd_deinit(void)
     return ret;
 }
 
+/* rotation lives in the panel's MADCTL so LVGL renders straight in panel order and
+ * nothing is rotated or copied in software. Called after lvgl_port_add_disp, which
+ * is given no rotation, so the port never touches MADCTL afterwards */
+static esp_err_t apply_panel_rotation(esp_lcd_panel_handle_t panel, bool swap_xy, bool mirror_x, bool mirror_y)
+{
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_swap_xy(panel, swap_xy), TAG, "swap_xy failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_mirror(panel, mirror_x, mirror_y), TAG, "mirror failed");
+    return ESP_OK;
+}
+
 esp_err_t app_lvgl_init(void)
 {
-    const lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    /* display_task wakes the LVGL task itself when something changes, see refresh_kick */
+    lvgl_cfg.task_max_sleep_ms = DISPLAY_LVGL_MAX_SLEEP_MS;
     ESP_RETURN_ON_ERROR(lvgl_port_init(&lvgl_cfg), TAG, "Failed to initialize LVGL port");
     
     /* Add LCD Screen */
@@ -511,49 +599,88 @@ esp_err_t app_lvgl_init(void)
     const lvgl_port_display_cfg_t disp_cfg = {
         .io_handle = io_handle,
         .panel_handle = panel_handle,
-        .buffer_size = LCD_H_RES * LCD_DRAW_BUF_HEIGHT * sizeof(uint16_t),
+        .buffer_size = LCD_H_RES * SCREEN1_PORT_BUF_LINES * sizeof(uint16_t),
         .double_buffer = LCD_DRAW_BUF_DOUBLE,
         .hres = LCD_H_RES,
         .vres = LCD_V_RES,
         .monochrome = false,
         //rotations
         .rotation = {
-            .swap_xy = true,
+            /* rotation is done by the panel, see apply_panel_rotation */
+            .swap_xy = false,
             .mirror_x = false,
-            .mirror_y = true,
+            .mirror_y = false,
         },
         .flags = {
             .buff_dma = true,
-            #if LVGL_VERSION_MAJOR >= 9
-            .swap_bytes = true,
-            #endif
+            /* byte swap happens in app_disp_flush */
         }
     };
     lvgl_disp = lvgl_port_add_disp(&disp_cfg);
+    ESP_RETURN_ON_FALSE(lvgl_disp, ESP_FAIL, TAG, "LVGL disp init failed");
+    ESP_RETURN_ON_ERROR(apply_panel_rotation(panel_handle, SCREEN1_SWAP_XY, SCREEN1_MIRROR_X, SCREEN1_MIRROR_Y),
+                        TAG, "screen 1 rotation failed");
+    const disp_flush_cfg_t flush_cfg = {
+        .io = io_handle,
+        .panel = panel_handle,
+        .swap_bytes = SCREEN1_SWAP_BYTES,
+        .render_cf = SCREEN1_RENDER_CF,
+        .render_lines = LCD_DRAW_BUF_HEIGHT,
+        .render_double = LCD_DRAW_BUF_DOUBLE,
+        .staging_lines = LCD_STAGING_LINES,
+        .fg = lv_color_hex(SCREEN1_TEXT_COLOR),
+        .bg = lv_color_black(),
+        .tile_diff = LCD_TILE_DIFF,
+        .tile_size = LCD_TILE_SIZE,
+    };
+    lvgl_port_lock(0);
+    esp_err_t ret = disp_flush_attach(lvgl_disp, &flush_cfg);
+    lvgl_port_unlock();
+    ESP_RETURN_ON_ERROR(ret, TAG, "flush attach failed");
 
     const lvgl_port_display_cfg_t disp_cfg_2 = {
         .io_handle = io_handle_2,
         .panel_handle = panel_handle_2,
-        .buffer_size = LCD_H_RES_2 * LCD_DRAW_BUF_HEIGHT_2 * sizeof(uint16_t),
+        .buffer_size = LCD_H_RES_2 * SCREEN2_PORT_BUF_LINES * sizeof(uint16_t),
         .double_buffer = LCD_DRAW_BUF_DOUBLE_2,
         .hres = LCD_H_RES_2,
         .vres = LCD_V_RES_2,
         .monochrome = false,
         .rotation = {
             .swap_xy = false,
-            .mirror_x = true,
-            .mirror_y = true,
+            .mirror_x = false,
+            .mirror_y = false,
         },
         .flags = {
             .buff_dma = SCREEN2_LVGL_DMA,
-#if LVGL_VERSION_MAJOR >= 9
-            .swap_bytes = SCREEN2_SWAP_BYTES,
-#endif
         }
     };
     lvgl_disp_2 = lvgl_port_add_disp(&disp_cfg_2);
     if (!lvgl_disp_2) {
         ESP_LOGE(TAG, "LVGL disp 2 init failed");
+    } else {
+        if (apply_panel_rotation(panel_handle_2, SCREEN2_SWAP_XY, SCREEN2_MIRROR_X, SCREEN2_MIRROR_Y) != ESP_OK) {
+            ESP_LOGE(TAG, "screen 2 rotation failed");
+        }
+        const disp_flush_cfg_t flush_cfg_2 = {
+            .io = io_handle_2,
+            .panel = panel_handle_2,
+            .swap_bytes = SCREEN2_SWAP_BYTES,
+            .render_cf = SCREEN2_RENDER_CF,
+            .render_lines = LCD_DRAW_BUF_HEIGHT_2,
+            .render_double = LCD_DRAW_BUF_DOUBLE_2,
+            .staging_lines = LCD_STAGING_LINES,
+            .fg = lv_color_hex(SCREEN2_TEXT_COLOR),
+            .bg = lv_color_black(),
+            .tile_diff = LCD_TILE_DIFF,
+            .tile_size = LCD_TILE_SIZE,
+        };
+        lvgl_port_lock(0);
+        ret = disp_flush_attach(lvgl_disp_2, &flush_cfg_2);
+        lvgl_port_unlock();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "LVGL disp 2 flush attach failed");
+        }
     }
 
     return ESP_OK;
@@ -561,19 +688,252 @@ esp_err_t app_lvgl_init(void)
 
 esp_err_t app_lvgl_deinit(void)
 {
+    /* the flush context owns the L8/I1 render buffers: drop it and the display
+     * in one locked section so LVGL never renders into freed memory */
+    esp_err_t ret = ESP_OK;
+    lvgl_port_lock(0);
     if (lvgl_disp_2) {
-        ESP_RETURN_ON_ERROR(lvgl_port_remove_disp(lvgl_disp_2), TAG, "LVGL disp 2 removing failed");
+        disp_flush_detach(lvgl_disp_2);
+        ret = lvgl_port_remove_disp(lvgl_disp_2);
         lvgl_disp_2 = NULL;
     }
-    ESP_RETURN_ON_ERROR(lvgl_port_remove_disp(lvgl_disp), TAG, "LVGL disp removing failed");
+    if (ret == ESP_OK) {
+        disp_flush_detach(lvgl_disp);
+        ret = lvgl_port_remove_disp(lvgl_disp);
+    }
+    lvgl_port_unlock();
+    ESP_RETURN_ON_ERROR(ret, TAG, "LVGL disp removing failed");
     ESP_RETURN_ON_ERROR(lvgl_port_deinit(), TAG, "LVGL deinit failed");
 
     return ESP_OK;
 }
 
+/* per screen caption log and the view it is shown in */
+typedef struct {
+    lv_obj_t *log_area;          // NULL while the screen is not up
+    disp_scroll_t *scroll;       // hardware scrolled view, NULL = textarea
+    log_line_t *lines;
+    int line_count;
+    int max_lines;
+    TickType_t max_age;
+    const lv_font_t *font;
+    int32_t content_width;
+    int32_t letter_space;
+    int added;                   // lines appended since the view was last updated
+    bool dirty;
+} caption_screen_t;
+
+/* caption latency: tcp rx (text_rec_t.rx_us) until the line is laid out for LVGL */
+static uint32_t latency_count = 0;
+static uint32_t latency_logged = 0;
+static int64_t latency_sum_us = 0;
+static int64_t latency_max_us = 0;
+static int64_t latency_log_us = 0;
+
+static void record_latency(uint32_t rx_us, int64_t done_us)
+{
+    int64_t us = (uint32_t)done_us - rx_us;
+    latency_count++;
+    latency_sum_us += us;
+    if (us > latency_max_us) {
+        latency_max_us = us;
+    }
+    if (done_us - latency_log_us >= DISPLAY_LATENCY_LOG_US && latency_count != latency_logged) {
+        ESP_LOGI(TAG, "caption latency: %lu msgs, avg %lld us, max %lld us", (unsigned long)latency_count,
+                 latency_sum_us / latency_count, latency_max_us);
+        int64_t server_us;
+        if (tcp_server_time(done_us, &server_us)) {
+            /* lines up with the server's own logs of when it sent the caption */
+            ESP_LOGI(TAG, "last caption shown at server time %lld us", server_us);
+        }
+        latency_logged = latency_count;
+        latency_log_us = done_us;
+    }
+}
+
+/* lays out every record waiting in the text ring on its screen and hands the ring
+ * memory back right after; call with the LVGL lock held */
+static void drain_captions(RingbufHandle_t text_rb, caption_screen_t *screens, TickType_t now)
+{
+    uint32_t rx_us[DISPLAY_DRAIN_MAX];
+    int msgs = 0;
+    while (msgs < DISPLAY_DRAIN_MAX) {
+        size_t size = 0;
+        text_rec_t *rec = (text_rec_t *)xRingbufferReceive(text_rb, &size, 0);
+        if (!rec) {
+            break;
+        }
+        caption_screen_t *screen = NULL;
+        if (rec->flags & MSG_FLAG_SCREEN1) {
+            screen = &screens[0];
+        } else if (rec->flags & MSG_FLAG_SCREEN2) {
+            screen = &screens[1];
+        }
+        if (screen && screen->log_area && rec->len > 0) {
+            for (size_t i = 0; i < rec->len; i++) {
+                if (rec->text[i] == '\r' || rec->text[i] == '\n') {
+                    rec->text[i] = ' ';
+                }
+            }
+            if (!screen->dirty) {
+                prune_expired_lines_with_age(screen->lines, &screen->line_count, now, screen->max_age);
+                screen->dirty = true;
+            }
+            screen->added += add_wrapped_lines(screen->lines, &screen->line_count, screen->max_lines,
+                                               rec->text, rec->len, now, screen->font,
+                                               screen->content_width, screen->letter_space);
+            rx_us[msgs++] = rec->rx_us;
+        }
+        vRingbufferReturnItem(text_rb, rec);
+    }
+    int64_t done_us = esp_timer_get_time();
+    for (int i = 0; i < msgs; i++) {
+        record_latency(rx_us[i], done_us);
+    }
+    if (msgs > 1) {
+        ESP_LOGD(TAG, "drained %d captions into one layout", msgs);
+    }
+    if (msgs == DISPLAY_DRAIN_MAX) {
+        /* possibly more waiting, come back right after this layout */
+        display_notify_text();
+    }
+}
+
+/* copies text into a ring record for the screen(s) in flags, as tcp rx would */
+static bool queue_caption(RingbufHandle_t text_rb, uint8_t flags, const char *text)
+{
+    size_t len = strnlen(text, TEXT_MSG_MAX);
+    text_rec_t *rec = NULL;
+    if (!text_rb || xRingbufferSendAcquire(text_rb, (void **)&rec, sizeof(text_rec_t) + len + 1, 0) != pdTRUE) {
+        return false;
+    }
+    rec->rx_us = (uint32_t)esp_timer_get_time();
+    rec->len = (uint16_t)len;
+    rec->flags = flags;
+    memcpy(rec->text, text, len);
+    rec->text[len] = '\0';
+    xRingbufferSendComplete(text_rb, rec);
+    display_notify_text();
+    return true;
+}
+
+/* CONFIG_APP_DISP_BURST_TEST: DISPLAY_BURST_TEST_MSGS captions per screen at once, to compare latency */
+static void queue_burst_test(RingbufHandle_t text_rb)
+{
+    static const uint8_t targets[] = { MSG_FLAG_SCREEN1, MSG_FLAG_SCREEN2 };
+    for (size_t t = 0; t < sizeof(targets); t++) {
+        for (int i = 0; i < DISPLAY_BURST_TEST_MSGS; i++) {
+            char text[32];
+            snprintf(text, sizeof(text), "burst %d of %d", i + 1, DISPLAY_BURST_TEST_MSGS);
+            if (!queue_caption(text_rb, targets[t], text)) {
+                ESP_LOGW(TAG, "burst test: text ring full after %d", i);
+                break;
+            }
+        }
+    }
+}
+
+static TickType_t min_ticks(TickType_t a, TickType_t b)
+{
+    return (a < b) ? a : b;
+}
+
+/* ticks until the oldest line of a log expires, 0 if it already has */
+static TickType_t ticks_until_expiry(const log_line_t *lines, int line_count, TickType_t now,
+                                     TickType_t max_age_ticks)
+{
+    if (line_count <= 0) {
+        return portMAX_DELAY;
+    }
+    TickType_t age = now - lines[0].ts;
+    return (age > max_age_ticks) ? 0 : (max_age_ticks - age + 1);
+}
+
+/* LVGL refresh scheduling: the display refresh timers only run for DISPLAY_REFR_HOLD_MS
+ * after something on screen changed and are parked otherwise, so an idle headset
+ * leaves the LVGL task asleep */
+static bool refr_running = true;
+static TickType_t refr_last_change = 0;
+
+static void set_refresh_timers(bool run)
+{
+    lv_display_t *disps[] = { lvgl_disp, lvgl_disp_2 };
+    for (size_t i = 0; i < sizeof(disps) / sizeof(disps[0]); i++) {
+        lv_timer_t *refr = disps[i] ? lv_display_get_refr_timer(disps[i]) : NULL;
+        if (!refr) {
+            continue;
+        }
+        if (run) {
+            lv_timer_resume(refr);
+            lv_timer_ready(refr);
+        } else {
+            lv_timer_pause(refr);
+        }
+    }
+}
+
+/* call with the LVGL lock held after changing anything on screen */
+static void refresh_kick(TickType_t now)
+{
+    refr_last_change = now;
+    if (!refr_running) {
+        set_refresh_timers(true);
+        refr_running = true;
+        lvgl_port_task_wake(LVGL_PORT_EVENT_USER, NULL);
+    }
+}
+
+static TickType_t refresh_idle_wait(TickType_t now)
+{
+    if (!refr_running) {
+        return portMAX_DELAY;
+    }
+    TickType_t age = now - refr_last_change;
+    TickType_t hold = pdMS_TO_TICKS(DISPLAY_REFR_HOLD_MS);
+    return (age >= hold) ? 0 : (hold - age);
+}
+
+static void refresh_park_if_idle(TickType_t now)
+{
+    if (refr_running && refresh_idle_wait(now) == 0) {
+        lvgl_port_lock(0);
+        set_refresh_timers(false);
+        lvgl_port_unlock();
+        refr_running = false;
+    }
+}
+
+/* applies what drain_captions or a prune changed to the screen's view */
+static void update_screen(caption_screen_t *screen, TickType_t now)
+{
+    show_log(screen->log_area, screen->scroll, screen->lines, screen->line_count, screen->max_lines,
+             screen->added);
+    screen->added = 0;
+    screen->dirty = false;
+    refresh_kick(now);
+}
+
+/* swaps a screen's textarea for the hardware scrolled caption slots at the same place.
+ * The textarea stays (hidden) when scrolling is off or the panel cannot do it */
+static disp_scroll_t *create_scroll_log(lv_display_t *disp, lv_obj_t *log_area, const disp_scroll_cfg_t *cfg)
+{
+#if CONFIG_APP_DISP_HW_SCROLL
+    disp_scroll_t *scroll = NULL;
+    esp_err_t ret = disp_scroll_create(disp, cfg, &scroll);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "hardware scroll unavailable (%s), keeping text area", esp_err_to_name(ret));
+        return NULL;
+    }
+    lv_obj_add_flag(log_area, LV_OBJ_FLAG_HIDDEN);
+    return scroll;
+#else
+    return NULL;
+#endif
+}
+
 void display_task(void *arg)
 {   /*
-    The 240x240 screen is operator-facing, so it has RSSI indicator and REC/RDY indicators. 
+    The 240x240 screen is operator-facing, so it has RSSI indicator and REC/RDY/BUSY indicators. 
     The 480x128 screen only has text.
     */
     lvgl_port_lock(0);
@@ -649,12 +1009,15 @@ void display_task(void *arg)
     lv_obj_add_state(log_area, LV_STATE_DISABLED);
     lv_obj_set_style_bg_opa(log_area, LV_OPA_TRANSP, 0);
     lv_obj_set_style_border_opa(log_area, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_text_color(log_area, lv_color_hex(0x00FF00), 0);
-    lv_obj_set_style_text_outline_stroke_color(log_area, lv_color_hex(0x00FF00), 0);
+    lv_obj_set_style_text_color(log_area, lv_color_hex(SCREEN1_TEXT_COLOR), 0);
+    lv_obj_set_style_text_outline_stroke_color(log_area, lv_color_hex(SCREEN1_TEXT_COLOR), 0);
     lv_obj_set_style_text_outline_stroke_opa(log_area, LV_OPA_COVER, 0);
     lv_obj_set_style_text_outline_stroke_width(log_area, 1, 0);
     lv_obj_set_style_pad_all(log_area, 2, 0);
     lv_obj_set_scrollbar_mode(log_area, LV_SCROLLBAR_MODE_OFF);
+    /* no cursor: its blink animation would keep LVGL refreshing forever */
+    lv_obj_set_style_anim_duration(log_area, 0, LV_PART_CURSOR);
+    lv_obj_set_style_opa(log_area, LV_OPA_TRANSP, LV_PART_CURSOR);
 
     const lv_font_t *log_font = lv_obj_get_style_text_font(log_area, LV_PART_MAIN);
     const int32_t line_space = lv_obj_get_style_text_line_space(log_area, LV_PART_MAIN);
@@ -676,11 +1039,28 @@ void display_task(void *arg)
     if (content_width < 1) {
         content_width = 1;
     }
+    /* status bar sits above text_y, so it ends up in the panel's top fixed area */
+    const disp_scroll_cfg_t scroll_cfg = {
+        .io = io_handle,
+        .parent = scr,
+        .x = text_x + pad_left,
+        .y = text_y + pad_top,
+        .w = content_width,
+        .lines = max_lines,
+        .line_h = line_height,
+        .mem_lines = LCD_V_RES,
+        .swap_xy = SCREEN1_SWAP_XY,
+        .mirror_y = SCREEN1_MIRROR_Y,
+        .font = log_font,
+        .color = lv_color_hex(SCREEN1_TEXT_COLOR),
+    };
+    disp_scroll_t *scroll = create_scroll_log(lvgl_disp, log_area, &scroll_cfg);
 
     const lv_font_t *log_font_2 = NULL;
     int32_t content_width_2 = 1;
     int max_lines_2 = 1;
     int32_t letter_space_2 = 0;
+    disp_scroll_t *scroll_2 = NULL;
     if (lvgl_disp_2) {
         lv_display_t *prev_disp = lv_display_get_default();
         lv_display_set_default(lvgl_disp_2);
@@ -697,12 +1077,15 @@ void display_task(void *arg)
         lv_obj_add_state(log_area_2, LV_STATE_DISABLED);
         lv_obj_set_style_bg_opa(log_area_2, LV_OPA_TRANSP, 0);
         lv_obj_set_style_border_opa(log_area_2, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_text_color(log_area_2, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_outline_stroke_color(log_area_2, lv_color_hex(0xFFFFFF), 0);
+        lv_obj_set_style_text_color(log_area_2, lv_color_hex(SCREEN2_TEXT_COLOR), 0);
+        lv_obj_set_style_text_outline_stroke_color(log_area_2, lv_color_hex(SCREEN2_TEXT_COLOR), 0);
         lv_obj_set_style_text_outline_stroke_opa(log_area_2, LV_OPA_COVER, 0);
         lv_obj_set_style_text_outline_stroke_width(log_area_2, 1, 0);
         lv_obj_set_style_pad_all(log_area_2, 4, 0);
         lv_obj_set_scrollbar_mode(log_area_2, LV_SCROLLBAR_MODE_OFF);
+        /* no cursor: its blink animation would keep LVGL refreshing forever */
+        lv_obj_set_style_anim_duration(log_area_2, 0, LV_PART_CURSOR);
+        lv_obj_set_style_opa(log_area_2, LV_OPA_TRANSP, LV_PART_CURSOR);
 #if LV_FONT_MONTSERRAT_28
         lv_obj_set_style_text_font(log_area_2, &lv_font_montserrat_28, 0);
 #endif
@@ -727,6 +1110,21 @@ void display_task(void *arg)
         if (content_width_2 < 1) {
             content_width_2 = 1;
         }
+        const disp_scroll_cfg_t scroll_cfg_2 = {
+            .io = io_handle_2,
+            .parent = scr_2,
+            .x = text_x_2 + pad_left_2,
+            .y = text_y_2 + pad_top_2,
+            .w = content_width_2,
+            .lines = max_lines_2,
+            .line_h = line_height_2,
+            .mem_lines = LCD_V_RES_2,
+            .swap_xy = SCREEN2_SWAP_XY,
+            .mirror_y = SCREEN2_MIRROR_Y,
+            .font = log_font_2,
+            .color = lv_color_hex(SCREEN2_TEXT_COLOR),
+        };
+        scroll_2 = create_scroll_log(lvgl_disp_2, log_area_2, &scroll_cfg_2);
         lv_display_set_default(prev_disp);
     }
 
@@ -735,144 +1133,158 @@ void display_task(void *arg)
 
     static log_line_t lines[DISPLAY_MAX_LINES];
     static log_line_t lines_2[DISPLAY_MAX_LINES_2];
-    static int line_count = 0;
-    static int line_count_2 = 0;
-    QueueHandle_t disp1_q = tcp_rx_get_disp1_q();
-    QueueHandle_t disp2_q = tcp_rx_get_disp2_q();
-    TickType_t last_indicator_update = 0;
-    TickType_t last_prune = 0;
-    TickType_t last_prune_2 = 0;
-    const TickType_t max_age_2 = pdMS_TO_TICKS(DISPLAY_LINE_MAX_AGE_MS_2);
-    const char *init_text_1 = "Live Language Lens READY";
-    const char *init_text_2 = "Live Language Lens READY";
-
-    text_msg_t init_msg = { 0 };
-    size_t init_len = strlen(init_text_1);
-    init_msg.len = (uint16_t)init_len;
-    memcpy(init_msg.payload, init_text_1, init_len);
-    if (disp1_q && xQueueSend(disp1_q, &init_msg, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "display_task: init text enqueue failed for screen1");
-    }
-    init_msg.len = (uint16_t)strlen(init_text_2);
-    memcpy(init_msg.payload, init_text_2, init_msg.len);
-    if (disp2_q && xQueueSend(disp2_q, &init_msg, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "display_task: init text enqueue failed for screen2");
+    caption_screen_t screens[2] = {
+        {
+            .log_area = log_area,
+            .scroll = scroll,
+            .lines = lines,
+            .max_lines = max_lines,
+            .max_age = pdMS_TO_TICKS(DISPLAY_LINE_MAX_AGE_MS),
+            .font = log_font,
+            .content_width = content_width,
+            .letter_space = letter_space,
+        },
+        {
+            .log_area = log_area_2,
+            .scroll = scroll_2,
+            .lines = lines_2,
+            .max_lines = max_lines_2,
+            .max_age = pdMS_TO_TICKS(DISPLAY_LINE_MAX_AGE_MS_2),
+            .font = log_font_2,
+            .content_width = content_width_2,
+            .letter_space = letter_space_2,
+        },
+    };
+    RingbufHandle_t text_rb = tcp_rx_get_text_rb();
+    app_gpio_state_t shown_state = APP_GPIO_STATE_IDLE;
+    bool shown_busy = false;
+    int shown_rssi = 0;
+    bool status_shown = false;
+    bool status_pending = true;
+    bool burst_pending = DISPLAY_BURST_TEST;
+    const char *init_text = "Live Language Lens READY";
+
+    if (!queue_caption(text_rb, MSG_FLAG_SCREEN1, init_text) ||
+        !queue_caption(text_rb, MSG_FLAG_SCREEN2, init_text)) {
+        ESP_LOGW(TAG, "display_task: init text enqueue failed");
     }
 
     while (1) {
-        text_msg_t msg;
-        text_msg_t msg_2;
-        bool got_msg = false;
-        bool got_msg_2 = false;
-        if (disp1_q) {
-            if (xQueueReceive(disp1_q, &msg, pdMS_TO_TICKS(100)) == pdTRUE) {
-                got_msg = true;
+        /* sleep until something is queued or the status changed (task notification),
+         * the oldest line expires, or the LVGL refresh timers can be parked again */
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = refresh_idle_wait(now);
+        for (int i = 0; i < 2; i++) {
+            if (screens[i].log_area) {
+                wait = min_ticks(wait, ticks_until_expiry(screens[i].lines, screens[i].line_count, now,
+                                                          screens[i].max_age));
             }
-        } else if (!disp2_q) {
-            vTaskDelay(pdMS_TO_TICKS(100));
         }
-        if (disp2_q) {
-            TickType_t wait_ticks = disp1_q ? 0 : pdMS_TO_TICKS(100);
-            if (xQueueReceive(disp2_q, &msg_2, wait_ticks) == pdTRUE) {
-                got_msg_2 = true;
-            }
+        if (status_pending) {
+            wait = 0;
         }
-
-        TickType_t now = xTaskGetTickCount();
-        bool prune_needed = (now - last_prune) > pdMS_TO_TICKS(200);
-        bool indicator_needed = (now - last_indicator_update) > pdMS_TO_TICKS(250);
-        bool prune_needed_2 = (now - last_prune_2) > pdMS_TO_TICKS(200);
-
-        if (got_msg) {
-            size_t copy_len = msg.len;
-            if (copy_len > TEXT_BUF_SIZE) {
-                copy_len = TEXT_BUF_SIZE;
-            }
-            char line_buf[TEXT_BUF_SIZE + 1];
-            memcpy(line_buf, msg.payload, copy_len);
-            line_buf[copy_len] = '\0';
-            for (size_t i = 0; i < copy_len; i++) {
-                if (line_buf[i] == '\r' || line_buf[i] == '\n') {
-                    line_buf[i] = ' ';
-                }
-            }
-
-            lvgl_port_lock(0);
-            prune_expired_lines(lines, &line_count, now);
-            add_wrapped_lines(lines, &line_count, max_lines, line_buf, now, log_font,
-                              content_width, letter_space);
-            rebuild_log_textarea(log_area, lines, line_count, max_lines);
-            lvgl_port_unlock();
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, wait);
+        if (events & DISPLAY_NOTIFY_STATUS) {
+            status_pending = true;
+        }
+        now = xTaskGetTickCount();
+        if (!text_rb) {
+            /* tcp rx creates the ring, it may come up after us */
+            text_rb = tcp_rx_get_text_rb();
         }
 
-        if (got_msg_2 && log_area_2) {
-            size_t copy_len = msg_2.len;
-            if (copy_len > TEXT_BUF_SIZE) {
-                copy_len = TEXT_BUF_SIZE;
-            }
-            char line_buf[TEXT_BUF_SIZE + 1];
-            memcpy(line_buf, msg_2.payload, copy_len);
-            line_buf[copy_len] = '\0';
-            for (size_t i = 0; i < copy_len; i++) {
-                if (line_buf[i] == '\r' || line_buf[i] == '\n') {
-                    line_buf[i] = ' ';
-                }
+        /* everything queued since the last wake goes into one layout per screen */
+        lvgl_port_lock(0);
+        if (text_rb) {
+            drain_captions(text_rb, screens, now);
+        }
+        for (int i = 0; i < 2; i++) {
+            caption_screen_t *screen = &screens[i];
+            if (!screen->log_area) {
+                continue;
             }
-
-            lvgl_port_lock(0);
-            prune_expired_lines_with_age(lines_2, &line_count_2, now, max_age_2);
-            add_wrapped_lines(lines_2, &line_count_2, max_lines_2, line_buf, now, log_font_2,
-                              content_width_2, letter_space_2);
-            rebuild_log_textarea(log_area_2, lines_2, line_count_2, max_lines_2);
-            lvgl_port_unlock();
-        }
-
-        if (prune_needed) {
-            bool changed = false;
-            lvgl_port_lock(0);
-            int before = line_count;
-            prune_expired_lines(lines, &line_count, now);
-            changed = (before != line_count);
-            if (changed) {
-                rebuild_log_textarea(log_area, lines, line_count, max_lines);
+            if (!screen->dirty && ticks_until_expiry(screen->lines, screen->line_count, now, screen->max_age) == 0) {
+                prune_expired_lines_with_age(screen->lines, &screen->line_count, now, screen->max_age);
+                screen->dirty = true;
             }
-            lvgl_port_unlock();
-            last_prune = now;
-        }
-
-        if (prune_needed_2 && log_area_2) {
-            bool changed = false;
-            lvgl_port_lock(0);
-            int before = line_count_2;
-            prune_expired_lines_with_age(lines_2, &line_count_2, now, max_age_2);
-            changed = (before != line_count_2);
-            if (changed) {
-                rebuild_log_textarea(log_area_2, lines_2, line_count_2, max_lines_2);
+            if (screen->dirty) {
+                update_screen(screen, now);
             }
-            lvgl_port_unlock();
-            last_prune_2 = now;
         }
+        lvgl_port_unlock();
 
-        if (indicator_needed) {
+        if (status_pending) {
+            status_pending = false;
             app_gpio_state_t state = gpio_get_state();
-            int8_t rssi = wifi_get_rssi();
-            char rssi_buf[16];
-            lvgl_port_lock(0);
-            if (state == APP_GPIO_STATE_IDLE) {
-                lv_label_set_text(rdy_label, "RDY");
-                lv_obj_align(rdy_label, LV_ALIGN_LEFT_MID, 0, 0);
-                lv_obj_clear_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
-                lv_obj_add_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
-            } else {
-                lv_obj_add_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
-                lv_obj_clear_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
+            bool busy = tcp_server_busy();
+            int rssi = wifi_get_rssi();
+            bool state_changed = !status_shown || (state != shown_state) || (busy != shown_busy);
+            /* RSSI jitters by a dB or two between reads, only follow real changes */
+            bool rssi_changed = !status_shown || (abs(rssi - shown_rssi) >= DISPLAY_RSSI_HYST_DB);
+            if (state_changed || rssi_changed) {
+                lvgl_port_lock(0);
+                if (state_changed) {
+                    if (busy) {
+                        /* server is not taking audio: recording now would only lose it */
+                        lv_label_set_text(rdy_label, "BUSY");
+                        lv_obj_set_style_text_color(rdy_label, lv_color_hex(0xFFA000), 0);
+                        lv_obj_align(rdy_label, LV_ALIGN_LEFT_MID, 0, 0);
+                        lv_obj_clear_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
+                        lv_obj_add_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
+                    } else if (state == APP_GPIO_STATE_IDLE) {
+                        lv_label_set_text(rdy_label, "RDY");
+                        lv_obj_set_style_text_color(rdy_label, lv_color_hex(0x2D6BFF), 0);
+                        lv_obj_align(rdy_label, LV_ALIGN_LEFT_MID, 0, 0);
+                        lv_obj_clear_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
+                        lv_obj_add_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
+                    } else if (state == APP_GPIO_STATE_CONVERSATION) {
+                        /* both mics live, audio goes out while someone talks */
+                        lv_label_set_text(rdy_label, "CONV");
+                        lv_obj_set_style_text_color(rdy_label, lv_color_hex(0xFF3030), 0);
+                        lv_obj_align(rdy_label, LV_ALIGN_LEFT_MID, 0, 0);
+                        lv_obj_clear_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
+                        lv_obj_add_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
+                    } else {
+                        lv_obj_add_flag(rdy_label, LV_OBJ_FLAG_HIDDEN);
+                        lv_obj_clear_flag(rec_dot, LV_OBJ_FLAG_HIDDEN);
+                    }
+                    shown_state = state;
+                    shown_busy = busy;
+                }
+                if (rssi_changed) {
+                    char rssi_buf[16];
+                    snprintf(rssi_buf, sizeof(rssi_buf), "RSSI %d", rssi);
+                    lv_label_set_text(rssi_label, rssi_buf);
+                    lv_obj_align(rssi_label, LV_ALIGN_RIGHT_MID, 0, 0);
+                    shown_rssi = rssi;
+                }
+                refresh_kick(now);
+                lvgl_port_unlock();
+                status_shown = true;
             }
-            snprintf(rssi_buf, sizeof(rssi_buf), "RSSI %d", (int)rssi);
-            lv_label_set_text(rssi_label, rssi_buf);
-            lv_obj_align(rssi_label, LV_ALIGN_RIGHT_MID, 0, 0);
-            lvgl_port_unlock();
-            last_indicator_update = now;
         }
+
+        if (burst_pending) {
+            burst_pending = false;
+            queue_burst_test(text_rb);
+        }
+
+        refresh_park_if_idle(now);
+    }
+}
+
+void display_notify_text(void)
+{
+    if (display_task_handle) {
+        xTaskNotify(display_task_handle, DISPLAY_NOTIFY_TEXT, eSetBits);
+    }
+}
+
+void display_notify_status(void)
+{
+    if (display_task_handle) {
+        xTaskNotify(display_task_handle, DISPLAY_NOTIFY_STATUS, eSetBits);
     }
 }
 
@@ -880,5 +1292,5 @@ void display_make_tasks(void)
 {
     ESP_ERROR_CHECK(app_lcd_init());
     ESP_ERROR_CHECK(app_lvgl_init());
-    xTaskCreatePinnedToCore(display_task, "display_task", 8192, NULL, 6, NULL, 1);
+    xTaskCreatePinnedToCore(display_task, "display_task", 8192, NULL, 6, &display_task_handle, 1);
 }
@@ -17,6 +17,9 @@ esp_err_t app_lvgl_deinit(void);
 //void app_main_display(void);
 void display_task(void *arg);
 void display_make_tasks(void);
+/* wake display_task: a caption was queued / REC-RDY or link status changed */
+void display_notify_text(void);
+void display_notify_status(void);
 //void check_leak(size_t start_free, size_t end_free, const char *type);
 
 #ifdef __cplusplus
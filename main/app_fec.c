@@ -0,0 +1,83 @@
+/* Eric Liu 2026
+
+XOR forward error correction for audio sent over UDP. After every group of
+frames one parity frame goes out carrying the XOR of their payloads, so the
+server can rebuild any single frame lost from the group without waiting for
+a resend. Costs one datagram per group; two losses in a group stay lost.
+
+Payloads are XORed in place into the parity buffer as they are sent, no
+copies of the group are kept.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: audio frame payloads as they are sent
+OUTPUTS: parity frames
+
+*/
+
+#include "app_fec.h"
+
+#include <string.h>
+
+bool fec_enc_init(fec_enc_t *fec, uint8_t *buf, size_t max_payload, uint8_t group)
+{
+    if (!fec || !buf || group < 2 || max_payload > UINT16_MAX) {
+        return false;
+    }
+    memset(fec, 0, sizeof(*fec));
+    memset(buf, 0, FEC_FRAME_SIZE(max_payload));
+    fec->buf = buf;
+    fec->max_payload = max_payload;
+    fec->group = group;
+    return true;
+}
+
+void fec_enc_reset(fec_enc_t *fec)
+{
+    /* only the bytes used by this group can be non-zero */
+    memset(fec->buf + FRAME_HDR_SIZE + sizeof(audio_fec_hdr_t), 0, fec->len_max);
+    fec->count = 0;
+    fec->flags_xor = 0;
+    fec->len_xor = 0;
+    fec->len_max = 0;
+}
+
+bool fec_enc_add(fec_enc_t *fec, uint32_t seq, uint8_t flags, const uint8_t *payload, size_t len)
+{
+    if (len > fec->max_payload) {
+        return false;
+    }
+    if (fec->count >= fec->group) {
+        /* parity of the last group was taken, its buffer is free again */
+        fec_enc_reset(fec);
+    }
+    if (fec->count == 0) {
+        fec->seq = seq;
+    }
+    uint8_t *parity = fec->buf + FRAME_HDR_SIZE + sizeof(audio_fec_hdr_t);
+    for (size_t i = 0; i < len; i++) {
+        parity[i] ^= payload[i];
+    }
+    if (len > fec->len_max) {
+        fec->len_max = len;
+    }
+    fec->flags_xor ^= flags;
+    fec->len_xor ^= (uint16_t)len;
+    fec->count++;
+    return fec->count >= fec->group;
+}
+
+size_t fec_enc_frame(fec_enc_t *fec, const uint8_t **data)
+{
+    uint8_t *fh = fec->buf + FRAME_HDR_SIZE;
+    size_t len = sizeof(audio_fec_hdr_t) + fec->len_max;
+    frame_put_hdr(fec->buf, MSG_TYPE_AUDIO, MSG_FLAG_FEC, len);
+    frame_put_be32(fh + offsetof(audio_fec_hdr_t, seq), fec->seq);
+    fh[offsetof(audio_fec_hdr_t, count)] = fec->count;
+    fh[offsetof(audio_fec_hdr_t, flags_xor)] = fec->flags_xor;
+    fh[offsetof(audio_fec_hdr_t, len_xor)] = (uint8_t)(fec->len_xor >> 8);
+    fh[offsetof(audio_fec_hdr_t, len_xor) + 1] = (uint8_t)fec->len_xor;
+    *data = fec->buf;
+    return FRAME_HDR_SIZE + len;
+}
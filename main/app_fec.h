@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_frame.h"
+
+/* XOR parity over groups of audio datagrams, see audio_fec_hdr_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* buffer size for the parity frame of payloads up to max_payload bytes */
+#define FEC_FRAME_SIZE(max_payload) (FRAME_HDR_SIZE + sizeof(audio_fec_hdr_t) + (max_payload))
+
+typedef struct {
+    uint8_t *buf;                // parity frame being built, FEC_FRAME_SIZE(max_payload) bytes
+    size_t max_payload;
+    uint8_t group;               // frames per parity frame
+    uint8_t count;               // frames in the current group
+    uint8_t flags_xor;
+    uint16_t len_xor;
+    uint32_t seq;                // first frame of the current group
+    size_t len_max;              // longest payload in the current group
+} fec_enc_t;
+
+bool fec_enc_init(fec_enc_t *fec, uint8_t *buf, size_t max_payload, uint8_t group);
+
+/* drops the current group, e.g. when the link goes down */
+void fec_enc_reset(fec_enc_t *fec);
+
+/* adds a sent frame's payload (everything after its msg_hdr_t); true when the group is
+ * complete and its parity frame is ready for fec_enc_frame */
+bool fec_enc_add(fec_enc_t *fec, uint32_t seq, uint8_t flags, const uint8_t *payload, size_t len);
+
+/* the finished parity frame, valid until the next fec_enc_add */
+size_t fec_enc_frame(fec_enc_t *fec, const uint8_t **data);
+
+#ifdef __cplusplus
+}
+#endif
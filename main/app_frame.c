@@ -0,0 +1,140 @@
+/* Eric Liu 2026
+
+Streaming parser for the TCP framing. The net task receives whatever the
+socket has into one buffer and takes out as many complete frames as it holds,
+so a burst of small text messages costs one recv() instead of two per message.
+
+Bad magic/version drops bytes up to the next magic byte (resync). Payloads
+over max_payload are skipped as they arrive, in whole receive buffers, and
+never have to fit.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: received bytes
+OUTPUTS: frames pointing into the receive buffer
+
+*/
+
+#include "app_frame.h"
+
+#include <string.h>
+
+uint32_t frame_get_be32(const uint8_t *src)
+{
+    return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+void frame_put_be32(uint8_t *dst, uint32_t val)
+{
+    dst[0] = (uint8_t)(val >> 24);
+    dst[1] = (uint8_t)(val >> 16);
+    dst[2] = (uint8_t)(val >> 8);
+    dst[3] = (uint8_t)val;
+}
+
+uint64_t frame_get_be64(const uint8_t *src)
+{
+    return ((uint64_t)frame_get_be32(src) << 32) | frame_get_be32(src + 4);
+}
+
+void frame_put_be64(uint8_t *dst, uint64_t val)
+{
+    frame_put_be32(dst, (uint32_t)(val >> 32));
+    frame_put_be32(dst + 4, (uint32_t)val);
+}
+
+bool frame_parser_init(frame_parser_t *p, uint8_t *buf, size_t cap, uint32_t max_payload)
+{
+    if (!p || !buf || cap < FRAME_HDR_SIZE + (size_t)max_payload) {
+        return false;
+    }
+    memset(p, 0, sizeof(*p));
+    p->buf = buf;
+    p->cap = cap;
+    p->max_payload = max_payload;
+    return true;
+}
+
+void frame_parser_reset(frame_parser_t *p)
+{
+    p->head = 0;
+    p->len = 0;
+    p->skip = 0;
+}
+
+uint8_t *frame_parser_space(frame_parser_t *p, size_t *avail)
+{
+    if (p->head > 0) {
+        p->len -= p->head;
+        memmove(p->buf, p->buf + p->head, p->len);
+        p->head = 0;
+    }
+    *avail = p->cap - p->len;
+    return p->buf + p->len;
+}
+
+void frame_parser_commit(frame_parser_t *p, size_t n)
+{
+    p->len += n;
+}
+
+bool frame_parser_next(frame_parser_t *p, frame_t *out)
+{
+    while (1) {
+        size_t avail = p->len - p->head;
+        if (p->skip > 0) {
+            size_t n = avail < p->skip ? avail : p->skip;
+            p->head += n;
+            p->skip -= n;
+            p->stats.dropped_bytes += n;
+            if (p->skip > 0) {
+                return false;
+            }
+            continue;
+        }
+        if (avail < FRAME_HDR_SIZE) {
+            return false;
+        }
+
+        const uint8_t *hdr = p->buf + p->head;
+        if (hdr[0] != MSG_MAGIC || hdr[1] != MSG_VERSION) {
+            const uint8_t *magic = (const uint8_t *)memchr(hdr + 1, MSG_MAGIC, avail - 1);
+            size_t drop = magic ? (size_t)(magic - hdr) : avail;
+            p->head += drop;
+            p->stats.resyncs++;
+            p->stats.dropped_bytes += drop;
+            continue;
+        }
+
+        uint32_t len = frame_get_be32(hdr + offsetof(msg_hdr_t, payload_len));
+        if (len > p->max_payload) {
+            p->head += FRAME_HDR_SIZE;
+            p->skip = len;
+            p->stats.oversize++;
+            p->stats.dropped_bytes += FRAME_HDR_SIZE;
+            continue;
+        }
+        if (avail < FRAME_HDR_SIZE + len) {
+            return false;
+        }
+
+        out->msg_type = hdr[offsetof(msg_hdr_t, msg_type)];
+        out->flags = hdr[offsetof(msg_hdr_t, flags)];
+        out->len = len;
+        out->payload = hdr + FRAME_HDR_SIZE;
+        p->head += FRAME_HDR_SIZE + len;
+        p->stats.frames++;
+        return true;
+    }
+}
+
+size_t frame_put_hdr(uint8_t *dst, uint8_t msg_type, uint8_t flags, uint32_t len)
+{
+    dst[0] = MSG_MAGIC;
+    dst[1] = MSG_VERSION;
+    dst[2] = msg_type;
+    dst[3] = flags;
+    frame_put_be32(dst + offsetof(msg_hdr_t, payload_len), len);
+    return FRAME_HDR_SIZE;
+}
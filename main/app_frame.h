@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Framing of the TCP link: an 8 byte msg_hdr_t followed by payload_len bytes.
+ * Plain C without ESP-IDF dependencies, so it builds on any host. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MSG_MAGIC   0xAA
+#define MSG_VERSION 1
+
+#define MSG_TYPE_AUDIO   1
+#define MSG_TYPE_TEXT    2
+#define MSG_TYPE_CONTROL 3
+#define MSG_TYPE_MEL     4     // log-mel features instead of audio, APP_AUDIO_MEL
+
+#define MSG_FLAG_LANG1   0x01
+#define MSG_FLAG_LANG2   0x02
+#define MSG_FLAG_SCREEN1 0x04    // TEXT; with APP_AUDIO_CONVERSATION and no SCREEN bits, LANG1 means SCREEN1 (the wearer's)
+#define MSG_FLAG_SCREEN2 0x08    // TEXT; and LANG2 SCREEN2 (the subject's)
+#define MSG_FLAG_RATE_SHIFT 2    // AUDIO: bits 2-3 (the SCREEN bits of TEXT) give the sample rate, AUDIO_RATE_*
+#define MSG_FLAG_RATE_MASK  0x0C
+#define MSG_FLAG_SEQ     0x10    // AUDIO: payload starts with an audio_sub_hdr_t
+#define MSG_FLAG_FEC     0x20    // AUDIO over UDP: XOR parity of a group, payload starts with an audio_fec_hdr_t
+#define MSG_FLAG_FMT_SHIFT 6     // AUDIO: bits 6-7 give the payload format, AUDIO_FMT_*
+#define MSG_FLAG_FMT_MASK  0xC0
+
+/* AUDIO payload formats, all little endian samples at the rate in the RATE bits */
+#define AUDIO_FMT_RAW      0     // I2S slots: 2 x 32 bit slots, 24 bit left aligned; the slot of a mic
+                                 // that was not captured is 0. LANG1 | LANG2 (conversation mode): both
+                                 // languages, LANG1 in the left slot and LANG2 in the right
+#define AUDIO_FMT_S16      1     // mono s16 of the LANG flag's mic (LANG1 left slot, LANG2 right)
+#define AUDIO_FMT_S16_8K   2     // 8 kHz mono s16
+#define AUDIO_FMT_ADPCM_8K 3     // 8 kHz mono IMA ADPCM: s16 predictor, u8 step index, u8 0,
+                                 // then 4 bit codes, low nibble first; every frame decodes on its own
+
+/* AUDIO sample rates; 0 is 16 kHz, what RAW and S16 frames were before the field existed */
+#define AUDIO_RATE_16K     0
+#define AUDIO_RATE_8K      1
+#define AUDIO_RATE_12K     2
+#define AUDIO_RATE_NONE    3     // reserved
+
+/* MEL payload: whole frames of MEL_BINS (app_mel.h) little endian s16, log10 of the mel power in
+ * Q10, one frame per 10 ms of 16 kHz audio; Whisper's log_mel_spectrogram before its clamp to
+ * 8 below the maximum and (x + 4) / 4. Flags: LANG, SEQ and FEC as AUDIO, no format or rate bits.
+ * MEL frames take the AUDIO frames' place in seq, ACK, RESUME and CREDIT; parity datagrams stay
+ * AUDIO, a frame rebuilt from one has the type of the rest of its group */
+
+/* CONTROL payload: an op byte, then big endian u32 arguments (u64 and s64 ones are big endian
+ * too, i.e. high word first). Empty CONTROL frames and unknown ops are ignored.
+ * PING   token               peer echoes it back in a PONG
+ * ACK    seq                 server has every AUDIO frame up to seq
+ * RESUME session, acked, next  sent by the headset after every connect; the server answers
+ *                            with an ACK of the last frame it has and frames after that follow
+ * CREDIT limit               server takes AUDIO payload bytes (payload_len, TCP only) up to limit,
+ *                            counted from the start of the connection; unlimited until the first one
+ * TIME   u64 t1              clock sync request, t1 the headset's esp_timer time in us
+ * TIME_REPLY u64 t1, t2, t3  the server's answer: t1 echoed, t2 when TIME arrived and t3 when
+ *                            the reply left, in us of the clock it timestamps its pipeline with
+ * CLOCK  s64 offset, u64 ref, s32 drift  the headset's estimate after a TIME_REPLY: a device time
+ *                            d (audio_sub_hdr_t ts_us, unwrapped) is server time
+ *                            d + offset + (d - ref) * drift / 1e9, drift in ppb */
+#define CTRL_OP_PING   1
+#define CTRL_OP_PONG   2
+#define CTRL_OP_ACK    3
+#define CTRL_OP_RESUME 4
+#define CTRL_OP_CREDIT 5
+#define CTRL_OP_TIME   6
+#define CTRL_OP_TIME_REPLY 7
+#define CTRL_OP_CLOCK  8
+#define CTRL_PING_LEN   5
+#define CTRL_ACK_LEN    5
+#define CTRL_RESUME_LEN 13
+#define CTRL_TIME_LEN   9
+#define CTRL_TIME_REPLY_LEN 25
+#define CTRL_CLOCK_LEN  21
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;
+    uint8_t version;
+    uint8_t msg_type;     // AUDIO = 1, TEXT = 2, CONTROL = 3, MEL = 4
+    uint8_t flags;        // MSG_FLAG_*
+    uint32_t payload_len; // bytes after header, big endian
+} msg_hdr_t;
+
+#define FRAME_HDR_SIZE sizeof(msg_hdr_t)
+
+typedef struct __attribute__((packed)) {
+    uint32_t seq;         // audio frame number, big endian
+    uint32_t ts_us;       // capture time: esp_timer time its chunk was read from I2S (low 32 bits), big endian
+} audio_sub_hdr_t;
+
+/* parity datagram for frames seq .. seq + count - 1: XOR of their payloads (sub-header and
+ * audio, zero padded to the longest) follows. With all but one of them the missing one is
+ * the XOR of the others and the parity, its length len_xor XORed with theirs */
+typedef struct __attribute__((packed)) {
+    uint32_t seq;         // first frame of the group, big endian
+    uint8_t count;        // frames in the group
+    uint8_t flags_xor;    // XOR of their msg_hdr_t flags
+    uint16_t len_xor;     // XOR of their payload lengths, big endian
+} audio_fec_hdr_t;
+
+/* one decoded frame, payload points into the parser buffer */
+typedef struct {
+    uint8_t msg_type;
+    uint8_t flags;
+    uint32_t len;
+    const uint8_t *payload;
+} frame_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t resyncs;            // bad magic/version seen, bytes dropped up to the next magic
+    uint32_t oversize;           // frames skipped for payload_len > max_payload
+    uint64_t dropped_bytes;      // resync and oversize bytes
+} frame_stats_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t head;                 // first byte not yet parsed
+    size_t len;                  // bytes in buf
+    uint32_t skip;               // oversize payload bytes still to drop
+    uint32_t max_payload;
+    frame_stats_t stats;
+} frame_parser_t;
+
+/* cap has to hold the largest accepted frame: FRAME_HDR_SIZE + max_payload */
+bool frame_parser_init(frame_parser_t *p, uint8_t *buf, size_t cap, uint32_t max_payload);
+
+/* drops buffered bytes and any pending skip, e.g. on reconnect; stats are kept */
+void frame_parser_reset(frame_parser_t *p);
+
+/* free space to receive into; moves unparsed bytes to the front first, which
+ * invalidates frames returned earlier. Never empty after draining frame_parser_next */
+uint8_t *frame_parser_space(frame_parser_t *p, size_t *avail);
+
+/* n bytes were written to the space returned by frame_parser_space */
+void frame_parser_commit(frame_parser_t *p, size_t n);
+
+/* next complete frame in the buffer; false when more bytes are needed */
+bool frame_parser_next(frame_parser_t *p, frame_t *out);
+
+uint32_t frame_get_be32(const uint8_t *src);
+void frame_put_be32(uint8_t *dst, uint32_t val);
+uint64_t frame_get_be64(const uint8_t *src);
+void frame_put_be64(uint8_t *dst, uint64_t val);
+
+/* writes a header for a len byte payload to dst, returns FRAME_HDR_SIZE */
+size_t frame_put_hdr(uint8_t *dst, uint8_t msg_type, uint8_t flags, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,12 +3,21 @@
 Monitors two GPIO inputs and publishes a debounced FSM state:
 idle, translate_lang1, translate_lang2.
 
-INPUTS: button 1, button 2
+With APP_AUDIO_CONVERSATION pressing one button while the other is held
+toggles conversation mode, which stays on with the buttons released until the
+next such chord.
+
+With APP_KWS a spoken keyword (gpio_voice_trigger) starts translating a
+language without holding a button; it lasts APP_KWS_LISTEN_MS, until
+"stop" or until a button is pressed, and the buttons win while held.
+
+INPUTS: button 1, button 2, keywords from the audio task
 OUTPUTS: app_gpio_get_state() for other tasks
 
 */
 
 #include "app_gpio.h"
+#include "app_display.h"
 #include <assert.h>
 #include <stdbool.h>
 
@@ -38,6 +47,10 @@ typedef struct {
 static app_gpio_state_t gpio_state = APP_GPIO_STATE_IDLE;
 static portMUX_TYPE gpio_state_mux = portMUX_INITIALIZER_UNLOCKED;
 static app_gpio_last_t last_pressed = APP_GPIO_LAST_NONE;
+#if CONFIG_APP_KWS
+static app_gpio_state_t voice_state = APP_GPIO_STATE_IDLE;    // under gpio_state_mux
+static TickType_t voice_until;
+#endif
 
 static void app_gpio_init_inputs(void)
 {
@@ -103,6 +116,29 @@ app_gpio_state_t gpio_get_state(void)
     return state;
 }
 
+#if CONFIG_APP_KWS
+void gpio_voice_trigger(app_gpio_state_t state)
+{
+    portENTER_CRITICAL(&gpio_state_mux);
+    voice_state = state;
+    voice_until = xTaskGetTickCount() + pdMS_TO_TICKS(CONFIG_APP_KWS_LISTEN_MS);
+    portEXIT_CRITICAL(&gpio_state_mux);
+}
+
+/* the keyword's state while it lasts; a button press ends it */
+static app_gpio_state_t app_gpio_voice_state(bool pressed)
+{
+    app_gpio_state_t state;
+    portENTER_CRITICAL(&gpio_state_mux);
+    if (pressed || (int32_t)(voice_until - xTaskGetTickCount()) <= 0) {
+        voice_state = APP_GPIO_STATE_IDLE;
+    }
+    state = voice_state;
+    portEXIT_CRITICAL(&gpio_state_mux);
+    return state;
+}
+#endif
+
 static void app_gpio_task(void *args)
 {
     app_gpio_debounce_t btn1;
@@ -111,6 +147,7 @@ static void app_gpio_task(void *args)
     app_gpio_debounce_init(&btn1, gpio_get_level(APP_GPIO_BUTTON1_PIN));
     app_gpio_debounce_init(&btn2, gpio_get_level(APP_GPIO_BUTTON2_PIN));
 
+    bool conversation = false;
     ESP_LOGI(TAG, "gpio task running");
 
     while (1) {
@@ -130,9 +167,17 @@ static void app_gpio_task(void *args)
         }
         (void)btn1_edge_release;
         (void)btn2_edge_release;
+#if CONFIG_APP_AUDIO_CONVERSATION
+        if ((btn1_edge_press && btn2.pressed) || (btn2_edge_press && btn1.pressed)) {
+            conversation = !conversation;
+            ESP_LOGI(TAG, "conversation mode %s", conversation ? "on" : "off");
+        }
+#endif
 
         app_gpio_state_t new_state;
-        if (btn1.pressed && btn2.pressed) {
+        if (conversation) {
+            new_state = APP_GPIO_STATE_CONVERSATION;
+        } else if (btn1.pressed && btn2.pressed) {
             new_state = (last_pressed == APP_GPIO_LAST_BTN2) ? APP_GPIO_STATE_TRANSLATE_LANG2 : APP_GPIO_STATE_TRANSLATE_LANG1;
         } else if (btn1.pressed) {
             new_state = APP_GPIO_STATE_TRANSLATE_LANG1;
@@ -141,9 +186,16 @@ static void app_gpio_task(void *args)
         } else {
             new_state = APP_GPIO_STATE_IDLE;
         }
+#if CONFIG_APP_KWS
+        app_gpio_state_t voice = app_gpio_voice_state(btn1_edge_press || btn2_edge_press);
+        if (!conversation && new_state == APP_GPIO_STATE_IDLE) {
+            new_state = voice;
+        }
+#endif
 
         if (new_state != gpio_get_state()) {
             app_gpio_set_state(new_state);
+            display_notify_status();
             ESP_LOGI(TAG, "state -> %d", new_state);
         }
 
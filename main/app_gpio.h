@@ -1,6 +1,9 @@
 #pragma once
 
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "driver/gpio.h"
+#endif
 
 
 #ifndef APP_GPIO_BUTTON1_PIN
@@ -17,8 +20,12 @@ typedef enum {
     APP_GPIO_STATE_IDLE = 0,
     APP_GPIO_STATE_TRANSLATE_LANG1,
     APP_GPIO_STATE_TRANSLATE_LANG2,
+    APP_GPIO_STATE_CONVERSATION,     // both languages at once, APP_AUDIO_CONVERSATION
 } app_gpio_state_t;
 
 
 app_gpio_state_t gpio_get_state(void);
+/* a spoken keyword (APP_KWS): holds state with the buttons released for APP_KWS_LISTEN_MS, until a
+ * button press or the next keyword; APP_GPIO_STATE_IDLE ends it */
+void gpio_voice_trigger(app_gpio_state_t state);
 void gpio_make_tasks(void);
@@ -0,0 +1,269 @@
+/* Eric Liu 2026
+
+Stand-ins for the hardware tasks on the ESP-IDF linux target, so app_tcp.c
+can run on a PC against the real server.
+
+Audio is a triangle tone in the I2S frame format (16 kHz, 24 bit data left
+aligned in 32 bit slots, the right mic inverted) written to audio_rb as
+tagged records at the real chunk rate, in the slot layout i2s_read_task would
+capture. The button state is TRANSLATE_LANG1, or alternates with LANG2 every
+HOST_SWITCH_MS milliseconds if that is set. With APP_AUDIO_CONVERSATION and
+HOST_CONVERSATION set it is CONVERSATION instead: HOST_SWITCH_MS (default
+3000) long turns of silence, the subject talking (tone on both mics) and the
+wearer talking (tone on the right mic, 12 dB less on the left) go round, and
+the chunks are tagged by the same detectors i2s_read_task runs. With
+APP_AUDIO_MEL the chunks become log-mel records like i2s_read_task makes. Captions are printed to stdout.
+RSSI comes from the HOST_RSSI environment variable (default -50 dBm), read on
+every call, to drive the audio quality controller by hand.
+
+Same public functions as app_audio.c, app_gpio.c, app_display.c and
+wifi_get_rssi from app_wifi.c, so app_main starts this build like the firmware.
+
+INPUTS: text_rb
+OUTPUTS: ringbuffer audio_rb, captions on stdout
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "app_audio.h"
+#include "app_display.h"
+#include "app_gpio.h"
+#include "app_mel.h"
+#include "app_tcp.h"
+#include "app_vad.h"
+#include "app_wifi.h"
+
+#define HOST_AUDIO_RB_SIZE 32768
+#define HOST_TONE_PERIOD   36    // samples, ~444 Hz
+#define HOST_TURN_MS       3000  // conversation turns without HOST_SWITCH_MS
+
+static const char *TAG = "host";
+
+static RingbufHandle_t audio_rb;
+static volatile audio_stats_t stats;
+static TaskHandle_t caption_task_handle;
+#if CONFIG_APP_AUDIO_MEL
+static mel_t mel;
+static int16_t mel_out[(AUDIO_CHUNK_FRAMES / MEL_HOP + 1) * MEL_BINS];
+static uint8_t mel_mic;
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+static vad_t vad[2];
+#endif
+
+RingbufHandle_t audio_get_rb(void)
+{
+    assert(audio_rb);
+    return audio_rb;
+}
+
+void audio_get_stats(audio_stats_t *out)
+{
+    *out = stats;
+}
+
+static uint32_t host_switch_ms(void)
+{
+    const char *ms = getenv("HOST_SWITCH_MS");
+    return ms && atoi(ms) > 0 ? (uint32_t)atoi(ms) : 0;
+}
+
+/* tone gain of each mic in quarters: the talker's turn in conversation mode, else both full */
+static void host_gains(uint8_t lang, int32_t gain[2])
+{
+    gain[0] = 4;
+    gain[1] = 4;
+    if (lang != AUDIO_LANG_BOTH) {
+        return;
+    }
+    uint32_t turn_ms = host_switch_ms() ? host_switch_ms() : HOST_TURN_MS;
+    switch ((esp_timer_get_time() / 1000 / turn_ms) % 3) {
+    case 0:
+        gain[0] = 0;
+        gain[1] = 0;
+        break;
+    case 2:
+        gain[0] = 1;
+        break;
+    default:
+        break;
+    }
+}
+
+#if CONFIG_APP_AUDIO_CONVERSATION
+/* tags a conversation mode chunk with the languages that have voice, as audio_vad does */
+static void host_vad(audio_rec_t *rec, const int32_t *slots)
+{
+    if (rec->lang != AUDIO_LANG_BOTH) {
+        return;
+    }
+    uint32_t left = vad_level(slots, AUDIO_CHUNK_FRAMES, 2);
+    uint32_t right = vad_level(slots + 1, AUDIO_CHUNK_FRAMES, 2);
+    uint8_t lang = 0;
+    if (vad_update(&vad[0], left, right)) {
+        lang |= MSG_FLAG_LANG1;
+        stats.voiced[0]++;
+    }
+    if (vad_update(&vad[1], right, left)) {
+        lang |= MSG_FLAG_LANG2;
+        stats.voiced[1]++;
+    }
+    stats.conv_chunks++;
+    rec->lang = lang;
+}
+#endif
+
+static void host_audio_task(void *args)
+{
+    static uint32_t mem[(sizeof(audio_rec_t) + AUDIO_CHUNK_FRAMES * CODEC_RAW_FRAME) / sizeof(uint32_t)];
+    audio_rec_t *rec = (audio_rec_t *)mem;
+    int32_t *slot = (int32_t *)rec->data;
+    const TickType_t period = pdMS_TO_TICKS(AUDIO_CHUNK_FRAMES * 1000 / AUDIO_CAPTURE_RATE);
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t phase = 0;
+    uint8_t cur_slots = CODEC_SLOTS_STEREO;
+#if CONFIG_APP_AUDIO_MEL
+    mel_init(&mel);
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+    uint32_t chunk_ms = AUDIO_CHUNK_FRAMES * 1000 / AUDIO_CAPTURE_RATE;
+    uint16_t hang = (uint16_t)((CONFIG_APP_AUDIO_VAD_HANG_MS + chunk_ms - 1) / chunk_ms);
+    vad_init(&vad[0], CONFIG_APP_AUDIO_VAD_THRESHOLD_DB, AUDIO_VAD_FORWARD_LEAD_DB, hang);
+    vad_init(&vad[1], CONFIG_APP_AUDIO_VAD_THRESHOLD_DB, AUDIO_VAD_WEARER_LEAD_DB, hang);
+#endif
+    while (1) {
+        rec->lang = audio_state_lang(gpio_get_state());
+        uint8_t slots = audio_lang_slots(rec->lang);
+        if (slots != cur_slots && stats.chunks > 0) {
+            stats.slot_switches++;
+        }
+        cur_slots = slots;
+        rec->slots = slots;
+        int32_t gain[2];
+        host_gains(rec->lang, gain);
+        size_t n = 0;
+        for (int i = 0; i < AUDIO_CHUNK_FRAMES; i++) {
+            int32_t tri = (int32_t)(phase < HOST_TONE_PERIOD / 2 ? phase : HOST_TONE_PERIOD - phase);
+            int32_t sample = (tri * 2 - HOST_TONE_PERIOD / 2) * (0x100000 / HOST_TONE_PERIOD);
+            if (rec->slots != CODEC_SLOTS_RIGHT) {
+                slot[n++] = sample * gain[0] * 64;    // left aligned like the I2S slots
+            }
+            if (rec->slots != CODEC_SLOTS_LEFT) {
+                slot[n++] = -sample * gain[1] * 64;
+            }
+            phase = (phase + 1) % HOST_TONE_PERIOD;
+        }
+        rec->len = (uint16_t)(n * sizeof(int32_t));
+        rec->ts_us = (uint32_t)esp_timer_get_time();
+        stats.chunks++;
+#if CONFIG_APP_AUDIO_CONVERSATION
+        host_vad(rec, slot);
+#endif
+#if CONFIG_APP_AUDIO_MEL
+        int64_t start = esp_timer_get_time();
+        uint8_t mic = slots == CODEC_SLOTS_STEREO ? rec->lang == MSG_FLAG_LANG2 : slots == CODEC_SLOTS_RIGHT;
+        if (mic != mel_mic) {
+            mel_reset(&mel);
+            mel_mic = mic;
+        }
+        bool stereo = slots == CODEC_SLOTS_STEREO;
+        size_t frames = mel_push(&mel, slot + (stereo ? mic : 0), AUDIO_CHUNK_FRAMES, stereo ? 2 : 1, mel_out);
+        memcpy(rec->data, mel_out, frames * MEL_FRAME_BYTES);
+        rec->slots = CODEC_SLOTS_MEL;
+        rec->len = (uint16_t)(frames * MEL_FRAME_BYTES);
+        stats.mel_frames += frames;
+        stats.mel_us += (uint32_t)(esp_timer_get_time() - start);
+        if (frames == 0) {
+            xTaskDelayUntil(&wake, period);
+            continue;
+        }
+#endif
+        if (xRingbufferSend(audio_rb, rec, sizeof(*rec) + rec->len, 0) != pdTRUE) {
+            ESP_LOGD(TAG, "failed ringbuffer push");
+            stats.dropped_newest++;
+        }
+        xTaskDelayUntil(&wake, period);
+    }
+}
+
+void audio_make_tasks(void)
+{
+    audio_rb = xRingbufferCreate(HOST_AUDIO_RB_SIZE, RINGBUF_TYPE_NOSPLIT);
+    assert(audio_rb);
+    xTaskCreatePinnedToCore(host_audio_task, "host_audio_task", 4096, NULL, 8, NULL, 0);
+}
+
+int8_t wifi_get_rssi(void)
+{
+    const char *rssi = getenv("HOST_RSSI");
+    return rssi ? (int8_t)atoi(rssi) : -50;
+}
+
+app_gpio_state_t gpio_get_state(void)
+{
+#if CONFIG_APP_AUDIO_CONVERSATION
+    if (getenv("HOST_CONVERSATION")) {
+        return APP_GPIO_STATE_CONVERSATION;
+    }
+#endif
+    uint32_t ms = host_switch_ms();
+    if (ms > 0 && (esp_timer_get_time() / 1000 / ms) % 2) {
+        return APP_GPIO_STATE_TRANSLATE_LANG2;
+    }
+    return APP_GPIO_STATE_TRANSLATE_LANG1;
+}
+
+void gpio_make_tasks(void)
+{
+}
+
+static void host_caption_task(void *args)
+{
+    RingbufHandle_t text_rb = NULL;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (text_rb == NULL) {
+            text_rb = tcp_rx_get_text_rb();
+            if (text_rb == NULL) {
+                continue;
+            }
+        }
+        size_t size = 0;
+        text_rec_t *rec;
+        while ((rec = (text_rec_t *)xRingbufferReceive(text_rb, &size, 0)) != NULL) {
+            if (rec->len > 0) {
+                printf("[%s%s] %s\n", (rec->flags & MSG_FLAG_SCREEN1) ? "1" : "",
+                       (rec->flags & MSG_FLAG_SCREEN2) ? "2" : "", rec->text);
+                fflush(stdout);
+            }
+            vRingbufferReturnItem(text_rb, rec);
+        }
+    }
+}
+
+void display_make_tasks(void)
+{
+    xTaskCreatePinnedToCore(host_caption_task, "host_caption_task", 4096, NULL, 5, &caption_task_handle, 0);
+}
+
+void display_notify_text(void)
+{
+    if (caption_task_handle) {
+        xTaskNotifyGive(caption_task_handle);
+    }
+}
+
+void display_notify_status(void)
+{
+    ESP_LOGI(TAG, "status: %s", tcp_server_busy() ? "BUSY" : "RDY");
+}
@@ -0,0 +1,490 @@
+/* Eric Liu 2026
+
+Keyword spotter for hands-free triggering. Front end: the log-mel frames of
+app_mel (25 ms windows every 10 ms, 80 Slaney bins to 8 kHz), every second
+one turned into KWS_MFCC cepstral coefficients by an orthonormal DCT-II, so
+a feature frame is 20 ms like the usual 49 x 10 MFCC input of small KWS
+models. The last in_frames of them are the model's input window.
+
+The model is a plain chain of int8 layers: convolution, depthwise
+convolution, global average pooling and fully connected, each with an int32
+bias and an optional ReLU. All scales are powers of two: a layer's int32
+accumulator becomes its int8 output by a rounded right shift, so inference
+is integer multiply-adds and shifts only. Activations are height (frames) x
+width (coefficients) x channels, the layout TF uses, and ping-pong between
+two buffers sized for the largest layer. Softmax over the last layer's
+logits gives class probabilities.
+
+A detection is a keyword class (a label not starting with '_') whose
+probability averaged over the last KWS_SMOOTH inferences reaches the
+threshold; then nothing fires for KWS_REFRACTORY_MS. Inference runs every
+period feature frames, which budget pacing (kws_pace) raises while the
+spotter takes more than its share of the core.
+
+Model blob (tools/kws_export.py), little endian:
+    "KWS1", u8 layers, u8 classes, u8 in_frames, u8 KWS_MFCC, u8 in_shift,
+    s8 out_frac, 6 bytes 0
+    classes x KWS_LABEL_LEN byte labels
+    per layer: u8 op, kh, kw, sh, sw, same, relu, shift; u16 out_c; 2 bytes 0;
+    int8 weights padded to 4 bytes, s32 bias x out_c (none for KWS_OP_AVGPOOL)
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: 16 kHz 24 bit I2S slots of one mic
+OUTPUTS: keyword detections
+
+*/
+
+#include "app_kws.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWS_MAGIC "KWS1"
+#define KWS_HDR_SIZE 16
+#define KWS_LAYER_HDR_SIZE 12
+#define KWS_REFRACTORY_MS 1000
+#define KWS_START_PERIOD 2               // 40 ms until pacing has measured
+#define KWS_PACE_US 1000000              // pacing decision per second of audio
+#define KWS_PUSH_MAX (4 * MEL_HOP)       // samples per mel_push, fills at most mel_out
+#define KWS_PI 3.14159265358979
+
+static uint16_t le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static int32_t le32(const uint8_t *p)
+{
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/* output length and leading padding of a kernel along one axis, TF style */
+static uint16_t kws_out_len(uint16_t in, uint8_t k, uint8_t s, bool same)
+{
+    if (same) {
+        return (uint16_t)((in + s - 1) / s);
+    }
+    return in >= k ? (uint16_t)((in - k) / s + 1) : 0;
+}
+
+static int kws_pad(uint16_t in, uint16_t out, uint8_t k, uint8_t s, bool same)
+{
+    if (!same) {
+        return 0;
+    }
+    int total = (out - 1) * s + k - in;
+    return total > 0 ? total / 2 : 0;
+}
+
+/* walks the layers of the blob, fills in their shapes; false if anything is off */
+static bool kws_parse_layers(kws_t *k, const uint8_t *blob, size_t len, size_t pos)
+{
+    uint16_t h = k->in_frames;
+    uint16_t w = KWS_MFCC;
+    uint16_t c = 1;
+    size_t act = (size_t)h * w;
+    for (int i = 0; i < k->n_layers; i++) {
+        if (pos + KWS_LAYER_HDR_SIZE > len) {
+            return false;
+        }
+        const uint8_t *p = blob + pos;
+        kws_layer_t *l = &k->layers[i];
+        l->op = p[0];
+        l->kh = p[1];
+        l->kw = p[2];
+        l->sh = p[3];
+        l->sw = p[4];
+        l->same = p[5];
+        l->relu = p[6];
+        l->shift = p[7];
+        l->out_c = le16(p + 8);
+        l->in_h = h;
+        l->in_w = w;
+        l->in_c = c;
+        pos += KWS_LAYER_HDR_SIZE;
+        if (l->shift > 31) {
+            return false;
+        }
+        size_t weights;
+        switch (l->op) {
+        case KWS_OP_CONV:
+        case KWS_OP_DWCONV:
+            if (l->kh == 0 || l->kw == 0 || l->sh == 0 || l->sw == 0 || l->out_c == 0) {
+                return false;
+            }
+            if (l->op == KWS_OP_DWCONV && l->out_c != c) {
+                return false;
+            }
+            l->out_h = kws_out_len(h, l->kh, l->sh, l->same);
+            l->out_w = kws_out_len(w, l->kw, l->sw, l->same);
+            weights = (size_t)l->kh * l->kw * (l->op == KWS_OP_CONV ? (size_t)l->out_c * c : c);
+            break;
+        case KWS_OP_AVGPOOL:
+            l->out_h = 1;
+            l->out_w = 1;
+            l->out_c = c;
+            weights = 0;
+            break;
+        case KWS_OP_FC:
+            if (l->out_c == 0) {
+                return false;
+            }
+            l->out_h = 1;
+            l->out_w = 1;
+            weights = (size_t)l->out_c * h * w * c;
+            break;
+        default:
+            return false;
+        }
+        if (l->out_h == 0 || l->out_w == 0) {
+            return false;
+        }
+        size_t bias = l->op == KWS_OP_AVGPOOL ? 0 : (size_t)l->out_c * 4;
+        size_t padded = (weights + 3) & ~(size_t)3;
+        if (pos + padded + bias > len) {
+            return false;
+        }
+        l->weights = (const int8_t *)(blob + pos);
+        l->bias = blob + pos + padded;
+        pos += padded + bias;
+        h = l->out_h;
+        w = l->out_w;
+        c = l->out_c;
+        size_t out = (size_t)h * w * c;
+        act = out > act ? out : act;
+    }
+    const kws_layer_t *last = &k->layers[k->n_layers - 1];
+    if (pos != len || last->op != KWS_OP_FC || last->relu || last->out_c != k->n_classes) {
+        return false;
+    }
+    k->act_size = act;
+    return true;
+}
+
+bool kws_init(kws_t *k, const uint8_t *blob, size_t len, uint8_t threshold)
+{
+    memset(k, 0, sizeof(*k));
+    if (len < KWS_HDR_SIZE || memcmp(blob, KWS_MAGIC, 4)) {
+        return false;
+    }
+    k->n_layers = blob[4];
+    k->n_classes = blob[5];
+    k->in_frames = blob[6];
+    k->in_shift = blob[8];
+    k->out_frac = (int8_t)blob[9];
+    if (k->n_layers == 0 || k->n_layers > KWS_MAX_LAYERS || k->n_classes < 2 || k->n_classes > KWS_MAX_CLASSES
+        || k->in_frames == 0 || k->in_frames > KWS_MAX_FRAMES || blob[7] != KWS_MFCC || k->in_shift > 15) {
+        return false;
+    }
+    size_t pos = KWS_HDR_SIZE;
+    if (pos + (size_t)k->n_classes * KWS_LABEL_LEN > len) {
+        return false;
+    }
+    for (int i = 0; i < k->n_classes; i++) {
+        memcpy(k->labels[i], blob + pos, KWS_LABEL_LEN);
+        k->labels[i][KWS_LABEL_LEN - 1] = '\0';
+        pos += KWS_LABEL_LEN;
+    }
+    if (!kws_parse_layers(k, blob, len, pos)) {
+        return false;
+    }
+    k->act[0] = (int8_t *)malloc(k->act_size);
+    k->act[1] = (int8_t *)malloc(k->act_size);
+    if (!k->act[0] || !k->act[1]) {
+        kws_free(k);
+        return false;
+    }
+    kws_init_features(k);
+    k->threshold = threshold;
+    k->period = KWS_START_PERIOD;
+    kws_restart(k);
+    return true;
+}
+
+void kws_init_features(kws_t *k)
+{
+    for (int i = 0; i < KWS_MFCC; i++) {
+        double scale = sqrt((i == 0 ? 1.0 : 2.0) / MEL_BINS);
+        for (int n = 0; n < MEL_BINS; n++) {
+            k->dct[i][n] = (float)(scale * cos(KWS_PI * i * (n + 0.5) / MEL_BINS));
+        }
+    }
+    mel_init(&k->mel);
+}
+
+void kws_free(kws_t *k)
+{
+    free(k->act[0]);
+    free(k->act[1]);
+    k->act[0] = NULL;
+    k->act[1] = NULL;
+}
+
+void kws_restart(kws_t *k)
+{
+    mel_reset(&k->mel);
+    k->mel_phase = 0;
+    k->feat_count = 0;
+    k->since = 0;
+    k->refractory = 0;
+    k->prob_n = 0;
+    k->prob_i = 0;
+}
+
+void kws_mfcc(const kws_t *k, const int16_t *mel, int16_t *mfcc)
+{
+    for (int i = 0; i < KWS_MFCC; i++) {
+        float acc = 0.0f;
+        for (int n = 0; n < MEL_BINS; n++) {
+            acc += k->dct[i][n] * mel[n];
+        }
+        float q = acc * ((float)(1 << KWS_MFCC_Q) / (1 << MEL_Q));
+        mfcc[i] = (int16_t)(q > INT16_MAX ? INT16_MAX : (q < INT16_MIN ? INT16_MIN : lrintf(q)));
+    }
+}
+
+static int8_t kws_requant(int32_t acc, uint8_t shift, bool relu)
+{
+    int64_t v = acc;
+    if (shift > 0) {
+        v = (v + (1LL << (shift - 1))) >> shift;
+    }
+    int64_t lo = relu ? 0 : -128;
+    return (int8_t)(v < lo ? lo : (v > 127 ? 127 : v));
+}
+
+static void kws_conv(const kws_layer_t *l, const int8_t *in, int8_t *out)
+{
+    int pt = kws_pad(l->in_h, l->out_h, l->kh, l->sh, l->same);
+    int pl = kws_pad(l->in_w, l->out_w, l->kw, l->sw, l->same);
+    size_t kernel = (size_t)l->kh * l->kw * l->in_c;
+    for (int oy = 0; oy < l->out_h; oy++) {
+        for (int ox = 0; ox < l->out_w; ox++) {
+            int y0 = oy * l->sh - pt;
+            int x0 = ox * l->sw - pl;
+            for (int oc = 0; oc < l->out_c; oc++) {
+                const int8_t *w = l->weights + oc * kernel;
+                int32_t acc = le32(l->bias + oc * 4);
+                for (int ky = 0; ky < l->kh; ky++) {
+                    int y = y0 + ky;
+                    if (y < 0 || y >= l->in_h) {
+                        continue;
+                    }
+                    for (int kx = 0; kx < l->kw; kx++) {
+                        int x = x0 + kx;
+                        if (x < 0 || x >= l->in_w) {
+                            continue;
+                        }
+                        const int8_t *px = in + (y * l->in_w + x) * l->in_c;
+                        const int8_t *wk = w + (ky * l->kw + kx) * l->in_c;
+                        for (int ic = 0; ic < l->in_c; ic++) {
+                            acc += px[ic] * wk[ic];
+                        }
+                    }
+                }
+                out[(oy * l->out_w + ox) * l->out_c + oc] = kws_requant(acc, l->shift, l->relu);
+            }
+        }
+    }
+}
+
+static void kws_dwconv(const kws_layer_t *l, const int8_t *in, int8_t *out)
+{
+    int pt = kws_pad(l->in_h, l->out_h, l->kh, l->sh, l->same);
+    int pl = kws_pad(l->in_w, l->out_w, l->kw, l->sw, l->same);
+    int c = l->in_c;
+    for (int oy = 0; oy < l->out_h; oy++) {
+        for (int ox = 0; ox < l->out_w; ox++) {
+            int y0 = oy * l->sh - pt;
+            int x0 = ox * l->sw - pl;
+            int8_t *o = out + (oy * l->out_w + ox) * c;
+            for (int ch = 0; ch < c; ch++) {
+                int32_t acc = le32(l->bias + ch * 4);
+                for (int ky = 0; ky < l->kh; ky++) {
+                    int y = y0 + ky;
+                    if (y < 0 || y >= l->in_h) {
+                        continue;
+                    }
+                    for (int kx = 0; kx < l->kw; kx++) {
+                        int x = x0 + kx;
+                        if (x < 0 || x >= l->in_w) {
+                            continue;
+                        }
+                        acc += in[(y * l->in_w + x) * c + ch] * l->weights[(ky * l->kw + kx) * c + ch];
+                    }
+                }
+                o[ch] = kws_requant(acc, l->shift, l->relu);
+            }
+        }
+    }
+}
+
+static void kws_avgpool(const kws_layer_t *l, const int8_t *in, int8_t *out)
+{
+    int32_t n = l->in_h * l->in_w;
+    for (int ch = 0; ch < l->in_c; ch++) {
+        int32_t sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += in[i * l->in_c + ch];
+        }
+        int32_t v = (sum >= 0 ? sum + n / 2 : sum - n / 2) / n;
+        out[ch] = (int8_t)(v < -128 ? -128 : (v > 127 ? 127 : v));
+    }
+}
+
+static void kws_fc(const kws_layer_t *l, const int8_t *in, int8_t *out)
+{
+    size_t n = (size_t)l->in_h * l->in_w * l->in_c;
+    for (int oc = 0; oc < l->out_c; oc++) {
+        const int8_t *w = l->weights + oc * n;
+        int32_t acc = le32(l->bias + oc * 4);
+        for (size_t i = 0; i < n; i++) {
+            acc += in[i] * w[i];
+        }
+        out[oc] = kws_requant(acc, l->shift, l->relu);
+    }
+}
+
+void kws_infer(kws_t *k, const int8_t *input, float *prob)
+{
+    const int8_t *in = input;
+    int8_t *out = k->act[0];
+    for (int i = 0; i < k->n_layers; i++) {
+        const kws_layer_t *l = &k->layers[i];
+        switch (l->op) {
+        case KWS_OP_CONV:
+            kws_conv(l, in, out);
+            break;
+        case KWS_OP_DWCONV:
+            kws_dwconv(l, in, out);
+            break;
+        case KWS_OP_AVGPOOL:
+            kws_avgpool(l, in, out);
+            break;
+        default:
+            kws_fc(l, in, out);
+            break;
+        }
+        in = out;
+        out = out == k->act[0] ? k->act[1] : k->act[0];
+    }
+    float max = -1e30f;
+    for (int c = 0; c < k->n_classes; c++) {
+        prob[c] = ldexpf((float)in[c], -k->out_frac);
+        max = prob[c] > max ? prob[c] : max;
+    }
+    float sum = 0.0f;
+    for (int c = 0; c < k->n_classes; c++) {
+        prob[c] = expf(prob[c] - max);
+        sum += prob[c];
+    }
+    for (int c = 0; c < k->n_classes; c++) {
+        prob[c] /= sum;
+    }
+    k->inferences++;
+}
+
+/* smoothed probabilities of the last inferences; the keyword that reaches the threshold */
+static int kws_decide(kws_t *k, const float *prob)
+{
+    memcpy(k->prob[k->prob_i], prob, k->n_classes * sizeof(float));
+    k->prob_i = (uint8_t)((k->prob_i + 1) % KWS_SMOOTH);
+    if (k->prob_n < KWS_SMOOTH) {
+        k->prob_n++;
+    }
+    int best = KWS_NONE;
+    float best_p = 0.0f;
+    for (int c = 0; c < k->n_classes; c++) {
+        if (k->labels[c][0] == '_') {
+            continue;
+        }
+        float p = 0.0f;
+        for (int i = 0; i < k->prob_n; i++) {
+            p += k->prob[i][c];
+        }
+        p /= k->prob_n;
+        if (p > best_p) {
+            best_p = p;
+            best = c;
+        }
+    }
+    k->last_prob = best_p;
+    if (k->refractory > 0 || k->prob_n < KWS_SMOOTH || best_p * 100.0f < k->threshold) {
+        return KWS_NONE;
+    }
+    k->refractory = KWS_REFRACTORY_MS / KWS_FRAME_MS;
+    k->prob_n = 0;
+    k->detections++;
+    return best;
+}
+
+/* a new feature frame of Q8 MFCC into the input window; runs the model when one is due */
+static int kws_frame(kws_t *k, const int16_t *mfcc)
+{
+    if (k->feat_count == k->in_frames) {
+        memmove(k->feat, k->feat + KWS_MFCC, (size_t)(k->in_frames - 1) * KWS_MFCC);
+        k->feat_count--;
+    }
+    int8_t *f = k->feat + k->feat_count * KWS_MFCC;
+    for (int i = 0; i < KWS_MFCC; i++) {
+        int32_t v = mfcc[i];
+        if (k->in_shift > 0) {
+            v = (v + (1 << (k->in_shift - 1))) >> k->in_shift;
+        }
+        f[i] = (int8_t)(v < -128 ? -128 : (v > 127 ? 127 : v));
+    }
+    k->feat_count++;
+    k->frames++;
+    if (k->refractory > 0) {
+        k->refractory--;
+    }
+    if (++k->since < k->period || k->feat_count < k->in_frames) {
+        return KWS_NONE;
+    }
+    k->since = 0;
+    float prob[KWS_MAX_CLASSES];
+    kws_infer(k, k->feat, prob);
+    return kws_decide(k, prob);
+}
+
+int kws_push(kws_t *k, const int32_t *slots, size_t n, size_t stride)
+{
+    int hit = KWS_NONE;
+    for (size_t off = 0; off < n; off += KWS_PUSH_MAX) {
+        size_t m = n - off < KWS_PUSH_MAX ? n - off : KWS_PUSH_MAX;
+        size_t frames = mel_push(&k->mel, slots + off * stride, m, stride, k->mel_out);
+        for (size_t i = 0; i < frames; i++) {
+            if (++k->mel_phase < KWS_FRAME_STEP) {
+                continue;
+            }
+            k->mel_phase = 0;
+            int16_t mfcc[KWS_MFCC];
+            kws_mfcc(k, k->mel_out + i * MEL_BINS, mfcc);
+            int c = kws_frame(k, mfcc);
+            if (hit == KWS_NONE) {
+                hit = c;
+            }
+        }
+    }
+    return hit;
+}
+
+void kws_pace(kws_t *k, uint32_t used_us, uint32_t audio_us, uint8_t budget_pct)
+{
+    k->pace_used_us += used_us;
+    k->pace_audio_us += audio_us;
+    if (k->pace_audio_us < KWS_PACE_US) {
+        return;
+    }
+    uint32_t budget = (uint32_t)((uint64_t)k->pace_audio_us * budget_pct / 100);
+    if (k->pace_used_us > budget && k->period < KWS_MAX_PERIOD) {
+        k->period++;
+    } else if (k->pace_used_us < budget / 2 && k->period > 1) {
+        k->period--;
+    }
+    k->pace_used_us = 0;
+    k->pace_audio_us = 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "app_mel.h"
+
+/* Keyword spotter: MFCC front end and a small int8 CNN / DS-CNN, streaming */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KWS_MFCC 10                      // coefficients per feature frame
+#define KWS_MFCC_Q 8                     // front end output is Q8
+#define KWS_FRAME_STEP 2                 // mel frames (10 ms) per feature frame, 20 ms
+#define KWS_FRAME_MS (KWS_FRAME_STEP * MEL_HOP * 1000 / MEL_RATE)
+#define KWS_MAX_FRAMES 64                // model window, feature frames
+#define KWS_MAX_CLASSES 8
+#define KWS_LABEL_LEN 12                 // with the terminating 0
+#define KWS_MAX_LAYERS 16
+#define KWS_SMOOTH 3                     // inferences averaged per decision
+#define KWS_MAX_PERIOD 8                 // budget pacing: an inference every 1..8 feature frames
+#define KWS_NONE (-1)
+
+/* layer ops of the model blob */
+#define KWS_OP_CONV    1                 // kh x kw convolution, out_c x kh x kw x in_c weights
+#define KWS_OP_DWCONV  2                 // depthwise kh x kw, kh x kw x c weights
+#define KWS_OP_AVGPOOL 3                 // global average, no weights
+#define KWS_OP_FC      4                 // fully connected on the flattened input, out_c x in weights
+
+typedef struct {
+    uint8_t op;
+    uint8_t kh, kw;                      // kernel: feature frames x coefficients
+    uint8_t sh, sw;                      // stride
+    uint8_t same;                        // TF "same" padding, else "valid"
+    uint8_t relu;
+    uint8_t shift;                       // accumulator to output scale, rounded right shift
+    uint16_t in_h, in_w, in_c;
+    uint16_t out_h, out_w, out_c;
+    const int8_t *weights;
+    const uint8_t *bias;                 // out_c little endian s32 in accumulator scale; may be unaligned
+} kws_layer_t;
+
+typedef struct {
+    /* model, pointing into the blob */
+    kws_layer_t layers[KWS_MAX_LAYERS];
+    uint8_t n_layers;
+    uint8_t n_classes;
+    uint8_t in_frames;                   // model window, feature frames
+    uint8_t in_shift;                    // Q8 MFCC to model input, rounded right shift
+    int8_t out_frac;                     // logits are q / 2^out_frac
+    char labels[KWS_MAX_CLASSES][KWS_LABEL_LEN];
+    int8_t *act[2];                      // activations, ping-pong
+    size_t act_size;
+    /* front end */
+    mel_t mel;
+    float dct[KWS_MFCC][MEL_BINS];       // orthonormal DCT-II
+    int16_t mel_out[5 * MEL_BINS];
+    uint8_t mel_phase;                   // mel frames since the last feature frame
+    int8_t feat[KWS_MAX_FRAMES * KWS_MFCC]; // model input window, oldest frame first
+    uint16_t feat_count;                 // frames in it, up to in_frames
+    /* detector */
+    uint8_t threshold;                   // percent
+    uint8_t period;                      // feature frames per inference
+    uint8_t since;                       // feature frames since the last inference
+    uint16_t refractory;                 // feature frames before the next detection may fire
+    float prob[KWS_SMOOTH][KWS_MAX_CLASSES];
+    uint8_t prob_n;
+    uint8_t prob_i;
+    /* pacing */
+    uint32_t pace_used_us;
+    uint32_t pace_audio_us;
+    /* counters */
+    uint32_t frames;
+    uint32_t inferences;
+    uint32_t detections;
+    float last_prob;                     // best keyword probability of the last inference
+} kws_t;
+
+/* model blob from tools/kws_export.py, which has to outlive k; the activation buffers are
+ * allocated. threshold: smoothed probability in percent a keyword needs. False for a blob
+ * that does not parse or out of memory */
+bool kws_init(kws_t *k, const uint8_t *blob, size_t len, uint8_t threshold);
+void kws_free(kws_t *k);
+
+/* the front end alone, no model: kws_mfcc on the frames of k->mel, to make training features */
+void kws_init_features(kws_t *k);
+
+/* audio stopped: features and detector start over */
+void kws_restart(kws_t *k);
+
+/* n 16 kHz samples of a 24 bit left aligned I2S slot, stride apart; returns the class of a
+ * keyword detected in them or KWS_NONE. Labels starting with '_' (silence, unknown) never fire */
+int kws_push(kws_t *k, const int32_t *slots, size_t n, size_t stride);
+
+/* budget pacing, after every kws_push: used_us of CPU for audio_us of audio. Inferences run
+ * less often while kws takes more than budget_pct of a core, more often once well under */
+void kws_pace(kws_t *k, uint32_t used_us, uint32_t audio_us, uint8_t budget_pct);
+
+/* one frame of Q8 MFCC from MEL_BINS log-mel values (app_mel.h Q10) */
+void kws_mfcc(const kws_t *k, const int16_t *mel, int16_t *mfcc);
+
+/* runs the model on in_frames x KWS_MFCC model input (Q8 MFCC >> in_shift), softmax
+ * probabilities of the n_classes into prob */
+void kws_infer(kws_t *k, const int8_t *input, float *prob);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+/* Eric Liu 2026
+
+Log-mel features for Whisper, computed on the headset so the server can skip
+its own front end. Matches whisper/audio.py log_mel_spectrogram: 400 point
+STFT (25 ms periodic Hann window) every 160 samples (10 ms), power spectrum,
+the 80 filter Slaney mel bank librosa makes for 16 kHz (what Whisper ships in
+mel_filters.npz), then log10 with a 1e-10 floor. Whisper's last two steps,
+clamping to 8 below the largest value and (x + 4) / 4, need the whole
+30 s window, so they stay with the server.
+
+The 400 point real FFT is a 200 point complex FFT of the even/odd sample
+pairs plus a split step. 200 = 4 * 2 * 5 * 5 is not a power of two, so the
+complex FFT is mixed radix, decimation in time (radix 4 and 2 butterflies, a
+plain DFT for the radix 5 stages). Each spectrum bin lies on the rising edge
+of one triangle and the falling edge of the one before, so the filterbank is
+two multiply-adds per bin rather than an 80 x 201 matrix.
+
+Frames are log10 of the mel power in Q10 (MEL_Q), audio scaled like Whisper's
+(s16 / 32768). Streaming starts with half a window of silence, so frame t is
+centred on sample 160 t as in Whisper's padded STFT; only the first two
+frames differ (zeros instead of its reflected padding).
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: 16 kHz 24 bit I2S slots
+OUTPUTS: MEL_BINS s16 log-mel values per 10 ms
+
+*/
+
+#include "app_mel.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MEL_PI 3.14159265358979
+#define MEL_POWER_FLOOR 1e-10f
+#define MEL_SLOT_SCALE (1.0f / 2147483648.0f)   // left aligned slot to Whisper's [-1, 1)
+
+/* Slaney mel scale: linear to 1 kHz, logarithmic above */
+static double hz_to_mel(double hz)
+{
+    if (hz < 1000.0) {
+        return hz * 3.0 / 200.0;
+    }
+    return 15.0 + log(hz / 1000.0) * 27.0 / log(6.4);
+}
+
+static double mel_to_hz(double mel)
+{
+    if (mel < 15.0) {
+        return mel * 200.0 / 3.0;
+    }
+    return 1000.0 * exp((mel - 15.0) * log(6.4) / 27.0);
+}
+
+/* librosa.filters.mel(sr=16000, n_fft=400, n_mels=80): triangles between MEL_BINS + 2 points
+ * evenly spaced in mel from 0 to 8 kHz, each scaled to unit area (norm="slaney") */
+static void mel_init_filters(mel_t *m)
+{
+    double f[MEL_BINS + 2];
+    double top = hz_to_mel(MEL_RATE / 2.0);
+    for (int i = 0; i < MEL_BINS + 2; i++) {
+        f[i] = mel_to_hz(top * i / (MEL_BINS + 1));
+    }
+    int seg = 0;
+    for (int k = 0; k < MEL_SPEC_BINS; k++) {
+        double hz = (double)k * MEL_RATE / MEL_N_FFT;
+        while (seg < MEL_BINS && hz >= f[seg + 1]) {
+            seg++;
+        }
+        /* rising edge of filter seg, falling edge of filter seg - 1 */
+        double width = f[seg + 1] - f[seg];
+        double up = (hz - f[seg]) / width;
+        double down = (f[seg + 1] - hz) / width;
+        m->bin_seg[k] = (uint8_t)seg;
+        m->bin_up[k] = seg < MEL_BINS ? (float)(up * 2.0 / (f[seg + 2] - f[seg])) : 0.0f;
+        m->bin_down[k] = seg > 0 ? (float)(down * 2.0 / (f[seg + 1] - f[seg - 1])) : 0.0f;
+    }
+}
+
+void mel_init(mel_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < MEL_N_FFT; i++) {
+        m->window[i] = (float)(0.5 - 0.5 * cos(2.0 * MEL_PI * i / MEL_N_FFT));
+    }
+    for (int k = 0; k < MEL_FFT_N; k++) {
+        m->twiddle[k].re = (float)cos(2.0 * MEL_PI * k / MEL_FFT_N);
+        m->twiddle[k].im = (float)-sin(2.0 * MEL_PI * k / MEL_FFT_N);
+    }
+    for (int k = 0; k <= MEL_FFT_N / 2; k++) {
+        m->split[k].re = (float)cos(2.0 * MEL_PI * k / MEL_N_FFT);
+        m->split[k].im = (float)-sin(2.0 * MEL_PI * k / MEL_N_FFT);
+    }
+    /* radix 4 first, then 2, then odd ones */
+    int n = MEL_FFT_N;
+    int i = 0;
+    int p = 4;
+    while (n > 1) {
+        while (n % p) {
+            p = p == 4 ? 2 : (p == 2 ? 3 : p + 2);
+        }
+        n /= p;
+        m->factors[i++] = (uint8_t)p;
+        m->factors[i++] = (uint8_t)n;
+    }
+    mel_init_filters(m);
+    mel_reset(m);
+}
+
+void mel_reset(mel_t *m)
+{
+    memset(m->buf, 0, sizeof(m->buf));
+    m->fill = MEL_N_FFT / 2;
+}
+
+static inline mel_cpx_t cmul(mel_cpx_t a, mel_cpx_t b)
+{
+    return (mel_cpx_t) { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+static void bfly2(const mel_t *m, mel_cpx_t *out, size_t fstride, size_t len)
+{
+    for (size_t k = 0; k < len; k++) {
+        mel_cpx_t t = cmul(out[k + len], m->twiddle[k * fstride]);
+        out[k + len].re = out[k].re - t.re;
+        out[k + len].im = out[k].im - t.im;
+        out[k].re += t.re;
+        out[k].im += t.im;
+    }
+}
+
+static void bfly4(const mel_t *m, mel_cpx_t *out, size_t fstride, size_t len)
+{
+    for (size_t k = 0; k < len; k++) {
+        mel_cpx_t a = out[k];
+        mel_cpx_t b = cmul(out[k + len], m->twiddle[k * fstride]);
+        mel_cpx_t c = cmul(out[k + 2 * len], m->twiddle[2 * k * fstride]);
+        mel_cpx_t d = cmul(out[k + 3 * len], m->twiddle[3 * k * fstride]);
+        mel_cpx_t ac0 = { a.re + c.re, a.im + c.im };
+        mel_cpx_t ac1 = { a.re - c.re, a.im - c.im };
+        mel_cpx_t bd0 = { b.re + d.re, b.im + d.im };
+        mel_cpx_t bd1 = { b.re - d.re, b.im - d.im };
+        out[k] = (mel_cpx_t) { ac0.re + bd0.re, ac0.im + bd0.im };
+        out[k + 2 * len] = (mel_cpx_t) { ac0.re - bd0.re, ac0.im - bd0.im };
+        /* -i and +i rotations of b - d */
+        out[k + len] = (mel_cpx_t) { ac1.re + bd1.im, ac1.im - bd1.re };
+        out[k + 3 * len] = (mel_cpx_t) { ac1.re - bd1.im, ac1.im + bd1.re };
+    }
+}
+
+/* any radix as a direct DFT of the p twiddled inputs, for the radix 5 stages */
+static void bfly_any(const mel_t *m, mel_cpx_t *out, size_t fstride, size_t len, size_t p)
+{
+    mel_cpx_t in[5];
+    for (size_t u = 0; u < len; u++) {
+        for (size_t q = 0; q < p; q++) {
+            in[q] = out[u + q * len];
+        }
+        for (size_t q = 0; q < p; q++) {
+            size_t k = u + q * len;
+            mel_cpx_t sum = in[0];
+            size_t tw = 0;
+            for (size_t r = 1; r < p; r++) {
+                tw += fstride * k;
+                if (tw >= MEL_FFT_N) {
+                    tw -= MEL_FFT_N;
+                }
+                mel_cpx_t t = cmul(in[r], m->twiddle[tw]);
+                sum.re += t.re;
+                sum.im += t.im;
+            }
+            out[k] = sum;
+        }
+    }
+}
+
+/* out gets the DFT of in[0], in[fstride], ... of the length the factors multiply to */
+static void fft_stage(const mel_t *m, mel_cpx_t *out, const mel_cpx_t *in, size_t fstride, const uint8_t *factors)
+{
+    size_t p = factors[0];
+    size_t len = factors[1];
+    for (size_t q = 0; q < p; q++) {
+        if (len == 1) {
+            out[q] = in[q * fstride];
+        } else {
+            fft_stage(m, out + q * len, in + q * fstride, fstride * p, factors + 2);
+        }
+    }
+    if (p == 4) {
+        bfly4(m, out, fstride, len);
+    } else if (p == 2) {
+        bfly2(m, out, fstride, len);
+    } else {
+        bfly_any(m, out, fstride, len, p);
+    }
+}
+
+/* spectrum, filterbank and log of the window in buf */
+static void mel_frame(mel_t *m, int16_t *out)
+{
+    for (int i = 0; i < MEL_FFT_N; i++) {
+        m->fft_in[i].re = m->buf[2 * i] * m->window[2 * i];
+        m->fft_in[i].im = m->buf[2 * i + 1] * m->window[2 * i + 1];
+    }
+    fft_stage(m, m->fft_out, m->fft_in, 1, m->factors);
+
+    /* X[k] = (Z[k] + Z*[N-k]) / 2 - i W^k (Z[k] - Z*[N-k]) / 2, each bin's power into its two filters;
+     * acc[s + 1] is filter s, acc[0] and acc[MEL_BINS + 1] take the weights that are always 0 */
+    float acc[MEL_BINS + 2] = { 0 };
+    const mel_cpx_t *z = m->fft_out;
+    for (int k = 0; k < MEL_SPEC_BINS; k++) {
+        mel_cpx_t a = z[k % MEL_FFT_N];
+        mel_cpx_t b = z[(MEL_FFT_N - k) % MEL_FFT_N];
+        mel_cpx_t even = { (a.re + b.re) * 0.5f, (a.im - b.im) * 0.5f };
+        mel_cpx_t odd = { (a.im + b.im) * 0.5f, (b.re - a.re) * 0.5f };
+        mel_cpx_t w = k <= MEL_FFT_N / 2 ? m->split[k] : (mel_cpx_t) { -m->split[MEL_FFT_N - k].re,
+                                                                        m->split[MEL_FFT_N - k].im };
+        mel_cpx_t t = cmul(odd, w);
+        float re = even.re + t.re;
+        float im = even.im + t.im;
+        float power = re * re + im * im;
+        int s = m->bin_seg[k];
+        acc[s + 1] += m->bin_up[k] * power;
+        acc[s] += m->bin_down[k] * power;
+    }
+    for (int i = 0; i < MEL_BINS; i++) {
+        float v = acc[i + 1] > MEL_POWER_FLOOR ? acc[i + 1] : MEL_POWER_FLOOR;
+        float q = log10f(v) * (1 << MEL_Q);
+        out[i] = (int16_t)(q > INT16_MAX ? INT16_MAX : lrintf(q));
+    }
+}
+
+size_t mel_push(mel_t *m, const int32_t *slots, size_t n, size_t stride, int16_t *out)
+{
+    size_t frames = 0;
+    for (size_t i = 0; i < n; i++) {
+        m->buf[m->fill++] = (float)slots[i * stride] * MEL_SLOT_SCALE;
+        if (m->fill == MEL_N_FFT) {
+            mel_frame(m, out + frames * MEL_BINS);
+            frames++;
+            memmove(m->buf, m->buf + MEL_HOP, (MEL_N_FFT - MEL_HOP) * sizeof(float));
+            m->fill = MEL_N_FFT - MEL_HOP;
+        }
+    }
+    return frames;
+}
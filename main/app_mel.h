@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Whisper's log-mel front end, streaming: 80 mel bins of 25 ms windows every 10 ms at 16 kHz */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEL_RATE 16000
+#define MEL_N_FFT 400                    // 25 ms window
+#define MEL_HOP 160                      // 10 ms between frames
+#define MEL_BINS 80
+#define MEL_SPEC_BINS (MEL_N_FFT / 2 + 1)
+#define MEL_FFT_N (MEL_N_FFT / 2)        // complex FFT of the even/odd sample pairs
+#define MEL_Q 10                         // output is log10 of the mel power in Q10
+#define MEL_FLOOR_Q (-10 << MEL_Q)       // log10(1e-10), Whisper's floor
+#define MEL_FRAME_BYTES (MEL_BINS * 2)   // one frame: MEL_BINS s16
+
+typedef struct {
+    float re;
+    float im;
+} mel_cpx_t;
+
+typedef struct {
+    float window[MEL_N_FFT];             // periodic Hann
+    mel_cpx_t twiddle[MEL_FFT_N];        // e^(-2 pi i k / MEL_FFT_N)
+    mel_cpx_t split[MEL_FFT_N / 2 + 1];  // e^(-2 pi i k / MEL_N_FFT), real FFT from the complex one
+    uint8_t factors[8];                  // radix, remaining length; per stage
+    uint8_t bin_seg[MEL_SPEC_BINS];      // filter whose rising edge the bin is on, 0..MEL_BINS
+    float bin_up[MEL_SPEC_BINS];         // weight in that filter
+    float bin_down[MEL_SPEC_BINS];       // weight in the one before, on its falling edge
+    float buf[MEL_N_FFT];                // window being filled, oldest first
+    uint16_t fill;                       // samples in buf
+    mel_cpx_t fft_in[MEL_FFT_N];
+    mel_cpx_t fft_out[MEL_FFT_N];
+} mel_t;
+
+/* window, FFT tables and filterbank; then as mel_reset */
+void mel_init(mel_t *m);
+
+/* history to silence: the next frame is centred MEL_N_FFT / 2 samples on, like Whisper's
+ * padded first frame */
+void mel_reset(mel_t *m);
+
+/* n samples of a 24 bit left aligned I2S slot, stride apart; writes a frame of MEL_BINS to out
+ * for every MEL_HOP samples completed and returns how many. out holds n / MEL_HOP + 1 frames */
+size_t mel_push(mel_t *m, const int32_t *slots, size_t n, size_t stride, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
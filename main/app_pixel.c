@@ -0,0 +1,211 @@
+/* Eric Liu 2026
+
+RGB565 pixel kernels: byte swap, solid fill, masked colour blend and
+expansion of low bit depth render buffers (L8, I1) through a palette.
+
+The portable path works two pixels per 32-bit word where it can. On ESP32-S3
+with CONFIG_APP_PIXEL_SIMD the aligned middle of each span is handed to the
+PIE routines (16 pixels per iteration); the unaligned head and the tail stay
+on the portable path, so results are bit-identical either way.
+
+No ESP-IDF dependencies outside of the SIMD guard, so this file also builds
+for the linux target and plain host compilers.
+
+INPUTS: pixel spans from the flush callback and the LVGL blend hooks
+OUTPUTS: RGB565 spans (in place, or into the flush staging buffers)
+
+*/
+
+#include "app_pixel.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if CONFIG_APP_PIXEL_SIMD
+/* app_pixel_esp32s3.S: buffers 16-byte aligned, counts in 16-pixel blocks */
+extern void pixel_rgb565_swap_esp32s3(uint16_t *buf, size_t blocks);
+extern void pixel_rgb565_fill_esp32s3(uint16_t *dst, size_t blocks, const uint16_t *color);
+
+#define PIXEL_SIMD_ALIGN  16
+#define PIXEL_SIMD_BLOCK  16
+#endif
+
+static inline uint16_t swap16(uint16_t px)
+{
+    return (uint16_t)((px << 8) | (px >> 8));
+}
+
+static void swap_portable(uint16_t *buf, size_t count)
+{
+    if (count > 0 && ((uintptr_t)buf & 0x2)) {
+        *buf = swap16(*buf);
+        buf++;
+        count--;
+    }
+    uint32_t *words = (uint32_t *)buf;
+    size_t pairs = count / 2;
+    for (size_t i = 0; i < pairs; i++) {
+        uint32_t w = words[i];
+        words[i] = ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+    }
+    if (count & 1) {
+        buf[count - 1] = swap16(buf[count - 1]);
+    }
+}
+
+static void fill_portable(uint16_t *dst, size_t count, uint16_t color)
+{
+    if (count > 0 && ((uintptr_t)dst & 0x2)) {
+        *dst++ = color;
+        count--;
+    }
+    uint32_t *words = (uint32_t *)dst;
+    uint32_t pair = ((uint32_t)color << 16) | color;
+    size_t pairs = count / 2;
+    for (size_t i = 0; i < pairs; i++) {
+        words[i] = pair;
+    }
+    if (count & 1) {
+        dst[count - 1] = color;
+    }
+}
+
+#if CONFIG_APP_PIXEL_SIMD
+/* number of leading pixels to handle before dst reaches SIMD alignment */
+static inline size_t simd_head(const uint16_t *p, size_t count)
+{
+    size_t head = ((PIXEL_SIMD_ALIGN - ((uintptr_t)p & (PIXEL_SIMD_ALIGN - 1))) & (PIXEL_SIMD_ALIGN - 1)) / 2;
+    return (head > count) ? count : head;
+}
+#endif
+
+void pixel_rgb565_swap(uint16_t *buf, size_t count)
+{
+#if CONFIG_APP_PIXEL_SIMD
+    size_t head = simd_head(buf, count);
+    swap_portable(buf, head);
+    buf += head;
+    count -= head;
+    size_t blocks = count / PIXEL_SIMD_BLOCK;
+    if (blocks > 0) {
+        pixel_rgb565_swap_esp32s3(buf, blocks);
+        buf += blocks * PIXEL_SIMD_BLOCK;
+        count -= blocks * PIXEL_SIMD_BLOCK;
+    }
+#endif
+    swap_portable(buf, count);
+}
+
+void pixel_rgb565_fill(uint16_t *dst, size_t count, uint16_t color)
+{
+#if CONFIG_APP_PIXEL_SIMD
+    size_t head = simd_head(dst, count);
+    fill_portable(dst, head, color);
+    dst += head;
+    count -= head;
+    size_t blocks = count / PIXEL_SIMD_BLOCK;
+    if (blocks > 0) {
+        pixel_rgb565_fill_esp32s3(dst, blocks, &color);
+        dst += blocks * PIXEL_SIMD_BLOCK;
+        count -= blocks * PIXEL_SIMD_BLOCK;
+    }
+#endif
+    fill_portable(dst, count, color);
+}
+
+/* identical to lv_color_16_16_mix() so hooked blends match LVGL's C renderer bit for bit */
+static inline uint16_t mix565(uint16_t fg, uint16_t bg, uint8_t mix)
+{
+    if (mix == 255 || fg == bg) {
+        return fg;
+    }
+    if (mix == 0) {
+        return bg;
+    }
+    uint32_t m = ((uint32_t)mix + 4) >> 3;
+    uint32_t b = ((uint32_t)bg | ((uint32_t)bg << 16)) & 0x07E0F81Fu;
+    uint32_t f = ((uint32_t)fg | ((uint32_t)fg << 16)) & 0x07E0F81Fu;
+    uint32_t r = ((((f - b) * m) >> 5) + b) & 0x07E0F81Fu;
+    return (uint16_t)((r >> 16) | r);
+}
+
+void pixel_rgb565_blend(uint16_t *dst, const uint8_t *alpha, size_t count, uint16_t color)
+{
+    /* glyph masks are mostly fully transparent or fully covered: skip/fill those
+     * four pixels at a time and only do the per-channel mix on the edges */
+    size_t i = 0;
+    while (i < count) {
+        if (i + 4 <= count) {
+            uint32_t a4;
+            memcpy(&a4, alpha + i, sizeof(a4));
+            if (a4 == 0) {
+                i += 4;
+                continue;
+            }
+            if (a4 == 0xFFFFFFFFu) {
+                size_t run = i + 4;
+                while (run < count && alpha[run] == 0xFF) {
+                    run++;
+                }
+                pixel_rgb565_fill(dst + i, run - i, color);
+                i = run;
+                continue;
+            }
+        }
+        dst[i] = mix565(color, dst[i], alpha[i]);
+        i++;
+    }
+}
+
+void pixel_expand_l8(uint16_t *dst, const uint8_t *src, size_t count, const uint16_t *palette)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        dst[i] = palette[src[i]];
+        dst[i + 1] = palette[src[i + 1]];
+        dst[i + 2] = palette[src[i + 2]];
+        dst[i + 3] = palette[src[i + 3]];
+    }
+    for (; i < count; i++) {
+        dst[i] = palette[src[i]];
+    }
+}
+
+void pixel_expand_i1(uint16_t *dst, const uint8_t *src, size_t first_bit, size_t count, uint16_t c0, uint16_t c1)
+{
+    src += first_bit / 8;
+    first_bit &= 7;
+    if (first_bit) {
+        /* leading bits up to the next byte boundary */
+        size_t lead = 8 - first_bit;
+        if (lead > count) {
+            lead = count;
+        }
+        for (size_t k = 0; k < lead; k++) {
+            *dst++ = (*src & (0x80 >> (first_bit + k))) ? c1 : c0;
+        }
+        src++;
+        count -= lead;
+    }
+    size_t full = count / 8;
+    for (size_t b = 0; b < full; b++) {
+        uint8_t bits = src[b];
+        if (bits == 0x00 || bits == 0xFF) {
+            /* background or solid glyph interior, most bytes of a caption stripe */
+            pixel_rgb565_fill(dst, 8, bits ? c1 : c0);
+        } else {
+            for (int k = 0; k < 8; k++) {
+                dst[k] = (bits & (0x80 >> k)) ? c1 : c0;
+            }
+        }
+        dst += 8;
+    }
+    size_t rest = count & 7;
+    for (size_t k = 0; k < rest; k++) {
+        dst[k] = (src[full] & (0x80 >> k)) ? c1 : c0;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* RGB565 pixel kernels used by the display flush path and the LVGL blend hooks.
+ * On ESP32-S3 the bulk of each span goes through the PIE (SIMD) routines in
+ * app_pixel_esp32s3.S; everything else, and every other target, uses the
+ * portable C path. Both paths produce identical output. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* swaps the two bytes of every pixel in place (LVGL little endian -> panel MSB first) */
+void pixel_rgb565_swap(uint16_t *buf, size_t count);
+
+/* writes count copies of color to dst */
+void pixel_rgb565_fill(uint16_t *dst, size_t count, uint16_t color);
+
+/* dst[i] = mix(color, dst[i], alpha[i]), same rounding as LVGL's lv_color_16_16_mix */
+void pixel_rgb565_blend(uint16_t *dst, const uint8_t *alpha, size_t count, uint16_t color);
+
+/* 8-bit index/luminance -> RGB565 through a 256 entry palette */
+void pixel_expand_l8(uint16_t *dst, const uint8_t *src, size_t count, const uint16_t *palette);
+
+/* 1-bit (MSB = leftmost pixel) -> RGB565 starting first_bit pixels into src,
+ * bit clear = c0, bit set = c1 */
+void pixel_expand_i1(uint16_t *dst, const uint8_t *src, size_t first_bit, size_t count, uint16_t c0, uint16_t c1);
+
+#ifdef __cplusplus
+}
+#endif
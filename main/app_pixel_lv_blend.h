@@ -0,0 +1,39 @@
+#pragma once
+
+/* LVGL draw_sw custom blend hooks (CONFIG_LV_DRAW_SW_ASM_CUSTOM).
+ * Included by LVGL's blend sources through LV_DRAW_SW_ASM_CUSTOM_INCLUDE,
+ * main/CMakeLists.txt puts this directory on the lvgl include path.
+ * Solid fills and opaque masked fills (anti-aliased glyphs) into RGB565 go through
+ * app_pixel; every other blend returns to LVGL's C implementation. */
+
+#include "app_pixel.h"
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565(dsc) \
+    pixel_lv_color_blend_to_rgb565(dsc)
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565_WITH_MASK(dsc) \
+    pixel_lv_color_blend_to_rgb565_with_mask(dsc)
+
+static inline lv_result_t pixel_lv_color_blend_to_rgb565(lv_draw_sw_blend_fill_dsc_t *dsc)
+{
+    uint16_t color = lv_color_to_u16(dsc->color);
+    uint8_t *dest = (uint8_t *)dsc->dest_buf;
+    for (int32_t y = 0; y < dsc->dest_h; y++) {
+        pixel_rgb565_fill((uint16_t *)dest, (size_t)dsc->dest_w, color);
+        dest += dsc->dest_stride;
+    }
+    return LV_RESULT_OK;
+}
+
+static inline lv_result_t pixel_lv_color_blend_to_rgb565_with_mask(lv_draw_sw_blend_fill_dsc_t *dsc)
+{
+    uint16_t color = lv_color_to_u16(dsc->color);
+    uint8_t *dest = (uint8_t *)dsc->dest_buf;
+    const uint8_t *mask = dsc->mask_buf;
+    for (int32_t y = 0; y < dsc->dest_h; y++) {
+        pixel_rgb565_blend((uint16_t *)dest, mask, (size_t)dsc->dest_w, color);
+        dest += dsc->dest_stride;
+        mask += dsc->mask_stride;
+    }
+    return LV_RESULT_OK;
+}
@@ -0,0 +1,140 @@
+/* Eric Liu 2026
+
+Capture pre-processing, run by i2s_read_task on every chunk before it goes
+into audio_rb. Each mic has its own state, the wearer and the subject arrive
+at very different levels.
+
+High-pass: y[n] = x[n] - x[n-1] + a * y[n-1], one pole at a (Q15), which
+removes the IMNP441's DC offset and rumble below hpf_hz. The state keeps
+PREPROC_HPF_FRAC fraction bits so the rounding of the feedback term stays
+well under one 24 bit LSB.
+
+AGC: a block gain from the chunk's mean |y|, aiming at PREPROC_TARGET. A gain
+that has to drop moves half way there per chunk, a rising one at most 1/64
+per chunk (~5.5 dB/s), and below PREPROC_GATE (silence, room noise) it holds.
+The limiter caps both ends of the chunk's gain ramp so the chunk's peak stays
+under PREPROC_LIMIT; the chunk is already captured, so this needs no look
+ahead and adds no delay. Saturation after the gain only catches rounding.
+
+Block processing: a high-pass pass, then level and peak, then the gain ramp;
+the high-pass and the AGC are separate calls so the cross-talk canceller can
+sit between them. Per-sample work is multiplies, adds and min/max (MIN/MAX on
+the S3), no branches; divisions happen once per block.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: raw capture chunks
+OUTPUTS: the same chunks, filtered in place
+
+*/
+
+#include "app_preproc.h"
+
+#include <math.h>
+
+#define PREPROC_FULL_SCALE (1 << 23)  // 24 bit samples
+#define PREPROC_TARGET 838861         // mean |y| the AGC aims for, -20 dBFS
+#define PREPROC_GATE 14917            // mean |y| under -55 dBFS holds the gain
+#define PREPROC_LIMIT 7476355         // peak after gain, -1 dBFS
+#define PREPROC_MIN_GAIN (PREPROC_GAIN_ONE / 4)
+#define PREPROC_RELEASE_SHIFT 6
+#define PREPROC_RAMP_FRAC 8           // extra fraction bits of the ramp, Q24 holds the 40 dB max gain
+
+static inline int32_t min32(int32_t a, int32_t b)
+{
+    return a < b ? a : b;
+}
+
+static inline int32_t max32(int32_t a, int32_t b)
+{
+    return a > b ? a : b;
+}
+
+static inline int32_t abs32(int32_t v)
+{
+    int32_t sign = v >> 31;
+    return (v ^ sign) - sign;
+}
+
+void preproc_init(preproc_t *p, uint32_t sample_rate, uint32_t hpf_hz, uint32_t max_gain_db)
+{
+    *p = (preproc_t) { 0 };
+    p->hpf_a = (int32_t)lround(exp(-2.0 * 3.14159265358979 * hpf_hz / sample_rate) * 32768.0);
+    p->max_gain = (int32_t)lround(pow(10.0, max_gain_db / 20.0) * PREPROC_GAIN_ONE);
+    for (int i = 0; i < PREPROC_MICS; i++) {
+        p->mic[i].gain = PREPROC_GAIN_ONE;
+    }
+}
+
+void preproc_hpf(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride)
+{
+    preproc_mic_t *m = &p->mic[mic];
+    int32_t x1 = m->x1;
+    int32_t y1 = m->y1;
+    for (size_t i = 0; i < n; i++) {
+        int32_t x = slots[i * stride] >> 8;
+        y1 = (x - x1) * (1 << PREPROC_HPF_FRAC) + (int32_t)(((int64_t)p->hpf_a * y1 + (1 << 14)) >> 15);
+        x1 = x;
+        int32_t y = max32(-PREPROC_FULL_SCALE, min32(y1 >> PREPROC_HPF_FRAC, PREPROC_FULL_SCALE - 1));
+        slots[i * stride] = y * 256;
+    }
+    m->x1 = x1;
+    m->y1 = y1;
+}
+
+void preproc_agc(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride)
+{
+    if (n == 0) {
+        return;
+    }
+    preproc_mic_t *m = &p->mic[mic];
+
+    /* pass 1: level and peak */
+    int64_t sum = 0;
+    int32_t peak = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t y = abs32(slots[i * stride] >> 8);
+        sum += y;
+        peak = max32(peak, y);
+    }
+
+    /* gain at the end of the block */
+    int32_t level = (int32_t)(sum / (int64_t)n);
+    int32_t g0 = m->gain;
+    int32_t g = g0;
+    if (level >= PREPROC_GATE) {
+        int32_t want = (int32_t)(((int64_t)PREPROC_TARGET << 16) / level);
+        want = max32(PREPROC_MIN_GAIN, min32(want, p->max_gain));
+        if (want < g) {
+            g -= (g - want) >> 1;
+        } else {
+            g = min32(want, g + (g >> PREPROC_RELEASE_SHIFT));
+        }
+    }
+    if (peak > 0) {
+        int64_t lim = ((int64_t)PREPROC_LIMIT << 16) / peak;
+        if (lim < INT32_MAX) {
+            g0 = min32(g0, (int32_t)lim);
+            g = min32(g, (int32_t)lim);
+        }
+    }
+    m->gain = g;
+
+    /* pass 2: gain ramp from g0 to g; in Q16 a step under 1/65536 would truncate to none and
+     * the chunk would end up to n/65536 off the gain the next one starts at */
+    int32_t step = (int32_t)(((int64_t)(g - g0) * (1 << PREPROC_RAMP_FRAC)) / (int32_t)n);
+    int32_t gain = g0 * (1 << PREPROC_RAMP_FRAC);
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = (int32_t)(((int64_t)(slots[i * stride] >> 8) * gain) >> (16 + PREPROC_RAMP_FRAC));
+        v = max32(-PREPROC_FULL_SCALE, min32(v, PREPROC_FULL_SCALE - 1));
+        slots[i * stride] = v * 256;
+        gain += step;
+    }
+}
+
+void preproc_run(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride)
+{
+    preproc_hpf(p, mic, slots, n, stride);
+    preproc_agc(p, mic, slots, n, stride);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Capture pre-processing: DC blocking high-pass, AGC and limiter on 24 bit mic samples */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREPROC_MICS 2           // left, right
+#define PREPROC_HPF_FRAC 4       // fraction bits of the high-pass state
+#define PREPROC_GAIN_ONE 65536   // gains are Q16
+
+typedef struct {
+    int32_t x1;                  // last input sample
+    int32_t y1;                  // last high-pass output, PREPROC_HPF_FRAC fraction bits
+    int32_t gain;                // Q16, applied at the end of the last block
+} preproc_mic_t;
+
+typedef struct {
+    preproc_mic_t mic[PREPROC_MICS];
+    int32_t hpf_a;               // high-pass pole, Q15
+    int32_t max_gain;            // Q16
+} preproc_t;
+
+void preproc_init(preproc_t *p, uint32_t sample_rate, uint32_t hpf_hz, uint32_t max_gain_db);
+
+/* filter n samples of one mic in place: 32 bit I2S slots, 24 bit data left aligned, stride
+ * slots apart (2 for stereo capture, 1 for a single mic) */
+void preproc_hpf(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride);
+void preproc_agc(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride);
+
+/* preproc_hpf, then preproc_agc */
+void preproc_run(preproc_t *p, uint8_t mic, int32_t *slots, size_t n, size_t stride);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,116 @@
+/* Eric Liu 2026
+
+Uplink audio quality controller. Called once per measurement period with the
+capture backlog (audio waiting to be sent), the audio throughput and the Wi-Fi
+RSSI, it steps the uplink format between AUDIO_FMT_S16 and AUDIO_FMT_ADPCM_8K
+(or whatever range it was given).
+
+Down: as soon as the backlog passes QUALITY_BACKLOG_HIGH_MS, straight to the
+best format whose bit rate fits in 3/4 of the measured throughput, and at
+most once per QUALITY_DOWN_HOLD_MS so the backlog of the old format has a
+chance to drain. RSSI alone also pushes the format down: each threshold
+costs one step, and the signal has to come back QUALITY_RSSI_HYST_DB above
+the threshold before that step is returned.
+
+Up: one step at a time, after up_hold_ms with the backlog under
+QUALITY_BACKLOG_LOW_MS. An up step that is undone within QUALITY_FLAP_MS
+doubles up_hold_ms (up to QUALITY_UP_HOLD_MAX_MS), so a link sitting on the
+edge of two formats stops flapping between them; a format that holds for
+QUALITY_UP_HOLD_MAX_MS resets it.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: backlog, throughput, RSSI
+OUTPUTS: AUDIO_FMT_* for the next frames
+
+*/
+
+#include "app_quality.h"
+#include "app_codec.h"
+
+#define QUALITY_BACKLOG_HIGH_MS 200
+#define QUALITY_BACKLOG_LOW_MS 40
+#define QUALITY_DOWN_HOLD_MS 1000
+#define QUALITY_UP_HOLD_MS 5000
+#define QUALITY_UP_HOLD_MAX_MS 60000
+#define QUALITY_FLAP_MS 10000
+#define QUALITY_RSSI_HYST_DB 3
+
+/* below each of these the format goes one step down */
+static const int8_t rssi_steps[] = { -67, -73, -79 };
+
+void quality_init(quality_t *q, const codec_t *codec, uint8_t best, uint8_t worst, uint32_t now_ms)
+{
+    *q = (quality_t) {
+        .codec = codec,
+        .fmt = best,
+        .best = best,
+        .worst = worst,
+        .rssi_floor = best,
+        .changed_ms = now_ms,
+        .up_hold_ms = QUALITY_UP_HOLD_MS,
+    };
+}
+
+static uint8_t rssi_floor(const quality_t *q, int8_t rssi)
+{
+    if (rssi == QUALITY_RSSI_UNKNOWN) {
+        return q->rssi_floor;
+    }
+    uint8_t steps = 0;
+    for (uint8_t i = 0; i < sizeof(rssi_steps); i++) {
+        /* a step already taken needs the margin to be given back */
+        int hyst = (q->best + i < q->rssi_floor) ? QUALITY_RSSI_HYST_DB : 0;
+        if (rssi < rssi_steps[i] + hyst) {
+            steps = i + 1;
+        }
+    }
+    uint32_t floor = q->best + steps;
+    return (uint8_t)(floor > q->worst ? q->worst : floor);
+}
+
+static void quality_set(quality_t *q, uint8_t fmt, uint32_t now_ms)
+{
+    if (fmt > q->fmt && q->last_up && now_ms - q->changed_ms < QUALITY_FLAP_MS &&
+        q->up_hold_ms < QUALITY_UP_HOLD_MAX_MS) {
+        /* the last step up did not hold */
+        q->up_hold_ms *= 2;
+    }
+    q->last_up = fmt < q->fmt;
+    q->fmt = fmt;
+    q->changed_ms = now_ms;
+    q->switches++;
+}
+
+uint8_t quality_update(quality_t *q, const quality_in_t *in, uint32_t now_ms)
+{
+    uint32_t held_ms = now_ms - q->changed_ms;
+    q->rssi_floor = rssi_floor(q, in->rssi);
+    if (held_ms >= QUALITY_UP_HOLD_MAX_MS) {
+        q->up_hold_ms = QUALITY_UP_HOLD_MS;
+    }
+
+    uint8_t fmt = q->fmt;
+    if (in->backlog_ms >= QUALITY_BACKLOG_HIGH_MS && held_ms >= QUALITY_DOWN_HOLD_MS) {
+        fmt++;
+        while (fmt < q->worst && codec_bytes_per_ms(q->codec, fmt) * 1000 > in->sent_bytes_per_s * 3 / 4) {
+            fmt++;
+        }
+    } else if (in->backlog_ms <= QUALITY_BACKLOG_LOW_MS && held_ms >= q->up_hold_ms && fmt > q->best) {
+        fmt--;
+    }
+    if (fmt < q->rssi_floor) {
+        fmt = q->rssi_floor;
+    }
+    if (fmt > q->worst) {
+        fmt = q->worst;
+    }
+    if (fmt < q->best) {
+        fmt = q->best;
+    }
+    if (fmt != q->fmt) {
+        quality_set(q, fmt, now_ms);
+    }
+    return q->fmt;
+}
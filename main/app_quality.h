@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "app_codec.h"
+
+/* Picks the uplink audio format (AUDIO_FMT_*, higher = fewer bytes) from how the link keeps up */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QUALITY_RSSI_UNKNOWN (-127)
+
+typedef struct {
+    uint32_t backlog_ms;         // captured audio not sent yet
+    uint32_t sent_bytes_per_s;   // audio payload that went out over the last period
+    int8_t rssi;                 // dBm, QUALITY_RSSI_UNKNOWN without a reading
+} quality_in_t;
+
+typedef struct {
+    const codec_t *codec;        // bit rate of each format
+    uint8_t fmt;                 // current format
+    uint8_t best;                // range the controller moves in
+    uint8_t worst;
+    uint8_t rssi_floor;          // best format the signal level allows
+    uint32_t changed_ms;
+    bool last_up;                // the last change was a step up
+    uint32_t up_hold_ms;         // clean time needed before a step up, doubles when one fails quickly
+    uint32_t switches;
+} quality_t;
+
+void quality_init(quality_t *q, const codec_t *codec, uint8_t best, uint8_t worst, uint32_t now_ms);
+
+/* one measurement period; returns the format to use from the next frame on */
+uint8_t quality_update(quality_t *q, const quality_in_t *in, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
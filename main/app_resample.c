@@ -0,0 +1,172 @@
+/* Eric Liu 2026
+
+Polyphase FIR sample rate converter. A rational in_rate * L / M conversion is
+a zero-stuffing upsample by L, a lowpass at the upsampled rate and a decimate
+by M; only the taps that meet a nonzero input are ever multiplied, so each
+output is one phase (taps of the prototype L apart) against the last taps
+input samples. Downsampling only (L < M), so an input sample completes at
+most one output.
+
+The prototype is a Kaiser windowed sinc designed at init for
+RESAMPLE_ATTEN_DB stopband attenuation, with the transition band
+RESAMPLE_TRANSITION * out_rate wide and ending at out_rate / 2: for 16 kHz to
+8 kHz, flat to 3.36 kHz and attenuated from 4 kHz. Coefficients are Q15 and
+each phase is adjusted to sum to exactly 1, so DC passes unchanged; their
+rounding leaves the stopband at -70 dB or so rather than the design's 80.
+The filter length follows M / L: 128 taps per output for 16 to 8 kHz, 84
+for 16 to 12. Even and odd taps accumulate apart, each half fits 32 bits
+for any input, so the loop needs no 64 bit adds.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: s16 samples at in_rate
+OUTPUTS: s16 samples at out_rate
+
+*/
+
+#include "app_resample.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESAMPLE_ATTEN_DB 80.0
+#define RESAMPLE_TRANSITION 0.08
+#define RESAMPLE_MAX_RATIO 64        // L and M after reducing the fraction
+#define RESAMPLE_PI 3.14159265358979
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* zeroth order modified Bessel function of the first kind, for the Kaiser window */
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+bool resample_init(resample_t *r, uint32_t in_rate, uint32_t out_rate)
+{
+    *r = (resample_t) { 0 };
+    if (out_rate == 0 || out_rate >= in_rate) {
+        return false;
+    }
+    uint32_t g = gcd(in_rate, out_rate);
+    uint32_t up = out_rate / g;
+    uint32_t down = in_rate / g;
+    if (up > RESAMPLE_MAX_RATIO || down > RESAMPLE_MAX_RATIO) {
+        return false;
+    }
+
+    /* prototype at in_rate * up, length from the Kaiser estimate */
+    double fu = (double)in_rate * up;
+    double stop = out_rate / 2.0;
+    double pass = stop - RESAMPLE_TRANSITION * out_rate;
+    double fc = (pass + stop) / 2.0 / fu;
+    double dw = 2.0 * RESAMPLE_PI * (stop - pass) / fu;
+    double beta = 0.1102 * (RESAMPLE_ATTEN_DB - 8.7);
+    uint32_t taps = (uint32_t)ceil((ceil((RESAMPLE_ATTEN_DB - 8.0) / (2.285 * dw)) + 1) / up);
+    taps = (taps + 3) & ~3u;
+    uint32_t n = taps * up;
+
+    r->coef = (int16_t *)malloc(n * sizeof(int16_t));
+    r->hist = (int16_t *)calloc(2 * taps, sizeof(int16_t));
+    double *h = (double *)malloc(n * sizeof(double));
+    if (!r->coef || !r->hist || !h) {
+        free(h);
+        resample_free(r);
+        return false;
+    }
+    double mid = (n - 1) / 2.0;
+    for (uint32_t k = 0; k < n; k++) {
+        double t = k - mid;
+        double sinc = t == 0.0 ? 1.0 : sin(2.0 * RESAMPLE_PI * fc * t) / (2.0 * RESAMPLE_PI * fc * t);
+        double w = t / mid;
+        h[k] = 2.0 * fc * up * sinc * bessel_i0(beta * sqrt(1.0 - w * w)) / bessel_i0(beta);
+    }
+
+    /* phase p holds h[p], h[p + up], ... against the newest, next newest ... input */
+    bool fits = true;
+    for (uint32_t p = 0; p < up; p++) {
+        int16_t *c = r->coef + p * taps;
+        int32_t sum = 0;
+        uint32_t peak = 0;
+        for (uint32_t j = 0; j < taps; j++) {
+            c[j] = (int16_t)lround(h[p + j * up] * 32768.0);
+            sum += c[j];
+            if (abs(c[j]) > abs(c[peak])) {
+                peak = j;
+            }
+        }
+        c[peak] = (int16_t)(c[peak] + 32768 - sum);
+        /* resample_push sums even and odd taps apart in 32 bits: each half has to stay under 2 */
+        int32_t half[2] = { 0, 0 };
+        for (uint32_t j = 0; j < taps; j++) {
+            half[j & 1] += abs(c[j]);
+        }
+        fits = fits && half[0] < 65536 && half[1] < 65536;
+    }
+    free(h);
+    if (!fits) {
+        resample_free(r);
+        return false;
+    }
+
+    r->taps = (uint16_t)taps;
+    r->up = (uint16_t)up;
+    r->down = (uint16_t)down;
+    return true;
+}
+
+void resample_free(resample_t *r)
+{
+    free(r->coef);
+    free(r->hist);
+    *r = (resample_t) { 0 };
+}
+
+void resample_reset(resample_t *r)
+{
+    memset(r->hist, 0, 2 * r->taps * sizeof(int16_t));
+    r->pos = 0;
+    r->phase = 0;
+    r->wait = 0;
+}
+
+bool resample_push(resample_t *r, int16_t in, int16_t *out)
+{
+    r->pos = r->pos == 0 ? r->taps - 1 : r->pos - 1;
+    r->hist[r->pos] = in;
+    r->hist[r->pos + r->taps] = in;
+    if (r->wait > 0) {
+        r->wait--;
+        return false;
+    }
+    const int16_t *h = r->coef + (size_t)r->phase * r->taps;
+    const int16_t *x = r->hist + r->pos;
+    int32_t even = 0;
+    int32_t odd = 0;
+    for (size_t j = 0; j < r->taps; j += 2) {
+        even += h[j] * x[j];
+        odd += h[j + 1] * x[j + 1];
+    }
+    int32_t acc = (int32_t)(((int64_t)even + odd + (1 << 14)) >> 15);
+    *out = (int16_t)(acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : acc));
+    uint32_t next = r->phase + r->down;
+    r->phase = (uint16_t)(next % r->up);
+    r->wait = (uint16_t)(next / r->up - 1);
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Polyphase FIR sample rate converter for s16 mono: out_rate = in_rate * L / M, below in_rate */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int16_t *coef;               // up phases of taps each, Q15, every phase sums to 1
+    int16_t *hist;               // 2 * taps, every sample stored twice so a window is contiguous
+    uint16_t taps;               // per phase
+    uint16_t pos;                // newest sample in hist
+    uint16_t up;                 // L
+    uint16_t down;               // M
+    uint16_t phase;              // phase of the next output
+    uint16_t wait;               // inputs still to come before it
+} resample_t;
+
+/* designs the filter for in_rate to out_rate; false for an unsupported ratio or out of memory */
+bool resample_init(resample_t *r, uint32_t in_rate, uint32_t out_rate);
+void resample_free(resample_t *r);
+
+/* history to zero, the next input produces an output */
+void resample_reset(resample_t *r);
+
+/* one input sample; true with *out set when it completes an output sample */
+bool resample_push(resample_t *r, int16_t in, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
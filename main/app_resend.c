@@ -0,0 +1,104 @@
+/* Eric Liu 2026
+
+Bounded resend buffer for audio frames. Every audio frame is built in a slot
+here and stays until the server acknowledges its sequence number, so frames
+lost with a dropped connection, and audio captured while reconnecting, can be
+sent after the RESUME handshake instead of leaving a hole in the utterance.
+
+Slots have a fixed size (one full audio frame); the capture ring hands out
+3072 byte chunks, so almost no space is wasted and no allocator is needed.
+When the buffer is full the oldest frame is dropped, acked or not.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: audio frames from the net task, ACKs from the server
+OUTPUTS: frames to (re)send
+
+*/
+
+#include "app_resend.h"
+
+#include <stdlib.h>
+
+bool resend_init(resend_buf_t *rs, uint32_t slots, size_t slot_size)
+{
+    *rs = (resend_buf_t) { 0 };
+    if (slots < 2 || slot_size > UINT16_MAX) {
+        return false;
+    }
+    rs->mem = (uint8_t *)malloc(slots * slot_size);
+    rs->lens = (uint16_t *)calloc(slots, sizeof(uint16_t));
+    if (!rs->mem || !rs->lens) {
+        resend_free(rs);
+        return false;
+    }
+    rs->slots = slots;
+    rs->slot_size = slot_size;
+    return true;
+}
+
+void resend_free(resend_buf_t *rs)
+{
+    free(rs->mem);
+    free(rs->lens);
+    *rs = (resend_buf_t) { 0 };
+}
+
+uint8_t *resend_alloc(resend_buf_t *rs, uint32_t *seq)
+{
+    if (rs->tail - rs->head == rs->slots) {
+        rs->head++;
+        rs->stats.overflow++;
+        if (rs->sent - rs->head > rs->tail - rs->head) {
+            rs->sent = rs->head;
+        }
+    }
+    *seq = rs->tail;
+    return rs->mem + (size_t)(rs->tail % rs->slots) * rs->slot_size;
+}
+
+void resend_commit(resend_buf_t *rs, size_t len)
+{
+    rs->lens[rs->tail % rs->slots] = (uint16_t)len;
+    rs->tail++;
+}
+
+bool resend_peek(const resend_buf_t *rs, const uint8_t **data, size_t *len)
+{
+    if (rs->sent == rs->tail) {
+        return false;
+    }
+    uint32_t slot = rs->sent % rs->slots;
+    *data = rs->mem + (size_t)slot * rs->slot_size;
+    *len = rs->lens[slot];
+    return true;
+}
+
+void resend_mark_sent(resend_buf_t *rs)
+{
+    if ((int32_t)(rs->sent - rs->sent_max) < 0) {
+        rs->stats.resent++;
+    } else {
+        rs->sent_max = rs->sent + 1;
+    }
+    rs->sent++;
+}
+
+void resend_ack(resend_buf_t *rs, uint32_t seq)
+{
+    /* only frames that are still held; stale or bogus numbers are ignored */
+    uint32_t acked = seq + 1 - rs->head;
+    if (acked == 0 || acked > rs->tail - rs->head) {
+        return;
+    }
+    rs->head += acked;
+    if (rs->sent - rs->head > rs->tail - rs->head) {
+        rs->sent = rs->head;
+    }
+}
+
+void resend_rewind(resend_buf_t *rs)
+{
+    rs->sent = rs->head;
+}
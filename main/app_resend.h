@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Resend buffer for outgoing audio frames. Frames are numbered by the order
+ * they were stored in, that number is the sequence number on the wire. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t overflow;           // frames dropped unacknowledged because the buffer was full
+    uint32_t resent;             // frames sent more than once
+} resend_stats_t;
+
+typedef struct {
+    uint8_t *mem;
+    uint16_t *lens;
+    uint32_t slots;
+    size_t slot_size;
+    /* running frame counts; a frame's slot is its count modulo slots.
+     * head <= sent <= tail: [head, sent) sent but not acked, [sent, tail) not sent yet */
+    uint32_t head;
+    uint32_t sent;
+    uint32_t tail;
+    uint32_t sent_max;           // highest count ever sent + 1, to tell resends apart
+    resend_stats_t stats;
+} resend_buf_t;
+
+bool resend_init(resend_buf_t *rs, uint32_t slots, size_t slot_size);
+void resend_free(resend_buf_t *rs);
+
+/* memory for the next frame and its sequence number; the oldest frame is
+ * dropped if the buffer is full. Nothing is stored until resend_commit */
+uint8_t *resend_alloc(resend_buf_t *rs, uint32_t *seq);
+void resend_commit(resend_buf_t *rs, size_t len);
+
+/* oldest frame not sent yet; false if every frame was sent */
+bool resend_peek(const resend_buf_t *rs, const uint8_t **data, size_t *len);
+void resend_mark_sent(resend_buf_t *rs);
+
+/* peer has every frame up to and including seq */
+void resend_ack(resend_buf_t *rs, uint32_t seq);
+
+/* link lost: every unacknowledged frame goes out again */
+void resend_rewind(resend_buf_t *rs);
+
+static inline uint32_t resend_unacked(const resend_buf_t *rs)
+{
+    return rs->tail - rs->head;
+}
+
+static inline uint32_t resend_unsent(const resend_buf_t *rs)
+{
+    return rs->tail - rs->sent;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,19 +1,76 @@
 /*Eric Liu 2025
 based on example code by Espressif Systems Co. LTD
 
-This code constitutes a freeRTOS task for TCP connection.
-shares fd with tcp rx task
-fd is created here. Connected in this task. rx task uses existing
-socket
+This code constitutes a freeRTOS task for the TCP link to the server.
+One task owns the socket: it connects, sends audio frames, receives text
+frames and reconnects, so nothing else ever touches the fd.
 
-Inputs: ringbuffer audio_rb
-Outputs: none
+The socket is non-blocking and the task sleeps in select() on it. Audio
+frames go out from the capture ring, partial sends resume when the socket is
+writable again. Received bytes go through the frame parser (app_frame.c),
+which hands out every complete frame in the buffer; text frames are copied
+into the text ring.
+
+Dead links: TCP keepalive probes an idle connection, and a CONTROL PING goes
+out every APP_NET_PING_MS. A server that answers PINGs with PONGs gives the
+round trip time, and once it has answered, silence for APP_NET_PEER_TIMEOUT_MS
+drops the link. Reconnects back off exponentially with jitter; how long the
+link was down is logged with the RTT every NET_STATS_LOG_MS.
+
+With APP_NET_CLOCK_SYNC a CONTROL TIME goes out every APP_NET_CLOCK_SYNC_MS
+with the esp_timer time, and the server's TIME_REPLY adds when it received
+and answered it. app_tsync.c turns those into the offset and drift of the
+server clock; every new estimate goes back to the server as CLOCK, so it can
+put audio capture times (ts_us) on its own clock, and tcp_server_time() gives
+it to the other tasks. The estimate survives reconnects.
+
+With APP_NET_RESUME audio frames are built in the resend buffer (app_resend.c)
+and carry a sequence number. They stay there until the server ACKs them, and
+audio captured while the link is down is buffered as well. After a connect
+the task sends RESUME and holds audio until the server ACKs the last frame it
+has (or NET_RESUME_WAIT_MS passes), then sends everything after it.
+
+With APP_NET_AUDIO_UDP audio skips the TCP socket: it goes out as numbered
+datagrams of at most UDP_AUDIO_MAX bytes (one Wi-Fi MTU, no IP fragments) to
+the same server address, and every APP_NET_UDP_FEC_GROUP datagrams an XOR
+parity datagram (app_fec.c) follows. A lost datagram is skipped or rebuilt by
+the server instead of stalling everything behind it. Datagrams are only sent
+while the TCP link is up, TCP still carries PING/PONG and text.
+
+Overload: a server that falls behind can send CREDIT, the AUDIO payload bytes
+it takes on this connection. TCP audio stops at the limit and the server busy
+indicator comes on after NET_BUSY_MS. Audio that cannot go out waits in the
+capture ring, and once that is nearly full the oldest is dropped
+(net_trim_audio), so i2s_read_task never blocks and the audio sent when the
+server catches up is the most recent. The same bound applies while the link
+is down or TCP is backed up.
 
-Also included is a freeRTOS task for TCP rx.
-Receives short strings, and enqueues them for use by Graphics task
+With APP_NET_ADAPTIVE_AUDIO every NET_QUALITY_MS the capture backlog, audio
+throughput and Wi-Fi RSSI go to the quality controller (app_quality.c), which
+picks the format (app_codec.c) of the next audio frames. Every frame says its
+format in the header flags, so switches land on frame boundaries.
 
-Inputs: none
-Outputs: queue text_queue
+The audio ring is not a fd, select() times out every NET_POLL_MS to pick up
+new audio. A chunk is 24 ms of audio, so this adds no queueing. Chunks are
+audio_rec_t records tagged at capture with their language and I2S slots
+(app_audio.c); the task takes one at a time and sends it in one or more
+pieces.
+
+With APP_AUDIO_CONVERSATION a record can carry both languages (both mics had
+voice). RAW frames hold both mics, so such a record goes out once tagged
+LANG1 | LANG2; the mono formats send it twice, a LANG1 frame of the left mic
+then a LANG2 frame of the right one, each with its own codec state. Captions
+tagged with a language instead of a screen go to the screen of the person
+who reads that language. Frames, audio dropped unsent and capture to frame
+latency are logged per language.
+
+Connection states:
+CLOSED     no socket, next attempt when the backoff delay is up
+CONNECTING connect() in flight, done when the socket turns writable
+CONNECTED  frames flow both ways until a send/recv error or EOF
+
+Inputs: ringbuffer audio_rb
+Outputs: ringbuffer text_rb, read by display_task
 
 */
 
@@ -21,18 +78,33 @@ Outputs: queue text_queue
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <netdb.h>
 #include <arpa/inet.h>
-#include "esp_netif.h"
 #include "esp_log.h"
-#include "app_gpio.h"
+#include "esp_timer.h"
 #include "app_audio.h"
 #include "app_tcp.h"
+#include "app_display.h"
+#include "app_resend.h"
+#include "app_fec.h"
+#include "app_codec.h"
+#include "app_quality.h"
+#include "app_tsync.h"
+#include "app_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/ringbuf.h"
-#include "freertos/queue.h"
-#include "freertos/semphr.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_random.h"
+#endif
 
 #if defined(CONFIG_EXAMPLE_SOCKET_IP_INPUT_STDIN)
 #include "addr_from_stdin.h"
@@ -45,281 +117,1338 @@ Outputs: queue text_queue
 #endif
 
 #define PORT CONFIG_EXAMPLE_PORT
-#define INTERMEDIARY_BUF_SIZE 3080 // 3072 + sizeof(msg_hdr_t)
-#define DISP_Q_LEN 8
-#define DELAYTIME 100
+#define AUDIO_CHUNK_MAX (AUDIO_CHUNK_FRAMES * CODEC_RAW_FRAME) // one record as AUDIO_FMT_RAW
+#define AUDIO_BYTES_PER_MS (AUDIO_CAPTURE_RATE / 1000 * CODEC_RAW_FRAME) // AUDIO_FMT_RAW
+#define AUDIO_PAYLOAD_MAX (AUDIO_CHUNK_MAX + CODEC_ADPCM_HDR) // codec_max_len(AUDIO_CHUNK_FRAMES)
+#define AUDIO_FRAME_MAX (FRAME_HDR_SIZE + sizeof(audio_sub_hdr_t) + AUDIO_PAYLOAD_MAX)
+#define TX_BUF_SIZE (FRAME_HDR_SIZE + AUDIO_PAYLOAD_MAX)
+#define RX_BUF_SIZE 2048 // at least FRAME_HDR_SIZE + TEXT_MSG_MAX
+#define TEXT_RB_SIZE 4096 // a few full size text messages
+
+_Static_assert(RX_BUF_SIZE >= FRAME_HDR_SIZE + TEXT_MSG_MAX, "rx buffer must hold a full text frame");
+_Static_assert(AUDIO_HIST_BUCKETS == 8, "net_log_hist prints eight buckets");
+
+#define NET_POLL_MS 10             // select() timeout, also the audio ring poll period
+#define NET_CONNECT_TIMEOUT_MS 3000
+#define NET_STATS_LOG_MS 10000
+#define NET_KEEPALIVE_IDLE CONFIG_APP_NET_KEEPALIVE_IDLE
+#define NET_KEEPALIVE_INTERVAL CONFIG_APP_NET_KEEPALIVE_INTERVAL
+#define NET_KEEPALIVE_COUNT CONFIG_APP_NET_KEEPALIVE_COUNT
+#define NET_BACKOFF_MIN_MS CONFIG_APP_NET_BACKOFF_MIN_MS
+#define NET_BACKOFF_MAX_MS CONFIG_APP_NET_BACKOFF_MAX_MS
+#define NET_PING_MS CONFIG_APP_NET_PING_MS
+#define NET_PEER_TIMEOUT_MS CONFIG_APP_NET_PEER_TIMEOUT_MS
+#ifdef CONFIG_APP_NET_RESUME
+#define NET_RESUME 1
+#define NET_RESEND_MS CONFIG_APP_NET_RESEND_MS
+#else
+#define NET_RESUME 0
+#define NET_RESEND_MS 0
+#endif
+#define NET_RESEND_SLOTS ((NET_RESEND_MS * AUDIO_BYTES_PER_MS + AUDIO_CHUNK_MAX - 1) / AUDIO_CHUNK_MAX)
+#define NET_RESUME_WAIT_MS 1000    // no ACK to RESUME: send everything buffered
+#define NET_BUSY_MS 300            // out of credit this long shows the server busy indicator
+#define NET_AUDIO_HEADROOM (2 * AUDIO_CHUNK_MAX) // capture ring space kept free for i2s_read_task
+#if CONFIG_APP_AUDIO_MEL
+#define NET_MEL 1
+#define NET_CREDIT_FRAME MEL_FRAME_BYTES // credit per frame taken from the capture ring
+#else
+#define NET_MEL 0
+#define NET_CREDIT_FRAME CODEC_RAW_FRAME
+#endif
+#ifdef CONFIG_APP_NET_AUDIO_UDP
+#define NET_UDP 1
+#define NET_FEC_GROUP CONFIG_APP_NET_UDP_FEC_GROUP
+#else
+#define NET_UDP 0
+#define NET_FEC_GROUP 0
+#endif
+#define UDP_AUDIO_MAX 1024         // AUDIO_FMT_RAW per datagram, 8 ms; keeps datagrams under one Wi-Fi MTU
+#define UDP_FRAME_MAX (FRAME_HDR_SIZE + sizeof(audio_sub_hdr_t) + UDP_AUDIO_MAX + CODEC_ADPCM_HDR)
+#ifdef CONFIG_APP_NET_ADAPTIVE_AUDIO
+#define NET_ADAPTIVE 1
+#else
+#define NET_ADAPTIVE 0
+#endif
+#if CONFIG_APP_AUDIO_CONVERSATION
+#define NET_CONVERSATION 1
+#else
+#define NET_CONVERSATION 0
+#endif
+#define NET_AUDIO_BEST CONFIG_APP_NET_AUDIO_BEST_FMT
+#define NET_AUDIO_S16_RATE CONFIG_APP_NET_AUDIO_S16_RATE
+#define NET_QUALITY_MS 500         // quality controller period
+#ifdef CONFIG_APP_NET_CLOCK_SYNC
+#define NET_CLOCK_SYNC 1
+#define NET_CLOCK_SYNC_MS CONFIG_APP_NET_CLOCK_SYNC_MS
+#else
+#define NET_CLOCK_SYNC 0
+#define NET_CLOCK_SYNC_MS 0
+#endif
+
+static const char *TAG = "TCP net task";
+
+typedef enum {
+    NET_STATE_CLOSED = 0,
+    NET_STATE_CONNECTING,
+    NET_STATE_CONNECTED,
+} net_state_t;
 
-static const char *TAG = "TCP tx task";
-static const char *TAG2 = "TCP rx task";
-static int sock = 0;
-static SemaphoreHandle_t sock_ready;
+static const char *net_state_names[] = { "closed", "connecting", "connected" };
+static const char *audio_fmt_names[] = { "raw", "s16", "s16 8k", "adpcm 8k" };
 
-msg_hdr_t hdr = {
-    .magic = 0xAA,
-    .version = 1, //other fields set in tcp_tx_task
-};
+/* one language's audio, counted over a stats log period except where noted */
+typedef struct {
+    uint32_t frames;             // audio frames built
+    uint32_t trimmed_frames;     // sample frames dropped unsent, since boot
+    uint32_t capture_lost;       // audio_stats_t lang_dropped at the last log
+    uint32_t latency_ms_sum;     // capture to frame built
+    uint32_t latency_ms_max;
+} net_stream_t;
 
-static QueueHandle_t disp1_q;
-static QueueHandle_t disp2_q;
+typedef struct {
+    net_state_t state;
+    int sock;
+    int64_t deadline_us;         // CLOSED: next attempt, CONNECTING: give up
+    int64_t up_us;               // when the link came up
+    int64_t down_us;             // when the link was lost, 0 before the first connection
+    int64_t last_rx_us;
+    int64_t next_ping_us;
+    int64_t stats_log_us;
+    uint32_t backoff_attempt;
+    uint32_t rand_state;
+    bool peer_pongs;             // peer answered a PING on this connection
+    bool pong_pending;           // peer PING to answer, token in pong_token
+    uint32_t pong_token;
+    int64_t next_time_us;        // next clock sync TIME
+    bool clock_pending;          // new clock estimate to send as CLOCK
+    tsync_t tsync;               // kept across reconnects, the server's clock is the same
+    /* metrics */
+    uint32_t reconnects;
+    uint32_t down_ms_last;
+    uint32_t down_ms_max;
+    uint32_t rtt_us_last;
+    uint32_t rtt_us_min;
+    uint32_t rtt_us_max;
+    uint64_t rtt_us_sum;
+    uint32_t rtt_count;
+    /* tx: one frame at a time, resumed on writable */
+    uint8_t *tx_buf;
+    const uint8_t *tx_data;      // tx_buf or a resend slot
+    size_t tx_len;
+    size_t tx_off;
+    bool tx_resend;              // tx_data is the oldest unsent resend slot
+    /* resume */
+    resend_buf_t resend;
+    uint32_t session;
+    bool resuming;               // RESUME sent, audio held until the ACK
+    int64_t resume_deadline_us;
+    int64_t catchup_us;          // resume backlog started going out, 0 when live
+    /* udp audio */
+    int udp_sock;
+    uint8_t *udp_buf;
+    uint32_t udp_seq;
+    fec_enc_t fec;
+    uint32_t udp_frames;
+    uint32_t udp_parity;
+    uint32_t udp_dropped;        // datagrams the stack did not take
+    /* credit, TCP audio only */
+    bool credit_on;              // server sent CREDIT on this connection
+    bool credit_wait;            // audio held back for lack of credit
+    uint32_t credit_limit;
+    uint32_t audio_sent;         // AUDIO payload bytes queued on this connection
+    int64_t starved_us;          // credit_wait since, 0 when not waiting
+    uint32_t busy_count;
+    uint32_t trimmed_frames;     // oldest audio dropped from the capture ring, sample frames
+    uint32_t capture_drops;      // capture drop counters at the last log
+    uint32_t capture_dma_buffers; // audio_stats_t dma_buffers at the last log
+    uint32_t capture_chunks;     // audio_stats_t chunks, preproc_us and xtalk_us at the last log
+    uint32_t capture_preproc_us;
+    uint32_t capture_xtalk_us;
+    uint32_t capture_mel_frames; // audio_stats_t mel_frames and mel_us at the last log
+    uint32_t capture_mel_us;
+    uint32_t capture_kws_us;     // audio_stats_t kws_us at the last log
+    uint32_t capture_conv_chunks; // audio_stats_t conv_chunks and voiced at the last log
+    uint32_t capture_voiced[2];
+    net_stream_t streams[2];     // LANG1, LANG2
+    /* audio format */
+    codec_t codec;
+    codec_t codec2;              // LANG2 frames in conversation mode, codec state is per mic
+    quality_t quality;
+    uint8_t audio_fmt;           // AUDIO_FMT_* of the next frame
+    uint32_t audio_out;          // audio payload bytes handed to a socket, all transports
+    uint32_t quality_out;        // audio_out at the last controller period
+    int64_t quality_us;          // next controller period
+    /* capture record being sent, taken whole from audio_rb */
+    audio_rec_t *rec;
+    size_t rec_off;              // bytes of it handed out
+    uint8_t rec_lang;            // languages of the frames being made of it, 0 to skip it
+    uint8_t rec_next;            // language of a second pass over it, 0 for none
+    frame_parser_t rx;
+    uint32_t rx_resyncs;         // parser counts at the last warning
+    uint32_t rx_oversize;
+    uint32_t tx_log_ctr;
+    uint32_t rx_log_ctr;
+} net_ctx_t;
 
-QueueHandle_t tcp_rx_get_disp1_q(void)
+static RingbufHandle_t text_rb;
+static volatile bool server_busy;
+static tsync_est_t clock_est;            // net task's tsync estimate for other tasks, under clock_mux
+static bool clock_valid;
+static portMUX_TYPE clock_mux = portMUX_INITIALIZER_UNLOCKED;
+
+RingbufHandle_t tcp_rx_get_text_rb(void)
 {
-    return disp1_q;
-}   
-QueueHandle_t tcp_rx_get_disp2_q(void)
+    return text_rb;
+}
+
+bool tcp_server_busy(void)
 {
-    return disp2_q;
+    return server_busy;
+}
+
+bool tcp_server_time(int64_t dev_us, int64_t *server_us)
+{
+    tsync_est_t est;
+    portENTER_CRITICAL(&clock_mux);
+    bool valid = clock_valid;
+    est = clock_est;
+    portEXIT_CRITICAL(&clock_mux);
+    if (valid) {
+        *server_us = tsync_to_server(&est, dev_us);
+    }
+    return valid;
 }
 
 static void tcp_init_queues(void)
 {
-    disp1_q = xQueueCreate(DISP_Q_LEN, sizeof(text_msg_t));
-    assert(disp1_q);
-    disp2_q = xQueueCreate(DISP_Q_LEN, sizeof(text_msg_t));
-    assert(disp2_q);
-    ESP_LOGD(TAG, "TCP RX display queues initialized");
+    text_rb = xRingbufferCreate(TEXT_RB_SIZE, RINGBUF_TYPE_NOSPLIT);
+    assert(text_rb);
+    ESP_LOGD(TAG, "TCP RX text ring initialized");
 }
 
-static bool send_all(int sock, const void *buf, size_t len)
+static void net_set_state(net_ctx_t *net, net_state_t state)
 {
-    const uint8_t *ptr = (const uint8_t *)buf;
-    size_t total_sent = 0;
-    while (total_sent < len) {
-        int sent = send(sock, ptr + total_sent, len - total_sent, 0);
-        if (sent < 0) {
-            ESP_LOGE(TAG, "send failed: errno %d", errno);
-            return false;
-        }
-        total_sent += sent;
+    if (net->state != state) {
+        ESP_LOGI(TAG, "link %s -> %s", net_state_names[net->state], net_state_names[state]);
+        net->state = state;
     }
-    return true;
 }
 
-static bool recv_all(int sock, void *buf, size_t len)
+/* differs per boot and per device: seeds the retry jitter and names the resume session */
+static uint32_t net_seed(void)
 {
-    uint8_t *ptr = (uint8_t *)buf;
-    size_t total_received = 0;
-    while (total_received < len) {
-        int received = recv(sock, ptr + total_received, len - total_received, 0);
-        if (received < 0) {
-            ESP_LOGE(TAG, "recv failed: errno %d", errno);
-            return false;
-        } else if (received == 0) {
-            ESP_LOGW(TAG, "Connection closed");
-            return false;
+#if CONFIG_IDF_TARGET_LINUX
+    return (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16) ^ (uint32_t)esp_timer_get_time();
+#else
+    return esp_random();
+#endif
+}
+
+static uint32_t net_rand(net_ctx_t *net)
+{
+    /* xorshift32, only spreads retry times */
+    uint32_t x = net->rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    net->rand_state = x;
+    return x;
+}
+
+/* next reconnect delay: doubles per failed attempt up to the maximum, then a random
+ * point in its upper half, so clients of a restarted server do not retry in lockstep */
+static uint32_t net_backoff_ms(net_ctx_t *net)
+{
+    uint32_t ms = NET_BACKOFF_MIN_MS;
+    for (uint32_t i = 0; i < net->backoff_attempt && ms < NET_BACKOFF_MAX_MS; i++) {
+        ms *= 2;
+    }
+    if (ms > NET_BACKOFF_MAX_MS) {
+        ms = NET_BACKOFF_MAX_MS;
+    }
+    net->backoff_attempt++;
+    return ms / 2 + net_rand(net) % (ms / 2 + 1);
+}
+
+/* AUDIO payload bytes the server takes before it sends more credit */
+static uint32_t net_credit_left(const net_ctx_t *net)
+{
+    if (!net->credit_on) {
+        return UINT32_MAX;
+    }
+    int32_t left = (int32_t)(net->credit_limit - net->audio_sent);
+    return left > 0 ? (uint32_t)left : 0;
+}
+
+/* waiting for credit for NET_BUSY_MS turns the busy indicator on, the next frame sent turns it off */
+static void net_set_starved(net_ctx_t *net, bool starved)
+{
+    int64_t now = esp_timer_get_time();
+    if (starved) {
+        if (net->starved_us == 0) {
+            net->starved_us = now;
+        } else if (!server_busy && now - net->starved_us >= NET_BUSY_MS * 1000LL) {
+            server_busy = true;
+            net->busy_count++;
+            ESP_LOGW(TAG, "server busy: no audio credit for %d ms", NET_BUSY_MS);
+            display_notify_status();
         }
-        total_received += received;
+        return;
     }
-    return true;
+    if (server_busy) {
+        server_busy = false;
+        ESP_LOGI(TAG, "server taking audio again after %lu ms", (unsigned long)((now - net->starved_us) / 1000));
+        display_notify_status();
+    }
+    net->starved_us = 0;
 }
 
-void tcp_tx_task(void *args)
+/* passes over a fresh record: RAW carries both mics, so one; the mono formats one per language */
+static void net_audio_passes(net_ctx_t *net)
 {
-    /* transmit buffer */
-    uint8_t *int_buf = (uint8_t *)calloc(1, INTERMEDIARY_BUF_SIZE);
-    assert(int_buf);
-    size_t rb_bytes = 0; //for appending onto TCP headers
-    ESP_LOGD(TAG, "TCP tx buffer size %zu initialized", INTERMEDIARY_BUF_SIZE);
+    uint8_t lang = net->rec->lang;
+    net->rec_next = 0;
+    if (lang == AUDIO_LANG_BOTH && net->audio_fmt != AUDIO_FMT_RAW) {
+        lang = MSG_FLAG_LANG1;
+        net->rec_next = MSG_FLAG_LANG2;
+    }
+    net->rec_lang = lang;
+}
 
-    /* get ringbuffer handle */
-    RingbufHandle_t audio_rb = audio_get_rb();
+/* next piece of captured audio, at most max_frames sample frames of the oldest record; the record
+ * stays in net->rec until net_audio_done, net->rec_lang is the language to tag it with. NULL when
+ * the ring is empty */
+static const uint8_t *net_audio_take(net_ctx_t *net, RingbufHandle_t audio_rb, size_t max_frames, size_t *len)
+{
+    if (!net->rec) {
+        size_t size = 0;
+        net->rec = (audio_rec_t *)xRingbufferReceive(audio_rb, &size, 0);
+        net->rec_off = 0;
+        if (!net->rec) {
+            return NULL;
+        }
+        net_audio_passes(net);
+    }
+    size_t n = net->rec->len - net->rec_off;
+    size_t max = max_frames * codec_slot_frame(net->rec->slots);
+    *len = n < max ? n : max;
+    const uint8_t *audio = net->rec->data + net->rec_off;
+    net->rec_off += *len;
+    return audio;
+}
 
-    while (1) {
-        char host_ip[] = HOST_IP_ADDR;
-        int addr_family = 0;
-        int ip_protocol = 0;
-        
-        #if defined(CONFIG_EXAMPLE_IPV4)
-        struct sockaddr_in dest_addr;
-        inet_pton(AF_INET, host_ip, &dest_addr.sin_addr);
-        dest_addr.sin_family = AF_INET;
-        dest_addr.sin_port = htons(PORT);
-        addr_family = AF_INET;
-        ip_protocol = IPPROTO_IP;
-        #elif defined(CONFIG_EXAMPLE_SOCKET_IP_INPUT_STDIN)
-        struct sockaddr_storage dest_addr = {0};
-        ESP_ERROR_CHECK(get_addr_from_stdin(PORT, SOCK_STREAM, &ip_protocol, &addr_family, &dest_addr));
-        #endif
-
-        ESP_LOGD(TAG, "Socket connecting to %s:%d", host_ip, PORT);
-        sock = socket(addr_family, SOCK_STREAM, ip_protocol);
-        if (sock < 0) {
-            ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-            vTaskDelay(pdMS_TO_TICKS(DELAYTIME));
-            continue;
+/* the piece is used up; a record with nothing left goes back to the ring, one with a second
+ * language starts over for it */
+static void net_audio_done(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    if (net->rec && net->rec_off == net->rec->len) {
+        if (net->rec_next) {
+            net->rec_lang = net->rec_next;
+            net->rec_next = 0;
+            net->rec_off = 0;
+            return;
         }
+        vRingbufferReturnItem(audio_rb, net->rec);
+        net->rec = NULL;
+    }
+}
 
-        int err = connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if  (err != 0) {
-            ESP_LOGE(TAG, "Socket unable to connect: errno %d", errno);
-            shutdown(sock, 0);
-            close(sock);
-            sock = 0;
-            vTaskDelay(pdMS_TO_TICKS(DELAYTIME));
-            continue;
+/* sample frames of lang audio dropped unsent */
+static void net_count_trim(net_ctx_t *net, uint8_t lang, size_t frames)
+{
+    for (int i = 0; i < 2; i++) {
+        if (lang & (MSG_FLAG_LANG1 << i)) {
+            net->streams[i].trimmed_frames += frames;
         }
-        ESP_LOGD(TAG, "Succesfully connected");
-        xSemaphoreGive(sock_ready);
-
-        uint32_t tx_log_ctr = 0;
-        while (1)
-        {
-            /* rely on current FSM state to decide    */
-            /* state = APP_GPIO_STATE_IDLE            */
-            /* DO NOT SEND PACKETS                    */
-            /* state = APP_GPIO_STATE_TRANSLATE_LANGx */
-            /* SEND PACKET WITH HEADER SPECIFYING     */
-            if (gpio_get_state() == APP_GPIO_STATE_IDLE)
-            {  
-                /* read audio_rb but don't send */
-                size_t rb_bytes = 0;
-                uint8_t *rb_buf = (uint8_t *)xRingbufferReceiveUpTo(audio_rb, &rb_bytes, pdMS_TO_TICKS(DELAYTIME), 3072);
-                if (rb_buf != NULL) {
-                    ESP_LOGD(TAG, "TCP tx idle state - dumped %zu bytes from audio rb", rb_bytes);
-                    vRingbufferReturnItem(audio_rb, (void *)rb_buf);
-                }
-            }
-            else if (gpio_get_state() == APP_GPIO_STATE_TRANSLATE_LANG1)
-            {
-                /* message synthesis */
-                uint8_t *audio = (uint8_t *)xRingbufferReceiveUpTo(audio_rb, &rb_bytes, pdMS_TO_TICKS(DELAYTIME), 3072);
-                if (audio != NULL) {
-                    ESP_LOGD(TAG, "TCP tx lang1 state - read %zu bytes from audio", rb_bytes);
-                    hdr.msg_type = 1; //AUDIO
-                    hdr.flags = 1; //LANG1
-                    hdr.payload_len = htonl(rb_bytes);
-                    if ((tx_log_ctr++ % 100) == 0) {
-                        ESP_LOGD(TAG, "TCP tx hdr: msg_type=%d flags=%d payload_len=%d",
-                                 hdr.msg_type, hdr.flags, (int)rb_bytes);
-                    }
-                    /* copy header */
-                    memcpy(int_buf, (uint8_t *)&hdr, sizeof(msg_hdr_t));
-                    /* copy audio data */
-                    memcpy(int_buf + sizeof(msg_hdr_t), audio, rb_bytes);
-                    vRingbufferReturnItem(audio_rb, (void *)audio);
-                
-                    /* send */
-                    if (!send_all(sock, int_buf, sizeof(msg_hdr_t) + rb_bytes)) {
-                        break;
-                    }
-                }
-                else if (audio == NULL) {
-                    ESP_LOGE(TAG, "TCP tx lang1 state - failed to read from audio rb");
-                }
+    }
+}
+
+/* audio that cannot go out waits in the capture ring; once that is nearly full the oldest
+ * is dropped, so capture never blocks and what goes out later is the most recent */
+static void net_trim_audio(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    while (xRingbufferGetCurFreeSize(audio_rb) < NET_AUDIO_HEADROOM) {
+        audio_rec_t *rec = net->rec;
+        size_t off = net->rec_off;
+        uint8_t lang = net->rec_lang;
+        uint8_t next = net->rec_next;
+        if (rec) {
+            /* a partly sent record holds back the ring space of every record after it */
+            net->rec = NULL;
+        } else {
+            size_t size = 0;
+            rec = (audio_rec_t *)xRingbufferReceive(audio_rb, &size, 0);
+            off = 0;
+            if (!rec) {
+                break;
             }
-            else if (gpio_get_state() == APP_GPIO_STATE_TRANSLATE_LANG2)
-            {
-                /* message synthesis */
-                uint8_t *audio = (uint8_t *)xRingbufferReceiveUpTo(audio_rb, &rb_bytes, pdMS_TO_TICKS(DELAYTIME), 3072);
-                if (audio != NULL) {
-                    ESP_LOGD(TAG, "TCP tx lang2 state - read %zu bytes from audio", rb_bytes);
-                    /* copy header */
-                    hdr.msg_type = 1; //AUDIO
-                    hdr.flags = 2; //LANG2
-                    hdr.payload_len = htonl(rb_bytes);
-                    if ((tx_log_ctr++ % 100) == 0) {
-                        ESP_LOGD(TAG, "TCP tx hdr: msg_type=%d flags=%d payload_len=%d",
-                                 hdr.msg_type, hdr.flags, (int)rb_bytes);
-                    }
-                    memcpy(int_buf, (uint8_t *)&hdr, sizeof(msg_hdr_t));
-                    /* copy audio data */
-                    memcpy(int_buf + sizeof(msg_hdr_t), audio, rb_bytes);
-                    vRingbufferReturnItem(audio_rb, (void *)audio);
-        
-                    /* send */
-                    if (!send_all(sock, int_buf, sizeof(msg_hdr_t) + rb_bytes)) {
-                        break;
-                    }
-                }
-                else if (audio == NULL) {
-                    ESP_LOGE(TAG, "TCP tx lang2 state - failed to read from audio rb");
-                }
+            lang = rec->lang;
+            next = 0;
+        }
+        size_t frame = codec_slot_frame(rec->slots);
+        size_t mul = rec->slots == CODEC_SLOTS_MEL ? MEL_HOP : 1;
+        size_t frames = (rec->len - off) / frame * mul;
+        net->trimmed_frames += frames;
+        net_count_trim(net, lang, frames);
+        net_count_trim(net, next, rec->len / frame * mul);
+        vRingbufferReturnItem(audio_rb, rec);
+    }
+}
+
+static void net_close(net_ctx_t *net)
+{
+    int64_t now = esp_timer_get_time();
+    if (net->state == NET_STATE_CONNECTED) {
+        net->down_us = now;
+        /* a link that held up for a while starts the backoff over */
+        if (now - net->up_us >= NET_BACKOFF_MAX_MS * 1000LL) {
+            net->backoff_attempt = 0;
+        }
+    }
+    if (net->sock >= 0) {
+        shutdown(net->sock, SHUT_RDWR);
+        close(net->sock);
+        net->sock = -1;
+    }
+    if (net->udp_sock >= 0) {
+        close(net->udp_sock);
+        net->udp_sock = -1;
+    }
+    if (NET_FEC_GROUP > 1) {
+        fec_enc_reset(&net->fec);
+    }
+    net->tx_len = 0;
+    net->tx_off = 0;
+    net->credit_wait = false;
+    net_set_starved(net, false);
+    net->pong_pending = false;
+    net->resuming = false;
+    net->catchup_us = 0;
+    frame_parser_reset(&net->rx);
+    if (NET_RESUME) {
+        resend_rewind(&net->resend);
+    }
+    uint32_t delay_ms = net_backoff_ms(net);
+    net->deadline_us = now + delay_ms * 1000LL;
+    ESP_LOGD(TAG, "reconnect in %lu ms", (unsigned long)delay_ms);
+    net_set_state(net, NET_STATE_CLOSED);
+}
+
+/* per language: frames and latency of this period, audio lost since boot */
+static void net_log_streams(net_ctx_t *net, const audio_stats_t *cap)
+{
+    for (int i = 0; i < 2; i++) {
+        net_stream_t *s = &net->streams[i];
+        uint32_t lost = cap->lang_dropped[i] - s->capture_lost;
+        if (s->frames > 0 || lost > 0) {
+            ESP_LOGI(TAG, "LANG%d: %lu frames, capture to frame avg %lu max %lu ms, %lu ms dropped unsent, "
+                     "%lu chunks lost in capture", i + 1, (unsigned long)s->frames,
+                     (unsigned long)(s->frames ? s->latency_ms_sum / s->frames : 0),
+                     (unsigned long)s->latency_ms_max,
+                     (unsigned long)(s->trimmed_frames * CODEC_RAW_FRAME / AUDIO_BYTES_PER_MS), (unsigned long)lost);
+        }
+        s->capture_lost = cap->lang_dropped[i];
+        s->frames = 0;
+        s->latency_ms_sum = 0;
+        s->latency_ms_max = 0;
+    }
+    uint32_t chunks = cap->conv_chunks - net->capture_conv_chunks;
+    if (chunks > 0) {
+        ESP_LOGI(TAG, "conversation: voice in %lu%% (LANG1) and %lu%% (LANG2) of %lu chunks",
+                 (unsigned long)((cap->voiced[0] - net->capture_voiced[0]) * 100 / chunks),
+                 (unsigned long)((cap->voiced[1] - net->capture_voiced[1]) * 100 / chunks), (unsigned long)chunks);
+    }
+    net->capture_conv_chunks = cap->conv_chunks;
+    net->capture_voiced[0] = cap->voiced[0];
+    net->capture_voiced[1] = cap->voiced[1];
+}
+
+/* an audio_stats_t timing histogram, AUDIO_HIST_BUCKETS of them */
+static void net_log_hist(const char *what, const uint32_t *hist, uint32_t max_us)
+{
+    ESP_LOGI(TAG, "%s, ms: <1 %lu, <2 %lu, <4 %lu, <8 %lu, <16 %lu, <32 %lu, <64 %lu, more %lu; longest %lu us", what,
+             (unsigned long)hist[0], (unsigned long)hist[1], (unsigned long)hist[2], (unsigned long)hist[3],
+             (unsigned long)hist[4], (unsigned long)hist[5], (unsigned long)hist[6], (unsigned long)hist[7],
+             (unsigned long)max_us);
+}
+
+static void net_log_stats(net_ctx_t *net)
+{
+    if (net->rtt_count > 0) {
+        ESP_LOGI(TAG, "rtt us: last %lu min %lu avg %lu max %lu (%lu pongs)",
+                 (unsigned long)net->rtt_us_last, (unsigned long)net->rtt_us_min,
+                 (unsigned long)(net->rtt_us_sum / net->rtt_count), (unsigned long)net->rtt_us_max,
+                 (unsigned long)net->rtt_count);
+    }
+    ESP_LOGI(TAG, "reconnects %lu, down ms: last %lu max %lu", (unsigned long)net->reconnects,
+             (unsigned long)net->down_ms_last, (unsigned long)net->down_ms_max);
+    if (net->tsync.valid) {
+        int64_t now = esp_timer_get_time();
+        ESP_LOGI(TAG, "clock: server %lld us ahead, drift %ld ppb, error under %lu us (%lu exchanges, "
+                 "%lu rejected, %lu steps)", (long long)(tsync_to_server(&net->tsync.est, now) - now),
+                 (long)net->tsync.est.drift_ppb, (unsigned long)net->tsync.est.err_us,
+                 (unsigned long)net->tsync.exchanges, (unsigned long)net->tsync.rejected,
+                 (unsigned long)net->tsync.steps);
+    }
+    if (NET_RESUME) {
+        ESP_LOGI(TAG, "resend: %lu frames unacked, %lu overflowed, %lu resent",
+                 (unsigned long)resend_unacked(&net->resend), (unsigned long)net->resend.stats.overflow,
+                 (unsigned long)net->resend.stats.resent);
+    }
+    if (NET_UDP) {
+        ESP_LOGI(TAG, "udp: %lu audio, %lu parity, %lu dropped datagrams", (unsigned long)net->udp_frames,
+                 (unsigned long)net->udp_parity, (unsigned long)net->udp_dropped);
+    }
+    if (net->credit_on || net->busy_count > 0) {
+        ESP_LOGI(TAG, "audio credit: %lu bytes left, server busy %lu times", (unsigned long)net_credit_left(net),
+                 (unsigned long)net->busy_count);
+    }
+    if (NET_ADAPTIVE) {
+        ESP_LOGI(TAG, "audio format %s, %lu switches", audio_fmt_names[net->audio_fmt],
+                 (unsigned long)net->quality.switches);
+    }
+    if (net->trimmed_frames > 0) {
+        ESP_LOGI(TAG, "%lu ms of audio dropped unsent",
+                 (unsigned long)(net->trimmed_frames * CODEC_RAW_FRAME / AUDIO_BYTES_PER_MS));
+    }
+    audio_stats_t cap;
+    audio_get_stats(&cap);
+    uint32_t drops = cap.dropped_newest + cap.dropped_oldest + cap.dma_overruns;
+    if (drops != net->capture_drops) {
+        net->capture_drops = drops;
+        ESP_LOGW(TAG, "capture: %lu chunks, %lu new chunks dropped, %lu old bytes dropped, %lu waits, "
+                 "%lu DMA overruns", (unsigned long)cap.chunks, (unsigned long)cap.dropped_newest,
+                 (unsigned long)cap.dropped_oldest, (unsigned long)cap.push_waits, (unsigned long)cap.dma_overruns);
+    }
+    if (cap.dma_buffers != net->capture_dma_buffers) {
+        net->capture_dma_buffers = cap.dma_buffers;
+        ESP_LOGI(TAG, "i2s: %lu DMA buffers, %lu short reads, %lu read errors, %lu DMA overruns",
+                 (unsigned long)cap.dma_buffers, (unsigned long)cap.short_reads, (unsigned long)cap.read_errors,
+                 (unsigned long)cap.dma_overruns);
+        net_log_hist("i2s chunk reads waited", cap.read_hist, cap.read_us_max);
+        net_log_hist("i2s DMA buffers apart", cap.dma_gap_hist, cap.dma_gap_us_max);
+    }
+    if (cap.preproc_us != net->capture_preproc_us && cap.chunks != net->capture_chunks) {
+        uint32_t chunks = cap.chunks - net->capture_chunks;
+        ESP_LOGI(TAG, "capture preproc: %lu us per chunk, %lu us max",
+                 (unsigned long)((cap.preproc_us - net->capture_preproc_us) / chunks),
+                 (unsigned long)cap.preproc_us_max);
+        if (cap.xtalk_us != net->capture_xtalk_us) {
+            ESP_LOGI(TAG, "cross-talk: %lu us per chunk, %ld dB, adapting 1 block in %lu",
+                     (unsigned long)((cap.xtalk_us - net->capture_xtalk_us) / chunks),
+                     (long)(cap.xtalk_atten_db10 / 10),
+                     (unsigned long)(1u << cap.xtalk_adapt_shift));
+        }
+    }
+    if (cap.mel_frames != net->capture_mel_frames) {
+        uint32_t us = (cap.mel_us - net->capture_mel_us) / (cap.mel_frames - net->capture_mel_frames);
+        if (us > AUDIO_MEL_BUDGET_US) {
+            ESP_LOGW(TAG, "log-mel: %lu us per frame, over the %d us budget", (unsigned long)us,
+                     AUDIO_MEL_BUDGET_US);
+        } else {
+            ESP_LOGI(TAG, "log-mel: %lu frames, %lu us per frame", (unsigned long)cap.mel_frames,
+                     (unsigned long)us);
+        }
+    }
+    if (cap.kws_us != net->capture_kws_us && cap.chunks != net->capture_chunks) {
+        uint32_t audio_ms = (cap.chunks - net->capture_chunks) * AUDIO_CHUNK_FRAMES / (AUDIO_CAPTURE_RATE / 1000);
+        ESP_LOGI(TAG, "keywords: %lu%% of core 1, inference every %lu ms, %lu inferences, %lu triggers, "
+                 "%lu chunks missed", (unsigned long)((cap.kws_us - net->capture_kws_us) / 10 / audio_ms),
+                 (unsigned long)cap.kws_period_ms, (unsigned long)cap.kws_inferences,
+                 (unsigned long)cap.kws_triggers, (unsigned long)cap.kws_dropped);
+    }
+    net->capture_kws_us = cap.kws_us;
+    net->capture_chunks = cap.chunks;
+    net->capture_preproc_us = cap.preproc_us;
+    net->capture_xtalk_us = cap.xtalk_us;
+    net->capture_mel_frames = cap.mel_frames;
+    net->capture_mel_us = cap.mel_us;
+    net_log_streams(net, &cap);
+}
+
+static void net_queue_resume(net_ctx_t *net);
+
+/* datagram socket to the address the TCP link is connected to; without it audio is dropped */
+static void net_udp_open(net_ctx_t *net)
+{
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(net->sock, (struct sockaddr *)&peer, &peer_len) < 0) {
+        ESP_LOGE(TAG, "getpeername failed: errno %d", errno);
+        return;
+    }
+    net->udp_sock = socket(peer.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (net->udp_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create UDP socket: errno %d", errno);
+        return;
+    }
+    int fl = fcntl(net->udp_sock, F_GETFL, 0);
+    if (fl < 0 || fcntl(net->udp_sock, F_SETFL, fl | O_NONBLOCK) < 0 ||
+        connect(net->udp_sock, (struct sockaddr *)&peer, peer_len) < 0) {
+        ESP_LOGE(TAG, "UDP socket setup failed: errno %d", errno);
+        close(net->udp_sock);
+        net->udp_sock = -1;
+    }
+}
+
+static void net_connected(net_ctx_t *net)
+{
+    int64_t now = esp_timer_get_time();
+    ESP_LOGD(TAG, "Successfully connected");
+    net->up_us = now;
+    net->last_rx_us = now;
+    net->next_ping_us = now;
+    net->next_time_us = now;
+    net->peer_pongs = false;
+    net->credit_on = false;
+    net->audio_sent = 0;
+    net->tx_log_ctr = 0;
+    if (net->down_us != 0) {
+        net->reconnects++;
+        net->down_ms_last = (uint32_t)((now - net->down_us) / 1000);
+        if (net->down_ms_last > net->down_ms_max) {
+            net->down_ms_max = net->down_ms_last;
+        }
+        ESP_LOGI(TAG, "link back after %lu ms, %lu attempts", (unsigned long)net->down_ms_last,
+                 (unsigned long)net->backoff_attempt);
+    }
+    net_set_state(net, NET_STATE_CONNECTED);
+    if (NET_UDP) {
+        net_udp_open(net);
+    }
+    if (NET_RESUME) {
+        net_queue_resume(net);
+    }
+}
+
+/* failures only cost the feature, the link works without them */
+static void net_set_sockopts(int sock)
+{
+    int one = 1;
+    int idle = NET_KEEPALIVE_IDLE;
+    int interval = NET_KEEPALIVE_INTERVAL;
+    int count = NET_KEEPALIVE_COUNT;
+    /* PINGs and PONGs are tiny and timed, audio frames go out as whole writes anyway */
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) < 0) {
+        ESP_LOGW(TAG, "TCP_NODELAY failed: errno %d", errno);
+    }
+    if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one)) < 0 ||
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) < 0 ||
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval)) < 0 ||
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count)) < 0) {
+        ESP_LOGW(TAG, "TCP keepalive setup failed: errno %d", errno);
+    }
+}
+
+static void net_open(net_ctx_t *net)
+{
+    char host_ip[] = HOST_IP_ADDR;
+    int addr_family = 0;
+    int ip_protocol = 0;
+
+    #if defined(CONFIG_EXAMPLE_IPV4)
+    struct sockaddr_in dest_addr;
+    inet_pton(AF_INET, host_ip, &dest_addr.sin_addr);
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(PORT);
+    addr_family = AF_INET;
+    ip_protocol = IPPROTO_IP;
+    #elif defined(CONFIG_EXAMPLE_SOCKET_IP_INPUT_STDIN)
+    struct sockaddr_storage dest_addr = {0};
+    ESP_ERROR_CHECK(get_addr_from_stdin(PORT, SOCK_STREAM, &ip_protocol, &addr_family, &dest_addr));
+    #endif
+
+    ESP_LOGD(TAG, "Socket connecting to %s:%d", host_ip, PORT);
+    net->sock = socket(addr_family, SOCK_STREAM, ip_protocol);
+    if (net->sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        net_close(net);
+        return;
+    }
+    int fl = fcntl(net->sock, F_GETFL, 0);
+    if (fl < 0 || fcntl(net->sock, F_SETFL, fl | O_NONBLOCK) < 0) {
+        ESP_LOGE(TAG, "Unable to make socket non-blocking: errno %d", errno);
+        net_close(net);
+        return;
+    }
+    net_set_sockopts(net->sock);
+
+    if (connect(net->sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) == 0) {
+        net_connected(net);
+        return;
+    }
+    if (errno != EINPROGRESS) {
+        ESP_LOGE(TAG, "Socket unable to connect: errno %d", errno);
+        net_close(net);
+        return;
+    }
+    net->deadline_us = esp_timer_get_time() + NET_CONNECT_TIMEOUT_MS * 1000LL;
+    net_set_state(net, NET_STATE_CONNECTING);
+}
+
+/* socket turned writable while connecting: the result is in SO_ERROR */
+static void net_finish_connect(net_ctx_t *net)
+{
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(net->sock, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0) {
+        err = errno;
+    }
+    if (err != 0) {
+        ESP_LOGE(TAG, "Socket unable to connect: errno %d", err);
+        net_close(net);
+        return;
+    }
+    net_connected(net);
+}
+
+static void net_queue_frame(net_ctx_t *net, uint8_t msg_type, uint8_t flags, const void *payload, size_t len)
+{
+    size_t hdr_len = frame_put_hdr(net->tx_buf, msg_type, flags, len);
+    if (len > 0) {
+        memcpy(net->tx_buf + hdr_len, payload, len);
+    }
+    net->tx_data = net->tx_buf;
+    net->tx_len = hdr_len + len;
+    net->tx_off = 0;
+    net->tx_resend = false;
+}
+
+static void net_queue_ctrl(net_ctx_t *net, uint8_t op, uint32_t token)
+{
+    uint8_t payload[CTRL_PING_LEN];
+    payload[0] = op;
+    frame_put_be32(payload + 1, token);
+    net_queue_frame(net, MSG_TYPE_CONTROL, 0, payload, sizeof(payload));
+}
+
+static void net_queue_time(net_ctx_t *net, int64_t now)
+{
+    uint8_t payload[CTRL_TIME_LEN];
+    payload[0] = CTRL_OP_TIME;
+    frame_put_be64(payload + 1, (uint64_t)now);
+    net_queue_frame(net, MSG_TYPE_CONTROL, 0, payload, sizeof(payload));
+}
+
+static void net_queue_clock(net_ctx_t *net)
+{
+    uint8_t payload[CTRL_CLOCK_LEN];
+    payload[0] = CTRL_OP_CLOCK;
+    frame_put_be64(payload + 1, (uint64_t)net->tsync.est.offset_us);
+    frame_put_be64(payload + 9, (uint64_t)net->tsync.est.ref_us);
+    frame_put_be32(payload + 17, (uint32_t)net->tsync.est.drift_ppb);
+    net_queue_frame(net, MSG_TYPE_CONTROL, 0, payload, sizeof(payload));
+}
+
+/* first frame on a new connection, the tx path is idle */
+static void net_queue_resume(net_ctx_t *net)
+{
+    uint8_t payload[CTRL_RESUME_LEN];
+    payload[0] = CTRL_OP_RESUME;
+    frame_put_be32(payload + 1, net->session);
+    frame_put_be32(payload + 5, net->resend.head - 1);
+    frame_put_be32(payload + 9, net->resend.tail);
+    net_queue_frame(net, MSG_TYPE_CONTROL, 0, payload, sizeof(payload));
+    net->resuming = true;
+    net->resume_deadline_us = esp_timer_get_time() + NET_RESUME_WAIT_MS * 1000LL;
+}
+
+/* resume handshake done: what is still unsent now goes out ahead of live audio */
+static void net_resume_done(net_ctx_t *net, bool acked)
+{
+    uint32_t frames = resend_unsent(&net->resend);
+    net->resuming = false;
+    if (frames > 0) {
+        net->catchup_us = esp_timer_get_time();
+    }
+    if (acked) {
+        ESP_LOGI(TAG, "resume: server has up to frame %lu, resending %lu frames (%lu ms of audio)",
+                 (unsigned long)(net->resend.head - 1), (unsigned long)frames,
+                 (unsigned long)(frames * AUDIO_CHUNK_MAX / AUDIO_BYTES_PER_MS));
+    } else {
+        ESP_LOGW(TAG, "resume: no ACK in %d ms, resending all %lu buffered frames", NET_RESUME_WAIT_MS,
+                 (unsigned long)frames);
+    }
+}
+
+/* flags of a frame of net->rec: log-mel frames have neither format nor rate */
+static uint8_t net_audio_flags(const net_ctx_t *net)
+{
+    uint8_t lang = net->rec_lang;
+    if (net->rec->slots == CODEC_SLOTS_MEL) {
+        return lang;
+    }
+    return lang | (uint8_t)(net->audio_fmt << MSG_FLAG_FMT_SHIFT)
+           | (uint8_t)(codec_rate_code(&net->codec, net->audio_fmt) << MSG_FLAG_RATE_SHIFT);
+}
+
+/* payload of a piece of net->rec into dst: audio in the current format, log-mel frames as they are */
+static size_t net_encode(net_ctx_t *net, const uint8_t *audio, size_t len, uint8_t *dst, uint8_t *msg_type)
+{
+    if (net->rec->slots == CODEC_SLOTS_MEL) {
+        *msg_type = MSG_TYPE_MEL;
+        memcpy(dst, audio, len);
+        return len;
+    }
+    *msg_type = MSG_TYPE_AUDIO;
+    codec_t *codec = NET_CONVERSATION && net->rec_lang == MSG_FLAG_LANG2 ? &net->codec2 : &net->codec;
+    return codec_encode(codec, net->audio_fmt, net->rec->slots, net->rec_lang, audio, len, dst);
+}
+
+/* a frame of net->rec was built: per language count and capture to frame latency */
+static void net_stream_frame(net_ctx_t *net)
+{
+    uint32_t ms = ((uint32_t)esp_timer_get_time() - net->rec->ts_us) / 1000;
+    for (int i = 0; i < 2; i++) {
+        if (net->rec_lang & (MSG_FLAG_LANG1 << i)) {
+            net_stream_t *s = &net->streams[i];
+            s->frames++;
+            s->latency_ms_sum += ms;
+            if (ms > s->latency_ms_max) {
+                s->latency_ms_max = ms;
             }
-            else
-            {
-                ESP_LOGE(TAG, "Critical Error - State of FSM not defined!!!");
+        }
+    }
+}
+
+/* writes a numbered audio frame of a piece of net->rec in the current format to dst, returns its length */
+static size_t net_put_audio(net_ctx_t *net, uint8_t *dst, uint32_t seq, const uint8_t *audio, size_t len)
+{
+    size_t off = FRAME_HDR_SIZE + sizeof(audio_sub_hdr_t);
+    uint8_t msg_type;
+    size_t enc = net_encode(net, audio, len, dst + off, &msg_type);
+    frame_put_hdr(dst, msg_type, net_audio_flags(net) | MSG_FLAG_SEQ, sizeof(audio_sub_hdr_t) + enc);
+    frame_put_be32(dst + FRAME_HDR_SIZE + offsetof(audio_sub_hdr_t, seq), seq);
+    frame_put_be32(dst + FRAME_HDR_SIZE + offsetof(audio_sub_hdr_t, ts_us), net->rec->ts_us);
+    net_stream_frame(net);
+    return off + enc;
+}
+
+/* legacy frame without a sequence number of a piece of net->rec, in the current format */
+static void net_queue_audio(net_ctx_t *net, const uint8_t *audio, size_t len)
+{
+    uint8_t msg_type;
+    size_t enc = net_encode(net, audio, len, net->tx_buf + FRAME_HDR_SIZE, &msg_type);
+    frame_put_hdr(net->tx_buf, msg_type, net_audio_flags(net), enc);
+    net_stream_frame(net);
+    net->tx_data = net->tx_buf;
+    net->tx_len = FRAME_HDR_SIZE + enc;
+    net->tx_off = 0;
+    net->tx_resend = false;
+    net->audio_sent += enc;
+    net->audio_out += enc;
+}
+
+/* one controller period: backlog, throughput and RSSI pick the format of the next frames */
+static void net_update_quality(net_ctx_t *net, RingbufHandle_t audio_rb, int64_t now)
+{
+    UBaseType_t recs = 0;
+    vRingbufferGetInfo(audio_rb, NULL, NULL, NULL, NULL, &recs);
+    quality_in_t in = {
+        .backlog_ms = recs * AUDIO_CHUNK_MAX / AUDIO_BYTES_PER_MS,
+        .sent_bytes_per_s = (net->audio_out - net->quality_out) * 1000 / NET_QUALITY_MS,
+        .rssi = wifi_get_rssi(),
+    };
+    if (NET_RESUME) {
+        in.backlog_ms += resend_unsent(&net->resend) * AUDIO_CHUNK_MAX / AUDIO_BYTES_PER_MS;
+    }
+    net->quality_out = net->audio_out;
+    net->quality_us = now + NET_QUALITY_MS * 1000LL;
+    uint8_t fmt = quality_update(&net->quality, &in, (uint32_t)(now / 1000));
+    if (fmt != net->audio_fmt) {
+        ESP_LOGI(TAG, "audio %s -> %s: backlog %lu ms, %lu B/s sent, rssi %d", audio_fmt_names[net->audio_fmt],
+                 audio_fmt_names[fmt], (unsigned long)in.backlog_ms, (unsigned long)in.sent_bytes_per_s, in.rssi);
+        net->audio_fmt = fmt;
+    }
+}
+
+/* moves captured audio into resend slots as complete, numbered frames */
+static void net_buffer_audio(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    size_t len = 0;
+    const uint8_t *audio;
+    while ((audio = net_audio_take(net, audio_rb, AUDIO_CHUNK_FRAMES, &len)) != NULL) {
+        if (net->rec_lang != 0) {
+            uint32_t seq;
+            uint8_t *dst = resend_alloc(&net->resend, &seq);
+            resend_commit(&net->resend, net_put_audio(net, dst, seq, audio, len));
+        }
+        net_audio_done(net, audio_rb);
+    }
+}
+
+/* a datagram the stack cannot take right now is dropped, late audio is worth less than lost audio */
+static void net_udp_send(net_ctx_t *net, const uint8_t *data, size_t len)
+{
+    if (send(net->udp_sock, data, len, 0) < 0) {
+        if (net->udp_dropped++ == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOMEM)) {
+            ESP_LOGW(TAG, "UDP send failed: errno %d", errno);
+        }
+    }
+}
+
+/* sends captured audio as numbered datagrams, with a parity datagram after each full group */
+static void net_udp_audio(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    size_t rb_bytes = 0;
+    const uint8_t *audio;
+    while ((audio = net_audio_take(net, audio_rb, UDP_AUDIO_MAX / CODEC_RAW_FRAME, &rb_bytes)) != NULL) {
+        if (net->rec_lang != 0 && net->udp_sock >= 0) {
+            uint32_t seq = net->udp_seq++;
+            size_t len = net_put_audio(net, net->udp_buf, seq, audio, rb_bytes);
+            net_udp_send(net, net->udp_buf, len);
+            net->udp_frames++;
+            net->audio_out += len - FRAME_HDR_SIZE;
+            uint8_t flags = net->udp_buf[offsetof(msg_hdr_t, flags)];
+            if (NET_FEC_GROUP > 1 && fec_enc_add(&net->fec, seq, flags, net->udp_buf + FRAME_HDR_SIZE,
+                                                 len - FRAME_HDR_SIZE)) {
+                const uint8_t *parity;
+                size_t parity_len = fec_enc_frame(&net->fec, &parity);
+                net_udp_send(net, parity, parity_len);
+                net->udp_parity++;
             }
         }
-        ESP_LOGE(TAG, "Shutting down socket and restarting...");
-        if (sock > 0) {
-            shutdown(sock, 0);
-            close(sock);
-            sock = 0;
+        net_audio_done(net, audio_rb);
+    }
+}
+
+/* next audio frame from the resend buffer; false if there is none to send yet */
+static bool net_fill_resend(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    if (net->resuming) {
+        if (esp_timer_get_time() < net->resume_deadline_us) {
+            net_buffer_audio(net, audio_rb);
+            return false;
         }
+        net_resume_done(net, false);
+    }
+    net_buffer_audio(net, audio_rb);
+    if (net->catchup_us != 0 && resend_unsent(&net->resend) <= 1) {
+        ESP_LOGI(TAG, "resume: back to live audio after %lu ms",
+                 (unsigned long)((esp_timer_get_time() - net->catchup_us) / 1000));
+        net->catchup_us = 0;
     }
-    free(int_buf);
+    const uint8_t *frame;
+    size_t len;
+    if (!resend_peek(&net->resend, &frame, &len)) {
+        return false;
+    }
+    if (len - FRAME_HDR_SIZE > net_credit_left(net)) {
+        /* the frame stays buffered, resend overflow bounds the backlog */
+        net->credit_wait = true;
+        return false;
+    }
+    net->audio_sent += len - FRAME_HDR_SIZE;
+    net->audio_out += len - FRAME_HDR_SIZE;
+    net->tx_data = frame;
+    net->tx_len = len;
+    net->tx_off = 0;
+    net->tx_resend = true;
+    return true;
 }
 
-void tcp_rx_task(void *args)
+/* queues the next frame: a PONG, a CLOCK estimate, a PING or TIME when due, else audio if the
+ * capture ring has some. false if there is nothing to send */
+static bool net_fill_tx(net_ctx_t *net, RingbufHandle_t audio_rb)
 {
-    /* reuses the same socket created with the tx task */
-    uint8_t hdr_buf[sizeof(msg_hdr_t)];
-    ESP_LOGI(TAG2, "TCP RX task started");
-    uint32_t rx_log_ctr = 0;
-    while (1) {
-        xSemaphoreTake(sock_ready, portMAX_DELAY);
-        ESP_LOGI(TAG2, "TCP RX task connected");
+    if (net->pong_pending) {
+        net->pong_pending = false;
+        net_queue_ctrl(net, CTRL_OP_PONG, net->pong_token);
+        return true;
+    }
+    if (net->clock_pending) {
+        net->clock_pending = false;
+        net_queue_clock(net);
+        return true;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now >= net->next_ping_us) {
+        net->next_ping_us = now + NET_PING_MS * 1000LL;
+        net_queue_ctrl(net, CTRL_OP_PING, (uint32_t)now);
+        return true;
+    }
+    if (NET_CLOCK_SYNC && now >= net->next_time_us) {
+        net->next_time_us = now + NET_CLOCK_SYNC_MS * 1000LL;
+        net_queue_time(net, now);
+        return true;
+    }
+    net->credit_wait = false;
+    if (NET_RESUME) {
+        return net_fill_resend(net, audio_rb);
+    }
+    if (NET_UDP) {
+        /* audio goes out in net_udp_audio */
+        return false;
+    }
 
-        while (1)
-        {
-            if(!recv_all(sock, hdr_buf, sizeof(msg_hdr_t))) {
-                ESP_LOGE(TAG2, "Failed to receive message header");
-                break;
+    /* whole sample frames only, the encoder works on them; credit is counted as if raw (log-mel frames
+     * as they are) */
+    uint32_t credit = net_credit_left(net);
+    size_t max = credit < AUDIO_CHUNK_MAX ? credit / NET_CREDIT_FRAME : AUDIO_CHUNK_FRAMES;
+    if (max == 0) {
+        net->credit_wait = true;
+        return false;
+    }
+    size_t rb_bytes = 0;
+    const uint8_t *audio;
+    while ((audio = net_audio_take(net, audio_rb, max, &rb_bytes)) != NULL) {
+        uint8_t lang = net->rec_lang;
+        if (lang == 0) {
+            /* read audio_rb but don't send */
+            net_audio_done(net, audio_rb);
+            continue;
+        }
+        net_queue_audio(net, audio, rb_bytes);
+        net_audio_done(net, audio_rb);
+        if ((net->tx_log_ctr++ % 100) == 0) {
+            ESP_LOGD(TAG, "TCP tx hdr: msg_type=%d flags=%d payload_len=%d",
+                     net->tx_buf[offsetof(msg_hdr_t, msg_type)], lang, (int)rb_bytes);
+        }
+        return true;
+    }
+    return false;
+}
+
+/* sends what the socket takes of the pending frame; false on a link error */
+static bool net_send(net_ctx_t *net)
+{
+    while (net->tx_off < net->tx_len) {
+        int sent = send(net->sock, net->tx_data + net->tx_off, net->tx_len - net->tx_off, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
             }
-            msg_hdr_t *hdr = (msg_hdr_t *)hdr_buf;
-            uint32_t payload_len = ntohl(hdr->payload_len);
-            if ((rx_log_ctr++ % 50) == 0) {
-                ESP_LOGI(TAG2, "TCP rx hdr: msg_type=%d flags=%d payload_len=%d",
-                         hdr->msg_type, hdr->flags, (int)payload_len);
+            ESP_LOGE(TAG, "send failed: errno %d", errno);
+            return false;
+        }
+        net->tx_off += sent;
+    }
+    if (net->tx_resend) {
+        resend_mark_sent(&net->resend);
+        net->tx_resend = false;
+    }
+    net->tx_len = 0;
+    net->tx_off = 0;
+    return true;
+}
+
+/* moves frames to the socket until there is nothing left or the socket is full */
+static bool net_pump_tx(net_ctx_t *net, RingbufHandle_t audio_rb)
+{
+    while (1) {
+        if (net->tx_len == 0 && !net_fill_tx(net, audio_rb)) {
+            return true;
+        }
+        if (!net_send(net)) {
+            return false;
+        }
+        if (net->tx_len > 0) {
+            return true;
+        }
+    }
+}
+
+/* clock sync answer: t4 is when the recv() that brought it returned */
+static void net_rx_time(net_ctx_t *net, const uint8_t *payload)
+{
+    int64_t t1 = (int64_t)frame_get_be64(payload + 1);
+    int64_t t2 = (int64_t)frame_get_be64(payload + 9);
+    int64_t t3 = (int64_t)frame_get_be64(payload + 17);
+    if (!tsync_update(&net->tsync, t1, t2, t3, net->last_rx_us)) {
+        return;
+    }
+    portENTER_CRITICAL(&clock_mux);
+    clock_est = net->tsync.est;
+    clock_valid = true;
+    portEXIT_CRITICAL(&clock_mux);
+    net->clock_pending = true;
+}
+
+static void net_rx_ctrl(net_ctx_t *net, const frame_t *frame)
+{
+    if (frame->len < CTRL_PING_LEN) {
+        return;
+    }
+    if (frame->payload[0] == CTRL_OP_TIME_REPLY) {
+        if (NET_CLOCK_SYNC && frame->len >= CTRL_TIME_REPLY_LEN) {
+            net_rx_time(net, frame->payload);
+        }
+        return;
+    }
+    uint32_t token = frame_get_be32(frame->payload + 1);
+    if (frame->payload[0] == CTRL_OP_ACK) {
+        if (NET_RESUME) {
+            resend_ack(&net->resend, token);
+            if (net->resuming) {
+                net_resume_done(net, true);
             }
-            
-            if (payload_len > TEXT_BUF_SIZE) {
-                ESP_LOGE(TAG2, "Payload length %d exceeds buffer size %d", payload_len, TEXT_BUF_SIZE);
-                uint8_t discard_buf[32];
-                size_t bytes_to_discard = payload_len;
-                while (bytes_to_discard > 0) {
-                    size_t chunk_size = (bytes_to_discard > sizeof(discard_buf)) ? sizeof(discard_buf) : bytes_to_discard;
-                    if (!recv_all(sock, discard_buf, chunk_size)) {
-                        ESP_LOGE(TAG2, "Failed to discard excess payload");
-                        break;
-                    }
+        }
+    } else if (frame->payload[0] == CTRL_OP_CREDIT) {
+        net->credit_on = true;
+        net->credit_limit = token;
+    } else if (frame->payload[0] == CTRL_OP_PING) {
+        net->pong_token = token;
+        net->pong_pending = true;
+    } else if (frame->payload[0] == CTRL_OP_PONG) {
+        uint32_t rtt = (uint32_t)esp_timer_get_time() - token;
+        net->peer_pongs = true;
+        net->rtt_us_last = rtt;
+        if (net->rtt_count == 0 || rtt < net->rtt_us_min) {
+            net->rtt_us_min = rtt;
+        }
+        if (rtt > net->rtt_us_max) {
+            net->rtt_us_max = rtt;
+        }
+        net->rtt_us_sum += rtt;
+        net->rtt_count++;
+    }
+}
+
+/* true if a caption was queued for the display */
+static bool net_rx_frame(net_ctx_t *net, const frame_t *frame)
+{
+    if (frame->msg_type == MSG_TYPE_CONTROL) {
+        net_rx_ctrl(net, frame);
+        return false;
+    }
+    if ((net->rx_log_ctr++ % 50) == 0) {
+        ESP_LOGI(TAG, "TCP rx hdr: msg_type=%d flags=%d payload_len=%d",
+                 frame->msg_type, frame->flags, (int)frame->len);
+    }
+    uint8_t flags = frame->flags;
+#if CONFIG_APP_AUDIO_CONVERSATION
+    if (!(flags & (MSG_FLAG_SCREEN1 | MSG_FLAG_SCREEN2))) {
+        /* a caption in a language is for whoever reads it: LANG1 (the subject's words) the wearer */
+        if (flags & MSG_FLAG_LANG1) {
+            flags |= MSG_FLAG_SCREEN1;
+        }
+        if (flags & MSG_FLAG_LANG2) {
+            flags |= MSG_FLAG_SCREEN2;
+        }
+    }
+#endif
+    if (!(flags & (MSG_FLAG_SCREEN1 | MSG_FLAG_SCREEN2))) {
+        ESP_LOGW(TAG, "Unknown display flag: %d", frame->flags);
+        return false;
+    }
+
+    text_rec_t *rec = NULL;
+    if (xRingbufferSendAcquire(text_rb, (void **)&rec, sizeof(text_rec_t) + frame->len + 1, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Text ring full, message dropped");
+        return false;
+    }
+    rec->rx_us = (uint32_t)esp_timer_get_time();
+    rec->len = (uint16_t)frame->len;
+    rec->flags = flags;
+    memcpy(rec->text, frame->payload, frame->len);
+    rec->text[rec->len] = '\0';
+    xRingbufferSendComplete(text_rb, rec);
+    return true;
+}
+
+/* one recv() of whatever is available, then every complete frame in the buffer;
+ * false on a link error or EOF */
+static bool net_recv(net_ctx_t *net)
+{
+    size_t avail = 0;
+    uint8_t *dst = frame_parser_space(&net->rx, &avail);
+    int received = recv(net->sock, dst, avail, 0);
+    if (received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        ESP_LOGE(TAG, "recv failed: errno %d", errno);
+        return false;
+    } else if (received == 0) {
+        ESP_LOGW(TAG, "Connection closed");
+        return false;
+    }
+    frame_parser_commit(&net->rx, received);
+    net->last_rx_us = esp_timer_get_time();
 
+    frame_t frame;
+    bool queued = false;
+    while (frame_parser_next(&net->rx, &frame)) {
+        queued |= net_rx_frame(net, &frame);
+    }
+    if (queued) {
+        display_notify_text();
+    }
+    if (net->rx.stats.oversize != net->rx_oversize) {
+        net->rx_oversize = net->rx.stats.oversize;
+        ESP_LOGE(TAG, "Payload exceeds buffer size %d, skipped (%lu so far)", TEXT_MSG_MAX,
+                 (unsigned long)net->rx_oversize);
+    }
+    if (net->rx.stats.resyncs != net->rx_resyncs) {
+        net->rx_resyncs = net->rx.stats.resyncs;
+        ESP_LOGW(TAG, "rx framing lost, %lu resyncs, %llu bytes dropped", (unsigned long)net->rx_resyncs,
+                 (unsigned long long)net->rx.stats.dropped_bytes);
+    }
+    return true;
+}
+
+static void tcp_net_task(void *args)
+{
+    net_ctx_t net = {
+        .state = NET_STATE_CLOSED,
+        .sock = -1,
+        .udp_sock = -1,
+        .rand_state = net_seed() | 1,
+        .stats_log_us = esp_timer_get_time() + NET_STATS_LOG_MS * 1000LL,
+    };
+    net.tx_buf = (uint8_t *)calloc(1, TX_BUF_SIZE);
+    assert(net.tx_buf);
+    uint8_t *rx_buf = (uint8_t *)malloc(RX_BUF_SIZE);
+    assert(rx_buf);
+    frame_parser_init(&net.rx, rx_buf, RX_BUF_SIZE, TEXT_MSG_MAX);
+    tsync_init(&net.tsync);
+    if (NET_RESUME) {
+        bool ok = resend_init(&net.resend, NET_RESEND_SLOTS < 2 ? 2 : NET_RESEND_SLOTS, AUDIO_FRAME_MAX);
+        assert(ok);
+        (void)ok;
+        net.session = net_rand(&net);
+        ESP_LOGI(TAG, "resend buffer %d frames (%d ms), session %08lx", NET_RESEND_SLOTS,
+                 NET_RESEND_SLOTS * AUDIO_CHUNK_MAX / AUDIO_BYTES_PER_MS, (unsigned long)net.session);
+    }
+    uint8_t *fec_buf = NULL;
+    if (NET_UDP) {
+        net.udp_buf = (uint8_t *)malloc(UDP_FRAME_MAX);
+        assert(net.udp_buf);
+        if (NET_FEC_GROUP > 1) {
+            fec_buf = (uint8_t *)malloc(FEC_FRAME_SIZE(UDP_FRAME_MAX - FRAME_HDR_SIZE));
+            assert(fec_buf);
+            fec_enc_init(&net.fec, fec_buf, UDP_FRAME_MAX - FRAME_HDR_SIZE, NET_FEC_GROUP);
+        }
+        ESP_LOGI(TAG, "audio over UDP, %d byte datagrams, parity every %d", UDP_AUDIO_MAX, NET_FEC_GROUP);
+    }
+    ESP_LOGD(TAG, "TCP tx buffer size %zu initialized", TX_BUF_SIZE);
+
+    /* get ringbuffer handle */
+    RingbufHandle_t audio_rb = audio_get_rb();
+    net.audio_fmt = NET_AUDIO_BEST;
+    bool codec_ok = codec_init(&net.codec, AUDIO_CAPTURE_RATE, NET_AUDIO_S16_RATE);
+    if (NET_CONVERSATION) {
+        codec_ok = codec_ok && codec_init(&net.codec2, AUDIO_CAPTURE_RATE, NET_AUDIO_S16_RATE);
+        ESP_LOGI(TAG, "conversation mode: LANG1 and LANG2 audio while their mic has voice");
+    }
+    assert(codec_ok);
+    (void)codec_ok;
+    if (NET_MEL) {
+        ESP_LOGI(TAG, "log-mel frames instead of audio, %d bins every %d ms", MEL_BINS, MEL_HOP * 1000 / MEL_RATE);
+    } else {
+        ESP_LOGI(TAG, "audio %s at %lu Hz (s16 at %lu Hz)", audio_fmt_names[net.audio_fmt],
+                 (unsigned long)codec_rate(&net.codec, net.audio_fmt), (unsigned long)NET_AUDIO_S16_RATE);
+    }
+    if (NET_ADAPTIVE) {
+        quality_init(&net.quality, &net.codec, NET_AUDIO_BEST, AUDIO_FMT_ADPCM_8K,
+                     (uint32_t)(esp_timer_get_time() / 1000));
+        ESP_LOGI(TAG, "adaptive audio, starting at %s", audio_fmt_names[net.audio_fmt]);
+    }
+
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        if (NET_RESUME && net.state != NET_STATE_CONNECTED) {
+            /* keep what is captured while the link is down */
+            net_buffer_audio(&net, audio_rb);
+        }
+        net_trim_audio(&net, audio_rb);
+        if (net.state == NET_STATE_CLOSED) {
+            if (now < net.deadline_us) {
+                /* short naps, the capture ring still needs looking after */
+                int64_t wait_ms = (net.deadline_us - now) / 1000;
+                if (wait_ms > NET_POLL_MS) {
+                    wait_ms = NET_POLL_MS;
                 }
+                vTaskDelay(pdMS_TO_TICKS(wait_ms) + 1);
                 continue;
             }
-
-            text_msg_t text_msg = {
-                .len = payload_len
-            };
-
-            if (!recv_all(sock, text_msg.payload, payload_len)) {
-                ESP_LOGE(TAG2, "Failed to receive message payload");
-                break;
+            net_open(&net);
+            if (net.state == NET_STATE_CLOSED) {
+                continue;
             }
-            if ((rx_log_ctr % 50) == 0) {
-                ESP_LOGI(TAG2, "TCP rx payload ok: %d bytes", (int)payload_len);
+        }
+        if (net.state == NET_STATE_CONNECTING && now >= net.deadline_us) {
+            ESP_LOGE(TAG, "Socket connect timed out");
+            net_close(&net);
+            continue;
+        }
+        if (net.state == NET_STATE_CONNECTED && NET_PEER_TIMEOUT_MS > 0 && net.peer_pongs &&
+            now - net.last_rx_us >= NET_PEER_TIMEOUT_MS * 1000LL) {
+            ESP_LOGE(TAG, "Peer silent for %d ms", NET_PEER_TIMEOUT_MS);
+            net_close(&net);
+            continue;
+        }
+        if (now >= net.stats_log_us) {
+            net.stats_log_us = now + NET_STATS_LOG_MS * 1000LL;
+            net_log_stats(&net);
+        }
+        if (NET_UDP && net.state == NET_STATE_CONNECTED) {
+            /* independent of the TCP send queue, a stalled TCP segment must not hold audio back */
+            net_udp_audio(&net, audio_rb);
+        }
+        if (net.state == NET_STATE_CONNECTED) {
+            net_set_starved(&net, net.credit_wait);
+            if (NET_ADAPTIVE && now >= net.quality_us) {
+                net_update_quality(&net, audio_rb, now);
             }
-            if (hdr->flags & 0x04) {
-                if (xQueueSend(disp1_q, &text_msg, pdMS_TO_TICKS(DELAYTIME)) != pdTRUE) {
-                    ESP_LOGW(TAG2, "Display 1 queue full, message dropped");
-                }
-            } else if (hdr->flags & 0x08) {
-                if (xQueueSend(disp2_q, &text_msg, pdMS_TO_TICKS(DELAYTIME)) != pdTRUE) {
-                    ESP_LOGW(TAG2, "Display 2 queue full, message dropped");
-                }
-            } else {
-                ESP_LOGW(TAG2, "Unknown display flag: %d", hdr->flags);
+        }
+        if (net.state == NET_STATE_CONNECTED && net.tx_len == 0 && !net_pump_tx(&net, audio_rb)) {
+            net_close(&net);
+            continue;
+        }
+
+        fd_set rfds;
+        fd_set wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        if (net.state == NET_STATE_CONNECTED) {
+            FD_SET(net.sock, &rfds);
+        }
+        if (net.state == NET_STATE_CONNECTING || net.tx_len > 0) {
+            FD_SET(net.sock, &wfds);
+        }
+        struct timeval tv = {
+            .tv_sec = 0,
+            .tv_usec = NET_POLL_MS * 1000,
+        };
+        int n = select(net.sock + 1, &rfds, &wfds, NULL, &tv);
+        if (n < 0) {
+            /* the linux target's FreeRTOS port interrupts syscalls with its tick signal */
+            if (errno == EINTR) {
+                continue;
+            }
+            ESP_LOGE(TAG, "select failed: errno %d", errno);
+            net_close(&net);
+            continue;
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        if (net.state == NET_STATE_CONNECTING) {
+            if (FD_ISSET(net.sock, &wfds)) {
+                net_finish_connect(&net);
             }
+            continue;
+        }
+        if (FD_ISSET(net.sock, &rfds) && !net_recv(&net)) {
+            net_close(&net);
+            continue;
+        }
+        if (FD_ISSET(net.sock, &wfds) && !net_pump_tx(&net, audio_rb)) {
+            net_close(&net);
+            continue;
         }
-        ESP_LOGI(TAG2, "TCP RX task waiting for reconnect");
     }
+    free(fec_buf);
+    free(net.udp_buf);
+    free(rx_buf);
+    free(net.tx_buf);
 }
 
 void tcp_make_tasks(void)
 {
     tcp_init_queues();
-    sock_ready = xSemaphoreCreateBinary();
-    assert(sock_ready);
-    xTaskCreatePinnedToCore(tcp_tx_task, "tcp_tx_task", 4096, NULL, 6, NULL, 0);
-    xTaskCreatePinnedToCore(tcp_rx_task, "tcp_rx_task", 4096, NULL, 6, NULL, 0);
+    xTaskCreatePinnedToCore(tcp_net_task, "tcp_net_task", 5120, NULL, 6, NULL, 0);
 }
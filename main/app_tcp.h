@@ -1,26 +1,28 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/ringbuf.h"
+#include "app_frame.h"
 
 /* the following is simple enough to not need macros */
-#define TEXT_BUF_SIZE 128 // max text message size
-
-typedef struct __attribute__((packed)) {
-    uint8_t magic; 
-    uint8_t version;
-    uint8_t msg_type;     // AUDIO = 1, TEXT = 2, CONTROL = 3
-    uint8_t flags;        // LANG1 = 1, LANG2 = 2, SCREEN1 = 4, SCREEN2 = 8
-    uint32_t payload_len; // bytes after header
-} msg_hdr_t;
+#define TEXT_MSG_MAX 1024 // max text message size
 
+/* one text message in the text ring (no-split), display_task reads it in place */
 typedef struct {
-    uint16_t len;
-    uint8_t payload[TEXT_BUF_SIZE];
-} text_msg_t;
+    uint32_t rx_us;       // esp_timer time of receipt (low 32 bits, diffs wrap safely), for latency stats
+    uint16_t len;         // bytes in text, not counting the NUL
+    uint8_t flags;        // msg_hdr_t flags, selects the screen
+    char text[];          // UTF-8, NUL terminated
+} text_rec_t;
+
+RingbufHandle_t tcp_rx_get_text_rb(void);
+
+/* the server has held audio back with CREDIT for a while, shown on the operator screen */
+bool tcp_server_busy(void);
 
-QueueHandle_t tcp_rx_get_disp1_q(void);
-QueueHandle_t tcp_rx_get_disp2_q(void);
+/* esp_timer time dev_us on the server's clock (APP_NET_CLOCK_SYNC); false before the first time exchange */
+bool tcp_server_time(int64_t dev_us, int64_t *server_us);
 
 void tcp_make_tasks();
@@ -0,0 +1,157 @@
+/* Eric Liu 2026
+
+Tile diff for the display flush (app_disp_flush.c). The panel is split into
+size x size tiles and a 32-bit FNV-1a hash is kept of what each tile
+currently shows, instead of a copy of the panel: 4 bytes per tile rather
+than 2 per pixel.
+
+A flushed area is walked in bands that follow the tile grid, so every band
+sits inside one tile row. A tile the band covers completely is hashed from
+the render buffer (RGB565, L8 or I1) and skipped when the hash did not
+change; runs of changed tiles in a band go out as one rect. A tile the area
+only partly covers is always sent and its hash forgotten, as the rest of it
+was not looked at.
+
+No ESP-IDF or LVGL dependencies, so tools/tile_eval.c replays captions
+through it on a plain host compiler.
+
+INPUTS: render buffers of flushed areas
+OUTPUTS: rects to send, sent/skipped counters
+
+*/
+
+#include "app_tile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_DEFAULT_SIZE 16
+
+bool tile_map_init(tile_map_t *t, uint16_t hres, uint16_t vres, uint16_t size, uint8_t bpp)
+{
+    *t = (tile_map_t) { 0 };
+    t->size = size ? size : TILE_DEFAULT_SIZE;
+    t->hres = hres;
+    t->vres = vres;
+    t->bpp = bpp;
+    t->tiles_x = (uint16_t)((hres + t->size - 1) / t->size);
+    t->tiles_y = (uint16_t)((vres + t->size - 1) / t->size);
+    t->hash = (uint32_t *)calloc((size_t)t->tiles_x * t->tiles_y, sizeof(uint32_t));
+    return t->hash != NULL;
+}
+
+void tile_map_free(tile_map_t *t)
+{
+    free(t->hash);
+    *t = (tile_map_t) { 0 };
+}
+
+void tile_map_invalidate(tile_map_t *t)
+{
+    if (t->hash) {
+        memset(t->hash, 0, (size_t)t->tiles_x * t->tiles_y * sizeof(uint32_t));
+    }
+}
+
+static inline uint32_t hash_step(uint32_t h, uint32_t v)
+{
+    return (h ^ v) * 16777619u;   // FNV-1a prime
+}
+
+uint32_t tile_hash_rect(uint8_t bpp, const tile_src_t *src, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    uint32_t hash = 2166136261u;
+    const uint8_t *row = src->px + (size_t)y * src->stride;
+    for (int32_t r = 0; r < h; r++) {
+        switch (bpp) {
+        case 1: {
+            uint32_t word = 0;
+            for (int32_t i = 0; i < w; i++) {
+                int32_t b = x + i;
+                word = (word << 1) | ((row[b >> 3] >> (7 - (b & 7))) & 1);
+                if ((i & 31) == 31) {
+                    hash = hash_step(hash, word);
+                    word = 0;
+                }
+            }
+            hash = hash_step(hash, word);
+            break;
+        }
+        case 8:
+            for (int32_t i = 0; i < w; i++) {
+                hash = hash_step(hash, row[x + i]);
+            }
+            break;
+        default: {
+            const uint16_t *px = (const uint16_t *)row + x;
+            for (int32_t i = 0; i < w; i++) {
+                hash = hash_step(hash, px[i]);
+            }
+            break;
+        }
+        }
+        row += src->stride;
+    }
+    return (hash == TILE_HASH_UNKNOWN) ? 1u : hash;
+}
+
+/* one band of rows [y, y + h) inside a single tile row: emit runs of changed tiles */
+static void tile_map_band(tile_map_t *t, const tile_src_t *src, int32_t y, int32_t h, tile_emit_cb_t emit,
+                          void *arg)
+{
+    const int32_t T = t->size;
+    const int32_t abs_y = src->y1 + y;
+    const int32_t ty = abs_y / T;
+    const int32_t tile_y1 = ty * T;
+    const int32_t tile_y2 = (tile_y1 + T < t->vres) ? tile_y1 + T : t->vres;
+    const bool rows_covered = (abs_y == tile_y1) && (abs_y + h == tile_y2);
+
+    int32_t run_x = -1;
+    for (int32_t tx = src->x1 / T; tx <= src->x2 / T; tx++) {
+        const int32_t tile_x1 = tx * T;
+        const int32_t tile_x2 = (tile_x1 + T < t->hres) ? tile_x1 + T : t->hres;
+        const int32_t seg_x1 = (tile_x1 > src->x1) ? tile_x1 : src->x1;
+        const int32_t seg_x2 = (tile_x2 < src->x2 + 1) ? tile_x2 : src->x2 + 1;
+        uint32_t *slot = &t->hash[ty * t->tiles_x + tx];
+
+        bool changed = true;
+        if (rows_covered && seg_x1 == tile_x1 && seg_x2 == tile_x2) {
+            uint32_t hash = tile_hash_rect(t->bpp, src, seg_x1 - src->x1, y, seg_x2 - seg_x1, h);
+            changed = (hash != *slot);
+            *slot = hash;
+        } else {
+            *slot = TILE_HASH_UNKNOWN;
+        }
+
+        if (changed) {
+            t->tiles_sent++;
+            if (run_x < 0) {
+                run_x = seg_x1;
+            }
+        } else {
+            t->tiles_skipped++;
+            t->bytes_skipped += (uint64_t)(seg_x2 - seg_x1) * h * sizeof(uint16_t);
+            if (run_x >= 0) {
+                emit(arg, run_x - src->x1, y, seg_x1 - run_x, h);
+                run_x = -1;
+            }
+        }
+    }
+    if (run_x >= 0) {
+        emit(arg, run_x - src->x1, y, src->x2 + 1 - run_x, h);
+    }
+}
+
+void tile_map_flush(tile_map_t *t, const tile_src_t *src, tile_emit_cb_t emit, void *arg)
+{
+    const int32_t h = src->y2 - src->y1 + 1;
+    int32_t y = 0;
+    while (y < h) {
+        int32_t band = t->size - ((src->y1 + y) % t->size);
+        if (band > h - y) {
+            band = h - y;
+        }
+        tile_map_band(t, src, y, band, emit, arg);
+        y += band;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tile diff for the display flush: a hash of what every tile of a panel shows, and the runs
+ * of tiles in a flushed area that changed since they were last sent */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TILE_HASH_UNKNOWN 0u
+
+typedef struct {
+    uint32_t *hash;              // what each tile currently shows, TILE_HASH_UNKNOWN = not known
+    uint16_t size;               // tile edge in pixels
+    uint16_t tiles_x;
+    uint16_t tiles_y;
+    uint16_t hres;
+    uint16_t vres;
+    uint8_t bpp;                 // render format: 16 (RGB565), 8 (L8) or 1 (I1, MSB first)
+    uint32_t tiles_sent;
+    uint32_t tiles_skipped;
+    uint64_t bytes_skipped;      // RGB565 bytes the skipped tiles would have cost on the bus
+} tile_map_t;
+
+/* one flushed area: its render buffer and where it sits on the panel, x2 and y2 inclusive */
+typedef struct {
+    const uint8_t *px;
+    uint32_t stride;             // bytes per row
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+} tile_src_t;
+
+/* sends the rect (x, y, w, h) of the area, relative to its top left corner */
+typedef void (*tile_emit_cb_t)(void *arg, int32_t x, int32_t y, int32_t w, int32_t h);
+
+/* size 0 means 16; false if out of memory */
+bool tile_map_init(tile_map_t *t, uint16_t hres, uint16_t vres, uint16_t size, uint8_t bpp);
+void tile_map_free(tile_map_t *t);
+
+/* forget what the panel shows, every tile is sent next time */
+void tile_map_invalidate(tile_map_t *t);
+
+/* hash of the area-relative rect in render format; never TILE_HASH_UNKNOWN */
+uint32_t tile_hash_rect(uint8_t bpp, const tile_src_t *src, int32_t x, int32_t y, int32_t w, int32_t h);
+
+/* emits the changed parts of the area: bands along the tile rows, in each the runs of changed
+ * tiles as one rect. Tiles the area covers completely are hashed and skipped when unchanged,
+ * partly covered ones are always sent and forgotten */
+void tile_map_flush(tile_map_t *t, const tile_src_t *src, tile_emit_cb_t emit, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,142 @@
+/* Eric Liu 2026
+
+Clock sync with the server, NTP style. The headset sends its esp_timer time
+t1, the server notes when that arrived (t2) and when its answer leaves (t3),
+and the headset notes when the answer arrives (t4). On a symmetric path the
+server clock is ahead of the device clock by ((t2 - t1) + (t3 - t4)) / 2,
+wrong by at most half the round trip (t4 - t1) - (t3 - t2).
+
+Queueing only ever adds delay, so of every TSYNC_BURST exchanges only the
+fastest counts: its round trip bounds its error the tightest. The burst
+winners go into a history of TSYNC_HISTORY points, and a least squares line
+through them gives the offset at the newest point and the drift between the
+two crystals. Until the history spans TSYNC_MIN_SPAN_US the drift stays at
+its last value (0 at first), and until the first burst is done the fastest
+exchange so far stands in, so an estimate exists after one reply.
+
+An exchange more than TSYNC_STEP_US (plus its round trip) off the estimate
+means the server clock jumped, e.g. a restarted server on another clock:
+the history is dropped and the estimate starts over.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: t1..t4 of every exchange
+OUTPUTS: device time to server time
+
+*/
+
+#include "app_tsync.h"
+
+#include <math.h>
+#include <string.h>
+
+#define TSYNC_MIN_SPAN_US 10000000       // points at least this far apart before a drift is fitted
+#define TSYNC_STEP_US 50000              // an exchange this far off the estimate: the server clock jumped
+#define TSYNC_MAX_DRIFT_PPB 500000       // fits past 500 ppm are noise, not crystals
+
+void tsync_init(tsync_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+int64_t tsync_to_server(const tsync_est_t *est, int64_t dev_us)
+{
+    return dev_us + est->offset_us + (dev_us - est->ref_us) * est->drift_ppb / 1000000000;
+}
+
+/* offset at the newest point and drift from the history */
+static void tsync_fit(tsync_t *t)
+{
+    const tsync_point_t *newest = &t->hist[(t->hist_next + TSYNC_HISTORY - 1) % TSYNC_HISTORY];
+    double sx = 0.0, sy = 0.0;
+    int64_t oldest_us = newest->dev_us;
+    uint32_t delay_min = newest->delay_us;
+    for (int i = 0; i < t->hist_n; i++) {
+        const tsync_point_t *p = &t->hist[i];
+        sx += (double)(p->dev_us - newest->dev_us);
+        sy += (double)(p->offset_us - newest->offset_us);
+        oldest_us = p->dev_us < oldest_us ? p->dev_us : oldest_us;
+        delay_min = p->delay_us < delay_min ? p->delay_us : delay_min;
+    }
+    double mx = sx / t->hist_n;
+    double my = sy / t->hist_n;
+    double drift = t->est.drift_ppb / 1e9;
+    if (newest->dev_us - oldest_us >= TSYNC_MIN_SPAN_US) {
+        double sxx = 0.0, sxy = 0.0;
+        for (int i = 0; i < t->hist_n; i++) {
+            double x = (double)(t->hist[i].dev_us - newest->dev_us) - mx;
+            double y = (double)(t->hist[i].offset_us - newest->offset_us) - my;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        drift = sxy / sxx;
+        if (drift > TSYNC_MAX_DRIFT_PPB / 1e9) {
+            drift = TSYNC_MAX_DRIFT_PPB / 1e9;
+        } else if (drift < -TSYNC_MAX_DRIFT_PPB / 1e9) {
+            drift = -TSYNC_MAX_DRIFT_PPB / 1e9;
+        }
+    }
+    /* line through the centroid with that slope, at the newest point */
+    double at_newest = my - drift * mx;
+    double ss = 0.0;
+    for (int i = 0; i < t->hist_n; i++) {
+        double x = (double)(t->hist[i].dev_us - newest->dev_us);
+        double r = (double)(t->hist[i].offset_us - newest->offset_us) - (at_newest + drift * x);
+        ss += r * r;
+    }
+    t->est.ref_us = newest->dev_us;
+    t->est.offset_us = newest->offset_us + (int64_t)llround(at_newest);
+    t->est.drift_ppb = (int32_t)lround(drift * 1e9);
+    t->est.err_us = delay_min / 2 + (uint32_t)lround(sqrt(ss / t->hist_n));
+    t->valid = true;
+}
+
+bool tsync_update(tsync_t *t, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    int64_t round_trip = t4 - t1;
+    int64_t turnaround = t3 - t2;
+    if (round_trip < 0 || turnaround < 0 || turnaround > round_trip) {
+        t->rejected++;
+        return false;
+    }
+    tsync_point_t p = {
+        .dev_us = t1 + round_trip / 2,
+        .offset_us = ((t2 - t1) + (t3 - t4)) / 2,
+        .delay_us = (uint32_t)(round_trip - turnaround),
+    };
+    t->exchanges++;
+    if (t->valid) {
+        int64_t off = p.offset_us - (tsync_to_server(&t->est, p.dev_us) - p.dev_us);
+        if (off > TSYNC_STEP_US + (int64_t)p.delay_us || off < -TSYNC_STEP_US - (int64_t)p.delay_us) {
+            uint32_t exchanges = t->exchanges, rejected = t->rejected, steps = t->steps;
+            tsync_init(t);
+            t->exchanges = exchanges;
+            t->rejected = rejected;
+            t->steps = steps + 1;
+        }
+    }
+
+    if (t->burst_n == 0 || p.delay_us < t->burst_best.delay_us) {
+        t->burst_best = p;
+    }
+    t->burst_n++;
+    if (t->hist_n == 0) {
+        /* no history yet: the fastest exchange so far is the estimate */
+        t->est.ref_us = t->burst_best.dev_us;
+        t->est.offset_us = t->burst_best.offset_us;
+        t->est.err_us = t->burst_best.delay_us / 2;
+        t->valid = true;
+    }
+    if (t->burst_n < TSYNC_BURST) {
+        return true;
+    }
+    t->hist[t->hist_next] = t->burst_best;
+    t->hist_next = (uint8_t)((t->hist_next + 1) % TSYNC_HISTORY);
+    if (t->hist_n < TSYNC_HISTORY) {
+        t->hist_n++;
+    }
+    t->burst_n = 0;
+    tsync_fit(t);
+    return true;
+}
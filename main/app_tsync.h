@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Clock sync with the server: offset and drift from NTP style timestamp exchanges */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSYNC_BURST 8                    // exchanges per filtered point, the fastest one counts
+#define TSYNC_HISTORY 16                 // filtered points the drift is fitted over
+
+typedef struct {
+    int64_t dev_us;                      // device time halfway through the exchange
+    int64_t offset_us;                   // server minus device clock
+    uint32_t delay_us;                   // round trip minus the server's turnaround
+} tsync_point_t;
+
+/* server time = dev + offset_us + (dev - ref_us) * drift_ppb / 1e9 */
+typedef struct {
+    int64_t ref_us;
+    int64_t offset_us;
+    int32_t drift_ppb;
+    uint32_t err_us;                     // bound: half the fastest round trip plus the fit's rms residual
+} tsync_est_t;
+
+typedef struct {
+    tsync_point_t burst_best;            // fastest exchange of the burst so far
+    uint8_t burst_n;
+    tsync_point_t hist[TSYNC_HISTORY];   // ring of burst winners
+    uint8_t hist_n;
+    uint8_t hist_next;
+    bool valid;                          // est is set, from the first exchange on
+    tsync_est_t est;
+    /* counters */
+    uint32_t exchanges;
+    uint32_t rejected;                   // replies with impossible timestamps
+    uint32_t steps;                      // start overs on a server clock jump
+} tsync_t;
+
+void tsync_init(tsync_t *t);
+
+/* one exchange: t1 device sent, t2 server received, t3 server sent, t4 device received; device
+ * times in esp_timer us, server times in us of its clock. False if the timestamps are rejected */
+bool tsync_update(tsync_t *t, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/* device time dev_us on the server's clock */
+int64_t tsync_to_server(const tsync_est_t *est, int64_t dev_us);
+
+#ifdef __cplusplus
+}
+#endif
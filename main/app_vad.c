@@ -0,0 +1,98 @@
+/* Eric Liu 2026
+
+Voice activity detection for conversation mode, one detector per mic, run
+by i2s_read_task on every stereo chunk before the AGC (which would flatten
+the levels it compares).
+
+A chunk is voice when its mean |sample| is threshold dB over the mic's
+noise floor, over VAD_MIN_LEVEL, and lead dB over the other mic's level.
+The lead is what tells the talkers apart: the wearer's mic has to be louder
+than the forward one (the wearer's mouth is next to it), while the forward
+mic may be somewhat quieter than the wearer's and still count, since the
+subject reaches both mics at about the same level. With the cross-talk
+canceller on, the wearer's voice is mostly gone from the forward mic before
+this runs.
+
+The floor drops to a quieter chunk at once and rises towards a louder one
+under the threshold with a ~0.4 s time constant, so steady noise turns into
+floor quickly. Over the threshold (either talker: the other one's voice
+reaches this mic too) it only creeps up (~8 s to rise 12 dB), so someone who
+talks without pause is not tuned out. A decision holds for the
+hangover after the last voiced chunk, so the stream does not cut out
+between words.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: mean levels of both mics per chunk
+OUTPUTS: voice / no voice per mic
+
+*/
+
+#include "app_vad.h"
+
+#include <math.h>
+
+#define VAD_MIN_LEVEL 2653           // mean |sample| under -70 dBFS is never voice
+#define VAD_RISE_SHIFT 4             // floor towards a louder chunk that is not voice, 1/16 per chunk
+#define VAD_CREEP_SHIFT 8            // and during voice, 1/256 per chunk
+
+static uint32_t db_to_q8(int32_t db)
+{
+    return (uint32_t)lround(256.0 * pow(10.0, db / 20.0));
+}
+
+void vad_init(vad_t *v, uint32_t threshold_db, int32_t lead_db, uint16_t hang_chunks)
+{
+    v->ratio_q8 = db_to_q8((int32_t)threshold_db);
+    v->lead_q8 = db_to_q8(lead_db);
+    v->hang = hang_chunks;
+    vad_reset(v);
+}
+
+void vad_reset(vad_t *v)
+{
+    v->floor = 0;
+    v->left = 0;
+    v->voice = false;
+}
+
+uint32_t vad_level(const int32_t *slots, size_t n, size_t stride)
+{
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = slots[i * stride] >> 8;
+        sum += (uint32_t)(s < 0 ? -s : s);
+    }
+    return (uint32_t)(sum / n);
+}
+
+bool vad_update(vad_t *v, uint32_t level, uint32_t other)
+{
+    if (v->floor == 0) {
+        v->floor = level > 0 ? level : 1;
+    }
+    /* loud is anyone's voice, the other talker reaches this mic too; only quiet chunks are floor */
+    bool loud = level >= VAD_MIN_LEVEL && (uint64_t)level * 256 >= (uint64_t)v->floor * v->ratio_q8;
+    bool voiced = loud && (uint64_t)level * 256 >= (uint64_t)other * v->lead_q8;
+    if (level < v->floor) {
+        v->floor = level > 0 ? level : 1;
+    } else if (!loud) {
+        v->floor += (level - v->floor) >> VAD_RISE_SHIFT;
+    } else {
+        v->floor += (v->floor >> VAD_CREEP_SHIFT) + 1;
+    }
+
+    if (voiced) {
+        v->left = v->hang;
+        v->voice = true;
+    } else if (v->left > 0) {
+        v->left--;
+    } else {
+        v->voice = false;
+    }
+    return v->voice;
+}
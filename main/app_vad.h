@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Energy voice activity detector, one per mic, decided per capture chunk */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t floor;              // noise floor, mean |sample| of 24 bit audio; 0 until the first chunk
+    uint32_t ratio_q8;           // voice is this far over the floor, Q8
+    uint32_t lead_q8;            // and this far over the other mic's level, Q8
+    uint16_t hang;               // chunks a decision holds after the last voiced one
+    uint16_t left;               // of those still to go
+    bool voice;
+} vad_t;
+
+/* voice threshold_db over the noise floor and lead_db over the other mic (negative: at most that
+ * far under it), held for hang_chunks after the last voiced chunk */
+void vad_init(vad_t *v, uint32_t threshold_db, int32_t lead_db, uint16_t hang_chunks);
+
+/* forgets the noise floor, the next chunk starts it over */
+void vad_reset(vad_t *v);
+
+/* mean |sample| of n 24 bit left aligned slots, stride apart */
+uint32_t vad_level(const int32_t *slots, size_t n, size_t stride);
+
+/* one chunk at level, the other mic at other; true while voice */
+bool vad_update(vad_t *v, uint32_t level, uint32_t other);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,7 @@ Non-blocking Wi-Fi connect task with status event group + RSSI tracking.
 */
 
 #include "app_wifi.h"
+#include "app_display.h"
 
 #include "protocol_examples_common.h"
 #include "esp_err.h"
@@ -32,7 +33,10 @@ static void wifi_task(void *args)
         bool connected = (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK);
 
         if (connected) {
-            wifi_rssi = ap_info.rssi;
+            if (ap_info.rssi != wifi_rssi) {
+                wifi_rssi = ap_info.rssi;
+                display_notify_status();
+            }
             xEventGroupSetBits(wifi_event_group, WIFI_STATUS_CONNECTED);
             if (!was_connected) {
                 ESP_LOGD(TAG, "WiFi connected");
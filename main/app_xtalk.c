@@ -0,0 +1,126 @@
+/* Eric Liu 2026
+
+Cross-talk canceller for stereo capture. The forward mic (facing the subject)
+also hears the wearer; the wearer mic hears the wearer first and loudest, so
+it is the reference. An NLMS FIR filter estimates the wearer's path into the
+forward mic and its output is subtracted from the forward slot:
+
+    e[n] = d[n] - sum w[j] * x[n - j]
+    w[j] += mu * e[n] * x[n - j] / (|x|^2 + eps)
+
+Adaptation is decided per XTALK_BLOCK frames: only while the reference is
+XTALK_DT_RATIO louder than the forward mic (the wearer talks, the subject
+does not) and above XTALK_FLOOR. While the subject talks the filter keeps
+cancelling with the weights it has but does not learn the subject's voice.
+Over a budget (xtalk_pace) only one block in 2, 4 or 8 adapts; filtering
+always runs.
+
+Single precision float, the S3 FPU does a multiply-add per cycle. The
+reference history is kept linear (taps - 1 samples in front of the block) so
+every tap loop runs over contiguous arrays.
+
+No ESP-IDF dependencies, so this file also builds for the linux target and
+plain host compilers.
+
+INPUTS: stereo capture chunks
+OUTPUTS: the same chunks, forward slot cancelled in place
+
+*/
+
+#include "app_xtalk.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define XTALK_MU 0.25f
+#define XTALK_EPS 1e-6f               // regularizes |x|^2 of near-silent windows
+#define XTALK_DT_RATIO 4.0f           // reference 6 dB over the forward mic: wearer alone
+#define XTALK_FLOOR 1e-6f             // reference mean square under -60 dBFS: nothing to learn
+#define XTALK_ATTEN_BLOCKS 250        // adapting blocks per attenuation measurement, 1 s
+#define XTALK_SCALE (1.0f / 2147483648.0f)
+
+void xtalk_init(xtalk_t *x, uint16_t taps)
+{
+    memset(x, 0, sizeof(*x));
+    if (taps < 1) {
+        taps = 1;
+    }
+    x->taps = taps > XTALK_MAX_TAPS ? XTALK_MAX_TAPS : taps;
+    x->mu = XTALK_MU;
+}
+
+void xtalk_run(xtalk_t *x, int32_t *frames, size_t n, uint8_t fwd)
+{
+    const size_t taps = x->taps;
+    const size_t hist = taps - 1;
+    int32_t *near = frames + fwd;
+    const int32_t *far = frames + (fwd ^ 1);
+
+    while (n > 0) {
+        size_t len = n < XTALK_BLOCK ? n : XTALK_BLOCK;
+        float *ref = x->ref;
+
+        float ref_e = 0.0f;
+        float near_e = 0.0f;
+        for (size_t i = 0; i < len; i++) {
+            float r = (float)far[2 * i] * XTALK_SCALE;
+            float d = (float)near[2 * i] * XTALK_SCALE;
+            ref[hist + i] = r;
+            ref_e += r * r;
+            near_e += d * d;
+        }
+        bool adapt = (x->blocks++ & ((1u << x->adapt_shift) - 1)) == 0 && ref_e > XTALK_DT_RATIO * near_e
+                     && ref_e > XTALK_FLOOR * (float)len;
+
+        /* |x|^2 of the window, without its newest sample: added and dropped as the window slides */
+        float win = 0.0f;
+        for (size_t j = 0; j < hist; j++) {
+            win += ref[j] * ref[j];
+        }
+        float out_e = 0.0f;
+        for (size_t i = 0; i < len; i++) {
+            const float *r = ref + i;
+            win += r[hist] * r[hist];
+            float y = 0.0f;
+            for (size_t j = 0; j < taps; j++) {
+                y += x->w[j] * r[j];
+            }
+            float e = (float)near[2 * i] * XTALK_SCALE - y;
+            if (adapt) {
+                float g = x->mu * e / (win + XTALK_EPS);
+                for (size_t j = 0; j < taps; j++) {
+                    x->w[j] += g * r[j];
+                }
+            }
+            win -= r[0] * r[0];
+            out_e += e * e;
+            e = fminf(fmaxf(e, -1.0f), 1.0f - 1.0f / 8388608.0f);
+            near[2 * i] = (int32_t)(e * 8388608.0f) * 256;
+        }
+        memmove(ref, ref + len, hist * sizeof(float));
+
+        if (adapt) {
+            x->in_energy += near_e;
+            x->out_energy += out_e;
+            if (++x->atten_blocks == XTALK_ATTEN_BLOCKS) {
+                x->atten_db10 = (int16_t)lrintf(100.0f * log10f((x->in_energy + 1e-12f) / (x->out_energy + 1e-12f)));
+                x->in_energy = 0.0f;
+                x->out_energy = 0.0f;
+                x->atten_blocks = 0;
+            }
+        }
+        near += 2 * len;
+        far += 2 * len;
+        n -= len;
+    }
+}
+
+void xtalk_pace(xtalk_t *x, uint32_t used_us, uint32_t budget_us)
+{
+    if (used_us > budget_us && x->adapt_shift < XTALK_MAX_ADAPT_SHIFT) {
+        x->adapt_shift++;
+    } else if (used_us < budget_us / 2 && x->adapt_shift > 0) {
+        x->adapt_shift--;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Cross-talk canceller: NLMS filter that removes the wearer's voice from the forward mic,
+ * with the wearer mic as reference */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XTALK_MAX_TAPS 128
+#define XTALK_BLOCK 64             // frames per adaptation decision
+#define XTALK_MAX_ADAPT_SHIFT 3    // budget pacing adapts down to 1 block in 8
+
+typedef struct {
+    float w[XTALK_MAX_TAPS];       // w[j] weighs ref[i + j], ref[i + taps - 1] is the newest sample
+    float ref[XTALK_MAX_TAPS - 1 + XTALK_BLOCK];
+    uint16_t taps;
+    float mu;
+    uint8_t adapt_shift;           // adapt on 1 block in 2^adapt_shift
+    uint32_t blocks;
+    /* attenuation of the forward mic while only the wearer talks */
+    float in_energy;
+    float out_energy;
+    uint32_t atten_blocks;
+    int16_t atten_db10;            // last measurement, 0.1 dB
+} xtalk_t;
+
+void xtalk_init(xtalk_t *x, uint16_t taps);
+
+/* n stereo frames of 32 bit I2S slots, in place: the forward slot (fwd 0 left, 1 right) minus
+ * the estimate of the other slot's leak into it. The reference slot is left as it is */
+void xtalk_run(xtalk_t *x, int32_t *frames, size_t n, uint8_t fwd);
+
+/* budget pacing, once per chunk: adapts less often while used_us is over budget_us, more
+ * often again once it is well under */
+void xtalk_pace(xtalk_t *x, uint32_t used_us, uint32_t budget_us);
+
+#ifdef __cplusplus
+}
+#endif
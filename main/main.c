@@ -1,8 +1,11 @@
+#include "sdkconfig.h"
+#include "esp_log.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "nvs_flash.h"
 #include "esp_netif.h"
 #include "protocol_examples_common.h"
-#include "esp_log.h"
 #include "esp_event.h"
+#endif
 
 #include "app_display.h"
 #include "app_audio.h"
@@ -15,6 +18,7 @@ static const char *TAG = "app_main";
 void app_main(void)
 {
     esp_log_level_set("*", ESP_LOG_DEBUG);
+#if !CONFIG_IDF_TARGET_LINUX
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -25,10 +29,14 @@ void app_main(void)
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+#endif
 
     ESP_LOGD(TAG, "trying to init audio, display, gpio, TCP TX tasks");
 
+#if !CONFIG_IDF_TARGET_LINUX
     wifi_make_tasks();
+#endif
+    /* on the linux target audio, display and gpio come from app_host.c */
     audio_make_tasks();
     display_make_tasks();
     gpio_make_tasks();
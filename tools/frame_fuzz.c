@@ -0,0 +1,359 @@
+/* Eric Liu 2026
+
+Host fuzz and throughput test of the frame parser (main/app_frame.c), fed
+the way tcp_net_task does: receive into frame_parser_space(), commit, then
+take frames out with frame_parser_next() until it wants more bytes.
+
+Fuzz mode builds random streams of good frames (every type, payload sizes
+0 to the limit, payloads full of magic bytes) mixed with junk runs, headers
+with a bad magic or version and frames over max_payload, and splits them at
+random points, from single bytes to whole buffers. Every good frame has to
+come out exactly once, in order and unchanged, the oversize ones have to be
+counted and skipped, and every other byte has to be counted as dropped. The
+junk never contains the magic byte 0xAA past its first byte: resync drops up
+to the next magic, so an arbitrary 0xAA 0x01 in junk would be a header the
+parser is right to believe. Streams of random bytes follow, which only have
+to leave the parser consistent; build with -fsanitize=address,undefined to
+catch out of bounds access.
+
+Throughput mode parses a stream of caption sized TEXT frames (64 to 1024
+bytes) and PINGs from memory in receive chunks of the given size and prints
+MB/s and frames/s.
+
+    cc -O2 -I main tools/frame_fuzz.c main/app_frame.c -o frame_fuzz
+    ./frame_fuzz [streams] [seed]
+    ./frame_fuzz -t [MB] [chunk bytes]
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_frame.h"
+
+#define MAX_PAYLOAD 1024                 // TEXT_MSG_MAX, what tcp_net_task accepts
+#define BUF_CAP (FRAME_HDR_SIZE + MAX_PAYLOAD) // the smallest buffer the parser takes
+#define MAX_FRAMES 400
+#define STREAM_MAX (MAX_FRAMES * 3 * (FRAME_HDR_SIZE + 4 * MAX_PAYLOAD))
+
+typedef struct {
+    uint8_t msg_type;
+    uint8_t flags;
+    uint32_t len;
+    size_t offset;                       // payload in the stream
+} expect_t;
+
+static uint32_t rng = 1;
+
+static uint32_t rand32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/* mostly small, sometimes up to max */
+static uint32_t rand_len(uint32_t max)
+{
+    switch (rand32() % 4) {
+    case 0:
+        return rand32() % 16 < max ? rand32() % 16 : max;
+    case 1:
+        return rand32() % (max + 1);
+    case 2:
+        return max;
+    default:
+        return rand32() % 128 < max ? rand32() % 128 : max;
+    }
+}
+
+static uint8_t no_magic(void)
+{
+    uint8_t b = (uint8_t)rand32();
+    return b == MSG_MAGIC ? (uint8_t)(b + 1) : b;
+}
+
+static uint8_t *stream;
+static expect_t expect[MAX_FRAMES];
+
+/* a random stream; returns its length, frame and drop counts through the pointers */
+static size_t build_stream(int *n_expect, uint32_t *n_oversize, uint64_t *n_dropped)
+{
+    size_t pos = 0;
+    *n_expect = 0;
+    *n_oversize = 0;
+    *n_dropped = 0;
+    int items = 1 + (int)(rand32() % MAX_FRAMES);
+    for (int i = 0; i < items; i++) {
+        /* the last one is a good frame: the parser needs a header's worth of bytes to
+         * tell junk from a frame, so junk at the very end would wait for more */
+        uint32_t kind = i == items - 1 ? 0 : rand32() % 10;
+        if (kind < 6) {
+            expect_t *e = &expect[(*n_expect)++];
+            e->msg_type = (uint8_t)rand32();
+            e->flags = (uint8_t)rand32();
+            e->len = rand_len(MAX_PAYLOAD);
+            pos += frame_put_hdr(stream + pos, e->msg_type, e->flags, e->len);
+            e->offset = pos;
+            for (uint32_t k = 0; k < e->len; k++) {
+                /* a third of them magic bytes: a payload must never be taken for a header */
+                stream[pos++] = rand32() % 3 ? (uint8_t)rand32() : MSG_MAGIC;
+            }
+        } else if (kind < 8) {
+            /* junk run, a header with a bad magic or one with a bad version */
+            size_t start = pos;
+            uint32_t what = rand32() % 3;
+            if (what == 0) {
+                uint32_t n = 1 + rand32() % 40;
+                for (uint32_t k = 0; k < n; k++) {
+                    stream[pos++] = no_magic();
+                }
+            } else {
+                stream[pos++] = what == 1 ? no_magic() : MSG_MAGIC;
+                uint8_t version = no_magic();
+                stream[pos++] = (what == 2 && version == MSG_VERSION) ? MSG_VERSION + 1 : version;
+                for (size_t k = 2; k < FRAME_HDR_SIZE; k++) {
+                    stream[pos++] = no_magic();
+                }
+            }
+            *n_dropped += pos - start;
+        } else {
+            /* over max_payload: header and payload skipped, the payload may look like frames */
+            uint32_t len = MAX_PAYLOAD + 1 + rand32() % (3 * MAX_PAYLOAD);
+            pos += frame_put_hdr(stream + pos, (uint8_t)rand32(), (uint8_t)rand32(), len);
+            for (uint32_t k = 0; k < len; k++) {
+                stream[pos++] = rand32() % 3 ? (uint8_t)rand32() : MSG_MAGIC;
+            }
+            (*n_oversize)++;
+            *n_dropped += FRAME_HDR_SIZE + len;
+        }
+    }
+    return pos;
+}
+
+/* receive sizes like a socket gives them: single bytes to everything that fits */
+static size_t rand_chunk(size_t avail)
+{
+    size_t n;
+    switch (rand32() % 4) {
+    case 0:
+        n = 1;
+        break;
+    case 1:
+        n = 1 + rand32() % (FRAME_HDR_SIZE + 1);
+        break;
+    case 2:
+        n = avail;
+        break;
+    default:
+        n = 1 + rand32() % avail;
+        break;
+    }
+    return n < avail ? n : avail;
+}
+
+static int fuzz_stream(frame_parser_t *p, size_t len, int n_expect, uint32_t n_oversize, uint64_t n_dropped)
+{
+    frame_stats_t before = p->stats;
+    size_t fed = 0;
+    int got = 0;
+    while (fed < len) {
+        size_t avail = 0;
+        uint8_t *dst = frame_parser_space(p, &avail);
+        if (avail == 0) {
+            printf("no receive space after draining, %zu of %zu bytes fed\n", fed, len);
+            return 1;
+        }
+        size_t n = rand_chunk(avail);
+        if (n > len - fed) {
+            n = len - fed;
+        }
+        memcpy(dst, stream + fed, n);
+        frame_parser_commit(p, n);
+        fed += n;
+        frame_t f;
+        while (frame_parser_next(p, &f)) {
+            if (got >= n_expect) {
+                printf("extra frame: type %u len %lu after the %d expected\n", f.msg_type, (unsigned long)f.len,
+                       n_expect);
+                return 1;
+            }
+            const expect_t *e = &expect[got];
+            if (f.msg_type != e->msg_type || f.flags != e->flags || f.len != e->len ||
+                memcmp(f.payload, stream + e->offset, e->len)) {
+                printf("frame %d of %d: type %u flags %02x len %lu, want type %u flags %02x len %lu%s\n", got,
+                       n_expect, f.msg_type, f.flags, (unsigned long)f.len, e->msg_type, e->flags,
+                       (unsigned long)e->len, f.len == e->len ? " (payload differs)" : "");
+                return 1;
+            }
+            got++;
+        }
+    }
+    if (got != n_expect) {
+        printf("%d of %d frames came out\n", got, n_expect);
+        return 1;
+    }
+    uint32_t frames = p->stats.frames - before.frames;
+    uint32_t oversize = p->stats.oversize - before.oversize;
+    uint64_t dropped = p->stats.dropped_bytes - before.dropped_bytes;
+    if (frames != (uint32_t)n_expect || oversize != n_oversize || dropped != n_dropped) {
+        printf("stats: %lu frames, %lu oversize, %llu dropped; want %d, %lu, %llu\n", (unsigned long)frames,
+               (unsigned long)oversize, (unsigned long long)dropped, n_expect, (unsigned long)n_oversize,
+               (unsigned long long)n_dropped);
+        return 1;
+    }
+    return 0;
+}
+
+/* random bytes: no expectations beyond the parser's own invariants */
+static int fuzz_random(frame_parser_t *p)
+{
+    size_t len = rand32() % 20000;
+    for (size_t i = 0; i < len; i++) {
+        stream[i] = rand32() % 4 ? (uint8_t)rand32() : rand32() % 2 ? MSG_MAGIC : MSG_VERSION;
+    }
+    size_t fed = 0;
+    while (fed < len) {
+        size_t avail = 0;
+        uint8_t *dst = frame_parser_space(p, &avail);
+        if (avail == 0) {
+            printf("random bytes: no receive space after draining\n");
+            return 1;
+        }
+        size_t n = rand_chunk(avail);
+        if (n > len - fed) {
+            n = len - fed;
+        }
+        memcpy(dst, stream + fed, n);
+        frame_parser_commit(p, n);
+        fed += n;
+        frame_t f;
+        while (frame_parser_next(p, &f)) {
+            if (f.len > MAX_PAYLOAD || f.payload < p->buf || f.payload + f.len > p->buf + p->len) {
+                printf("random bytes: frame of %lu bytes outside the buffer\n", (unsigned long)f.len);
+                return 1;
+            }
+        }
+        if (p->head > p->len || p->len > p->cap) {
+            printf("random bytes: head %zu len %zu cap %zu\n", p->head, p->len, p->cap);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int fuzz(int streams, uint32_t seed)
+{
+    static uint8_t buf[BUF_CAP];
+    frame_parser_t p;
+    frame_parser_init(&p, buf, sizeof(buf), MAX_PAYLOAD);
+    rng = seed ? seed : 1;
+    uint64_t bytes = 0, frames = 0;
+    for (int s = 0; s < streams; s++) {
+        int n_expect;
+        uint32_t n_oversize;
+        uint64_t n_dropped;
+        size_t len = build_stream(&n_expect, &n_oversize, &n_dropped);
+        if (fuzz_stream(&p, len, n_expect, n_oversize, n_dropped)) {
+            printf("stream %d (seed %lu) failed\n", s, (unsigned long)seed);
+            return 1;
+        }
+        bytes += len;
+        frames += (uint64_t)n_expect;
+        /* every stream ends on a frame boundary, start the next one clean like a reconnect would */
+        frame_parser_reset(&p);
+        if (s % 16 == 15 && fuzz_random(&p)) {
+            printf("random stream after %d (seed %lu) failed\n", s, (unsigned long)seed);
+            return 1;
+        }
+        frame_parser_reset(&p);
+    }
+    printf("%d streams, %llu frames in %.1f MB: every frame once, in order; %lu resyncs, %lu oversize skipped\n",
+           streams, (unsigned long long)frames, bytes / 1e6, (unsigned long)p.stats.resyncs,
+           (unsigned long)p.stats.oversize);
+    return 0;
+}
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int throughput(size_t mb, size_t chunk)
+{
+    /* one stream of a few MB parsed repeatedly, so generation stays out of the timing */
+    size_t len = 0;
+    size_t frames_per_pass = 0;
+    while (len < 4000000) {
+        if (rand32() % 8 == 0) {
+            uint8_t ping[CTRL_PING_LEN] = { CTRL_OP_PING };
+            len += frame_put_hdr(stream + len, MSG_TYPE_CONTROL, 0, sizeof(ping));
+            memcpy(stream + len, ping, sizeof(ping));
+            len += sizeof(ping);
+        } else {
+            uint32_t n = 64 + rand32() % (MAX_PAYLOAD - 64 + 1);
+            len += frame_put_hdr(stream + len, MSG_TYPE_TEXT, MSG_FLAG_SCREEN1, n);
+            memset(stream + len, 'a' + (int)(n % 26), n);
+            len += n;
+        }
+        frames_per_pass++;
+    }
+    static uint8_t buf[2048];            // RX_BUF_SIZE of tcp_net_task
+    frame_parser_t p;
+    frame_parser_init(&p, buf, sizeof(buf), MAX_PAYLOAD);
+    size_t passes = (mb * 1000000 + len - 1) / len;
+    uint64_t sum = 0;
+    double t0 = seconds();
+    for (size_t pass = 0; pass < passes; pass++) {
+        size_t fed = 0;
+        while (fed < len) {
+            size_t avail = 0;
+            uint8_t *dst = frame_parser_space(&p, &avail);
+            size_t n = avail < chunk ? avail : chunk;
+            if (n > len - fed) {
+                n = len - fed;
+            }
+            memcpy(dst, stream + fed, n);
+            frame_parser_commit(&p, n);
+            fed += n;
+            frame_t f;
+            while (frame_parser_next(&p, &f)) {
+                sum += f.len + f.payload[0];
+            }
+        }
+    }
+    double dt = seconds() - t0;
+    if (p.stats.frames != passes * frames_per_pass) {
+        printf("throughput: %lu frames, want %zu\n", (unsigned long)p.stats.frames, passes * frames_per_pass);
+        return 1;
+    }
+    printf("%zu byte chunks: %.1f MB in %.3f s, %.0f MB/s, %.2f M frames/s (checksum %llu)\n", chunk,
+           passes * len / 1e6, dt, passes * len / 1e6 / dt, p.stats.frames / 1e6 / dt, (unsigned long long)sum);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    stream = malloc(STREAM_MAX);
+    if (!stream) {
+        return 1;
+    }
+    int ret;
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        size_t mb = argc > 2 ? (size_t)atoi(argv[2]) : 500;
+        size_t chunk = argc > 3 ? (size_t)atoi(argv[3]) : 1460;
+        ret = throughput(mb ? mb : 1, chunk ? chunk : 1);
+    } else {
+        int streams = argc > 1 ? atoi(argv[1]) : 2000;
+        uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : (uint32_t)time(NULL);
+        ret = fuzz(streams, seed);
+    }
+    free(stream);
+    return ret;
+}
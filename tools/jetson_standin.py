@@ -0,0 +1,578 @@
+#!/usr/bin/env python3
+# Eric Liu 2026
+#
+# Local stand-in for the Jetson server, for bench testing the headset link
+# (firmware or the linux target build) without the speech pipeline.
+#
+# Speaks the same framing as main/app_frame.h: counts audio per language,
+# answers CONTROL PINGs with PONGs, sends a caption every few seconds and
+# can simulate a server restart to measure how fast the headset recovers.
+#
+# Numbered audio (CONFIG_APP_NET_RESUME) is ACKed every few frames and
+# RESUME is answered with an ACK of the last frame held for that session.
+# Sessions are kept across simulated restarts, like a server that only lost
+# the connection; duplicates and gaps are counted per session.
+#
+# UDP audio (CONFIG_APP_NET_AUDIO_UDP) arrives on the same port number. It goes
+# through a jitter buffer that plays frame n --jitter-ms after its capture
+# time plus the smallest transit seen; missing frames are rebuilt from XOR
+# parity where possible, otherwise skipped once a later frame is due. Loss,
+# recovery, late and reordered frames are reported; a frame rebuilt before its
+# own datagram turned up late counts apart from the lost ones rebuilt.
+#
+# Numbered audio on either transport also reports how much later than the
+# fastest frame each one arrived (p50/p99/max), which is the latency a
+# jitter buffer has to absorb. Compare both modes on a lossy loopback:
+#
+#   sudo tc qdisc add dev lo root netem delay 5ms 5ms loss 2%
+#   sudo tc qdisc del dev lo root
+#
+# or drop received datagrams here with --udp-drop (UDP only).
+#
+# --credit-window grants CREDIT so that at most that many TCP audio bytes are
+# waiting, and --process-speed sets how fast (x real time) they are consumed;
+# below 1.0 the stand-in falls behind like an overloaded Jetson.
+#
+# Audio payload formats (bits 6-7 of the AUDIO flags) at their sample rate
+# (bits 2-3) are counted in milliseconds of audio each and every switch is
+# printed; credit is consumed at the current format's byte rate.
+#
+# Log-mel frames (MSG_TYPE_MEL, CONFIG_APP_AUDIO_MEL) count as 10 ms each on
+# either transport, in place of audio; the report gives the loudest mel bin of
+# the last frame and its level (log10 of the mel power).
+#
+# Conversation mode (CONFIG_APP_AUDIO_CONVERSATION) sends each language while
+# its mic has voice; RAW frames of both at once are counted as "both".
+# --lang-captions tags captions LANG1/LANG2 instead of a screen, the headset
+# shows LANG1 captions to the wearer and LANG2 ones to the subject.
+#
+# Clock sync (CONFIG_APP_NET_CLOCK_SYNC): TIME is answered with TIME_REPLY on a
+# simulated server clock, CLOCK_MONOTONIC shifted by --clock-offset seconds and
+# running --clock-drift-ppm fast. Each CLOCK estimate the headset sends back
+# is reported, and numbered audio is put on the server clock with it to give
+# the capture to arrival latency. With --same-host the headset is the linux
+# target build on this machine, whose esp_timer is CLOCK_MONOTONIC as well, so
+# the estimate is checked against the truth:
+#
+#   python3 tools/jetson_standin.py --clock-offset 1234.5 --clock-drift-ppm 40 --same-host
+#
+# Restart modes:
+#   close  server process exits cleanly: connection closed, port refused
+#          while down
+#   hang   power cut / kernel hang: listener gone, the open connection just
+#          goes silent (no FIN, no PONGs) until the server is back
+#
+# Recovery time is printed as the delay between the listener coming back and
+# the headset's next connection.
+#
+#   python3 tools/jetson_standin.py --port 3333 --restart-every 20 --down 3 --mode hang
+
+import argparse
+import math
+import random
+import select
+import socket
+import struct
+import time
+
+MAGIC = 0xAA
+VERSION = 1
+HDR = struct.Struct('>BBBBI')
+TYPE_AUDIO, TYPE_TEXT, TYPE_CONTROL, TYPE_MEL = 1, 2, 3, 4
+FLAG_LANG1, FLAG_LANG2 = 0x01, 0x02
+FLAG_SCREEN1, FLAG_SCREEN2, FLAG_SEQ = 0x04, 0x08, 0x10
+CTRL_PING, CTRL_PONG, CTRL_ACK, CTRL_RESUME, CTRL_CREDIT = 1, 2, 3, 4, 5
+CTRL_TIME, CTRL_TIME_REPLY, CTRL_CLOCK = 6, 7, 8
+FMT_NAMES = ('raw', 's16', 's16', 'adpcm')
+FMT_BYTES_PER_SAMPLE = (8, 2, 2, 0.5)
+RATE_HZ = (16000, 8000, 12000, 16000)   # AUDIO_RATE_*, 3 is reserved
+FLAG_FEC = 0x20
+SUB_HDR = struct.Struct('>II')
+FEC_HDR = struct.Struct('>IBBH')
+ACK_EVERY = 8
+MEL_BINS = 80
+MEL_Q = 10
+FMT_MEL = ('mel', 100)          # frames per second, MEL_BINS s16 each
+
+
+def fmt_name(fmt):
+    if fmt == FMT_MEL:
+        return 'mel'
+    return f'{FMT_NAMES[fmt[0]]}/{fmt[1] // 1000}k'
+
+
+def fmt_bytes_per_s(fmt):
+    if fmt == FMT_MEL:
+        return fmt[1] * MEL_BINS * 2
+    return fmt[1] * FMT_BYTES_PER_SAMPLE[fmt[0]]
+
+
+def mel_hz(b):
+    """centre of mel filter b: Slaney scale, 80 filters from 0 to 8 kHz"""
+    step = (15 + math.log(8) * 27 / math.log(6.4)) / (MEL_BINS + 1)
+    mel = step * (b + 1)
+    return mel * 200 / 3 if mel < 15 else 1000 * math.exp((mel - 15) * math.log(6.4) / 27)
+
+
+class Formats:
+    """audio per payload format and rate; prints when the headset switches"""
+    def __init__(self):
+        self.ms = {}
+        self.fmt = None           # (format, rate) of the last frame
+        self.switches = 0
+        self.mel_peak = None      # loudest bin of the last mel frame
+        self.mel_level = 0.0
+
+    def add(self, msg_type, flags, payload):
+        nbytes = len(payload)
+        if msg_type == TYPE_MEL:
+            fmt = FMT_MEL
+            if nbytes >= MEL_BINS * 2:
+                last = struct.unpack_from(f'<{MEL_BINS}h', payload, nbytes - MEL_BINS * 2)
+                self.mel_peak = max(range(MEL_BINS), key=lambda b: last[b])
+                self.mel_level = last[self.mel_peak] / (1 << MEL_Q)
+        else:
+            fmt = (flags >> 6, RATE_HZ[(flags >> 2) & 3])
+        if self.fmt is not None and fmt != self.fmt:
+            self.switches += 1
+            print(f'  format {fmt_name(self.fmt)} -> {fmt_name(fmt)}', flush=True)
+        self.fmt = fmt
+        self.ms[fmt] = self.ms.get(fmt, 0.0) + nbytes * 1000 / fmt_bytes_per_s(fmt)
+
+    def bytes_per_s(self):
+        return fmt_bytes_per_s(self.fmt or (0, 16000))
+
+    def report(self):
+        ms = ', '.join(f'{fmt_name(f)} {m / 1000:.1f} s' for f, m in self.ms.items())
+        line = f'formats: {ms}, {self.switches} switches'
+        if self.mel_peak is not None:
+            line += f'; mel peak bin {self.mel_peak} ({mel_hz(self.mel_peak):.0f} Hz) at {self.mel_level:.2f}'
+        return line
+
+
+class Session:
+    def __init__(self, last):
+        self.last = last          # every frame up to here received
+        self.frames = 0
+        self.dups = 0
+        self.gaps = 0
+
+
+sessions = {}
+
+
+class TsClock:
+    """unwraps the 32 bit microsecond capture timestamps into seconds"""
+    def __init__(self):
+        self.last = None
+        self.now = 0.0
+
+    def media(self, ts):
+        if self.last is not None:
+            self.now += (((ts - self.last + 0x80000000) & 0xFFFFFFFF) - 0x80000000) / 1e6
+        self.last = ts
+        return self.now
+
+
+class ServerClock:
+    """the simulated server clock in us and the headset's latest CLOCK estimate of it"""
+    def __init__(self, offset_s, drift_ppm):
+        self.offset_us = offset_s * 1e6
+        self.rate = 1 + drift_ppm / 1e6
+        self.est = None             # offset, ref, drift ppb
+        self.clocks = 0
+        self.latency = []           # capture to arrival, ms
+
+    def now_us(self):
+        return int(time.monotonic_ns() / 1000 * self.rate + self.offset_us)
+
+    def truth(self, dev_us):
+        """server time of a device time, if the headset runs on this host's CLOCK_MONOTONIC"""
+        return dev_us * self.rate + self.offset_us
+
+    def to_server(self, dev_us):
+        offset, ref, drift = self.est
+        return dev_us + offset + (dev_us - ref) * drift / 1e9
+
+    def capture(self, ts, now_us):
+        """capture to arrival latency of a frame with 32 bit capture time ts, arriving now_us"""
+        if self.est is None:
+            return
+        offset, ref, drift = self.est
+        dev_now = ref + (now_us - offset - ref) / (1 + drift / 1e9)
+        back = ((int(dev_now) - ts + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        self.latency.append((now_us - self.to_server(dev_now - back)) / 1000)
+
+    def report(self, same_host):
+        if self.est is None:
+            return None
+        offset, ref, drift = self.est
+        line = f'clock: {self.clocks} CLOCKs, headset offset {offset / 1e6:.6f} s, drift {drift / 1000:.2f} ppm'
+        if same_host:
+            dev = time.monotonic_ns() / 1000
+            line += (f', off the truth by {self.to_server(dev) - self.truth(dev):.0f} us and '
+                     f'{drift / 1000 - (self.rate - 1) * 1e6:.2f} ppm')
+        if self.latency:
+            d = sorted(self.latency)
+            self.latency = []
+            line += f'; capture to arrival p50 {d[len(d) // 2]:.1f} max {d[-1]:.1f} ms'
+        return line
+
+
+class DelayStats:
+    """how much later than the fastest frame each frame arrived, relative to its capture time"""
+    def __init__(self):
+        self.best = None
+        self.window = []
+
+    def add(self, arrival, media):
+        transit = arrival - media
+        if self.best is None or transit < self.best:
+            self.best = transit
+        self.window.append(transit)
+
+    def report(self):
+        if not self.window:
+            return None
+        d = sorted((t - self.best) * 1000 for t in self.window)
+        self.window = []
+        return (f'delay over fastest p50 {d[len(d) // 2]:.1f} p99 {d[min(len(d) - 1, len(d) * 99 // 100)]:.1f} '
+                f'max {d[-1]:.1f} ms ({len(d)} frames)')
+
+
+class JitterBuffer:
+    """UDP audio back in seq order. Frame n plays delay after its capture time plus the
+    smallest transit seen; if it is missing when a later frame is due it is lost"""
+    def __init__(self, delay_ms, clock):
+        self.delay = delay_ms / 1000
+        self.clock = clock
+        self.offset = None           # smallest arrival - capture time
+        self.frames = {}             # seq -> (msg_type, flags, payload with sub-header, media time)
+        self.parity = {}             # first seq -> (count, flags_xor, len_xor, data)
+        self.lost = set()
+        self.rebuilt = set()         # seqs rebuilt from parity, their own datagram may still turn up
+        self.next = None
+        self.seq_max = None
+        self.st = dict(received=0, played=0, recovered=0, early=0, lost=0, late=0, dups=0, reordered=0)
+
+    def add(self, seq, msg_type, flags, payload, now):
+        if seq in self.rebuilt:
+            # only reordered or delayed, parity rebuilt it before it came
+            self.rebuilt.discard(seq)
+            self.st['early'] += 1
+            return None
+        if self.next is not None and seq < self.next:
+            self.st['late' if seq in self.lost else 'dups'] += 1
+            return None
+        if seq in self.frames:
+            self.st['dups'] += 1
+            return None
+        if self.seq_max is not None and seq < self.seq_max:
+            self.st['reordered'] += 1
+        self.seq_max = seq if self.seq_max is None else max(seq, self.seq_max)
+        self.st['received'] += 1
+        media = self.store(seq, msg_type, flags, payload)
+        if self.offset is None or now - media < self.offset:
+            self.offset = now - media
+        if self.next is None:
+            self.next = seq
+        for first in list(self.parity):
+            self.recover(first)
+        return media
+
+    def add_parity(self, payload):
+        first, count, flags_xor, len_xor = FEC_HDR.unpack_from(payload)
+        if self.next is None or first + count <= self.next:
+            return
+        self.parity[first] = (count, flags_xor, len_xor, payload[FEC_HDR.size:])
+        self.recover(first)
+
+    def store(self, seq, msg_type, flags, payload):
+        media = self.clock.media(SUB_HDR.unpack_from(payload)[1])
+        self.frames[seq] = (msg_type, flags, payload, media)
+        return media
+
+    def recover(self, first):
+        count, flags_xor, len_xor, data = self.parity[first]
+        missing = [s for s in range(first, first + count) if s not in self.frames]
+        if len(missing) == 1 and missing[0] >= self.next:
+            data = bytearray(data)
+            msg_type = TYPE_AUDIO
+            for s in range(first, first + count):
+                if s == missing[0]:
+                    continue
+                msg_type, flags, payload, _ = self.frames[s]
+                for i, b in enumerate(payload):
+                    data[i] ^= b
+                flags_xor ^= flags
+                len_xor ^= len(payload)
+            # parity carries no type: the rest of the group's
+            self.store(missing[0], msg_type, flags_xor, bytes(data[:len_xor]))
+            self.rebuilt.add(missing[0])
+            self.st['recovered'] += 1
+        elif missing and missing[-1] >= self.next:
+            return              # more than one missing so far, parity may still help
+        del self.parity[first]
+
+    def tick(self, now):
+        """frames due by now, in order, as (msg_type, flags, audio)"""
+        out = []
+        while self.next is not None:
+            frame = self.frames.get(self.next)
+            if frame is not None:
+                if now < frame[3] + self.offset + self.delay:
+                    break
+                out.append((frame[0], frame[1], frame[2][SUB_HDR.size:]))
+                self.st['played'] += 1
+            else:
+                later = [s for s in self.frames if s > self.next]
+                if not later or now < self.frames[min(later)][3] + self.offset + self.delay:
+                    break
+                self.lost.add(self.next)
+                self.st['lost'] += 1
+            self.next += 1
+        for s in [s for s in self.frames if s < self.next - 64]:
+            del self.frames[s]
+        self.lost = {s for s in self.lost if s >= self.next - 1024}
+        self.rebuilt = {s for s in self.rebuilt if s >= self.next - 1024}
+        return out
+
+    def report(self):
+        st = self.st
+        total = st['played'] + st['lost']
+        pct = 100 * st['lost'] / total if total else 0
+        # a rebuilt frame whose datagram came later anyway was not lost, only early
+        return (f'udp: {st["received"]} received, {st["recovered"] - st["early"]} lost ones rebuilt from parity '
+                f'({st["early"]} more rebuilt before their late datagram), {st["lost"]} lost ({pct:.2f}%), '
+                f'{st["late"]} too late, {st["reordered"]} reordered, {st["dups"]} dups')
+
+
+def frame(msg_type, flags, payload):
+    return HDR.pack(MAGIC, VERSION, msg_type, flags, len(payload)) + payload
+
+
+def listen(port):
+    lsock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    lsock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    lsock.bind(('0.0.0.0', port))
+    lsock.listen(1)
+    return lsock
+
+
+def listen_udp(port):
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    udp.bind(('0.0.0.0', port))
+    udp.setblocking(False)
+    return udp
+
+
+def ctrl(op, *args):
+    return frame(TYPE_CONTROL, 0, bytes([op]) + b''.join(struct.pack('>I', a & 0xFFFFFFFF) for a in args))
+
+
+def udp_datagram(data, jb, delays, now, args, sclock):
+    if args.udp_drop and random.random() < args.udp_drop:
+        return
+    if len(data) < HDR.size:
+        return
+    magic, version, msg_type, flags, length = HDR.unpack_from(data)
+    payload = data[HDR.size:]
+    if magic != MAGIC or version != VERSION or msg_type not in (TYPE_AUDIO, TYPE_MEL) or length != len(payload):
+        print('  bad datagram', flush=True)
+        return
+    if flags & FLAG_FEC:
+        jb.add_parity(payload)
+    elif flags & FLAG_SEQ:
+        seq, ts = SUB_HDR.unpack_from(payload)
+        sclock.capture(ts, sclock.now_us())
+        media = jb.add(seq, msg_type, flags, payload, now)
+        if media is not None:
+            delays.add(now, media)
+
+
+def session(conn, udp, args, restart_at, sclock):
+    """runs one connection; returns 'eof' or 'restart'"""
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    clock = TsClock()
+    delays = DelayStats()
+    jb = JitterBuffer(args.jitter_ms, clock)
+    sess = None
+    unacked = 0
+    tcp_audio = 0                   # TCP AUDIO payload bytes on this connection
+    consumed = 0.0
+    granted = None
+    last = time.monotonic()
+    buf = b''
+    audio = {1: 0, 2: 0, 3: 0}
+    formats = Formats()
+    pings = 0
+    captions = 0
+    next_caption = time.monotonic() + args.caption_every
+    next_report = time.monotonic() + 5
+    while True:
+        now = time.monotonic()
+        if restart_at is not None and now >= restart_at:
+            return 'restart'
+        if args.credit_window:
+            consumed = min(tcp_audio, consumed + (now - last) * formats.bytes_per_s() * args.process_speed)
+            limit = int(consumed) + args.credit_window
+            if granted is None or limit - granted >= args.credit_window // 8:
+                conn.sendall(ctrl(CTRL_CREDIT, limit))
+                granted = limit
+        last = now
+        if now >= next_caption:
+            next_caption = now + args.caption_every
+            if args.lang_captions:
+                flags = FLAG_LANG1 if captions % 2 == 0 else FLAG_LANG2
+            else:
+                flags = FLAG_SCREEN1 if captions % 2 == 0 else FLAG_SCREEN2
+            conn.sendall(frame(TYPE_TEXT, flags, f'stand-in caption {captions}'.encode()))
+            captions += 1
+        if now >= next_report:
+            next_report = now + 5
+            both = f', both {audio[3]} B' if audio[3] else ''
+            print(f'  audio lang1 {audio[1]} B, lang2 {audio[2]} B{both}, pings {pings}', flush=True)
+            if sess:
+                print(f'  session: {sess.frames} frames, last {sess.last}, {sess.dups} dups, {sess.gaps} gaps', flush=True)
+            if jb.next is not None:
+                print(f'  {jb.report()}', flush=True)
+            if formats.fmt is not None:
+                print(f'  {formats.report()}', flush=True)
+            line = delays.report()
+            if line:
+                print(f'  {line}', flush=True)
+            line = sclock.report(args.same_host)
+            if line:
+                print(f'  {line}', flush=True)
+            if args.credit_window:
+                backlog = tcp_audio - int(consumed)
+                print(f'  credit: {backlog} B ({backlog * 1000 // formats.bytes_per_s()} ms) waiting', flush=True)
+        for msg_type, flags, data in jb.tick(now):
+            audio[flags & 3] = audio.get(flags & 3, 0) + len(data)
+            formats.add(msg_type, flags, data)
+        readable, _, _ = select.select([conn, udp], [], [], 0.005)
+        if udp in readable:
+            while True:
+                try:
+                    udp_datagram(udp.recv(2048), jb, delays, time.monotonic(), args, sclock)
+                except BlockingIOError:
+                    break
+        if conn not in readable:
+            continue
+        try:
+            data = conn.recv(65536)
+        except ConnectionError:
+            return 'eof'
+        if not data:
+            return 'eof'
+        rx_us = sclock.now_us()
+        buf += data
+        while len(buf) >= HDR.size:
+            magic, version, msg_type, flags, length = HDR.unpack_from(buf)
+            if magic != MAGIC or version != VERSION:
+                print('  bad header, dropping a byte', flush=True)
+                buf = buf[1:]
+                continue
+            if len(buf) < HDR.size + length:
+                break
+            payload = buf[HDR.size:HDR.size + length]
+            buf = buf[HDR.size + length:]
+            if msg_type in (TYPE_AUDIO, TYPE_MEL):
+                tcp_audio += length
+                if flags & FLAG_SEQ and sess:
+                    seq, ts = SUB_HDR.unpack_from(payload)
+                    payload = payload[SUB_HDR.size:]
+                    delta = (seq - sess.last) & 0xFFFFFFFF
+                    if delta == 0 or delta >= 0x80000000:
+                        sess.dups += 1
+                        continue
+                    if delta > 1:
+                        print(f'  gap: frames {sess.last + 1}..{seq - 1} missing', flush=True)
+                        sess.gaps += 1
+                    sess.last = seq
+                    sess.frames += 1
+                    delays.add(time.monotonic(), clock.media(ts))
+                    sclock.capture(ts, rx_us)
+                    unacked += 1
+                    if unacked >= ACK_EVERY:
+                        unacked = 0
+                        conn.sendall(ctrl(CTRL_ACK, sess.last))
+                audio[flags & 3] = audio.get(flags & 3, 0) + len(payload)
+                formats.add(msg_type, flags, payload)
+            elif msg_type == TYPE_CONTROL and length >= 5 and payload[0] == CTRL_PING:
+                pings += 1
+                conn.sendall(frame(TYPE_CONTROL, 0, bytes([CTRL_PONG]) + payload[1:5]))
+            elif msg_type == TYPE_CONTROL and length >= 9 and payload[0] == CTRL_TIME:
+                # t2 when the bytes came in, t3 right before the reply goes out
+                reply = bytes([CTRL_TIME_REPLY]) + payload[1:9] + struct.pack('>qq', rx_us, sclock.now_us())
+                conn.sendall(frame(TYPE_CONTROL, 0, reply))
+            elif msg_type == TYPE_CONTROL and length >= 21 and payload[0] == CTRL_CLOCK:
+                sclock.est = struct.unpack_from('>qQi', payload, 1)
+                sclock.clocks += 1
+            elif msg_type == TYPE_CONTROL and length >= 13 and payload[0] == CTRL_RESUME:
+                sid, acked, nxt = struct.unpack_from('>III', payload, 1)
+                sess = sessions.setdefault(sid, Session(acked))
+                print(f'  RESUME session {sid:08x}: headset acked {acked}, next {nxt}, '
+                      f'we have up to {sess.last}', flush=True)
+                conn.sendall(ctrl(CTRL_ACK, sess.last))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument('--port', type=int, default=3333)
+    ap.add_argument('--caption-every', type=float, default=3.0, help='seconds between captions')
+    ap.add_argument('--restart-every', type=float, default=0, help='simulate a restart after this many seconds connected, 0 = never')
+    ap.add_argument('--down', type=float, default=3.0, help='seconds the simulated restart keeps the server away')
+    ap.add_argument('--mode', choices=('close', 'hang'), default='close')
+    ap.add_argument('--jitter-ms', type=float, default=60, help='UDP audio playout delay over the fastest frame')
+    ap.add_argument('--udp-drop', type=float, default=0, help='fraction of received UDP datagrams to drop')
+    ap.add_argument('--lang-captions', action='store_true', help='tag captions LANG1/LANG2 instead of a screen')
+    ap.add_argument('--credit-window', type=int, default=0, help='TCP audio bytes allowed to wait, 0 = send no CREDIT')
+    ap.add_argument('--process-speed', type=float, default=1.0, help='audio consumed per second of real time, with credit')
+    ap.add_argument('--clock-offset', type=float, default=0, help='server clock minus CLOCK_MONOTONIC, seconds')
+    ap.add_argument('--clock-drift-ppm', type=float, default=0, help='how fast the server clock runs')
+    ap.add_argument('--same-host', action='store_true', help='headset is the linux build on this host, check its clock estimate')
+    args = ap.parse_args()
+    sclock = ServerClock(args.clock_offset, args.clock_drift_ppm)
+
+    lsock = listen(args.port)
+    udp = listen_udp(args.port)
+    back_up_at = None
+    recoveries = []
+    print(f'listening on :{args.port}', flush=True)
+    while True:
+        conn, addr = lsock.accept()
+        if back_up_at is not None:
+            ms = (time.monotonic() - back_up_at) * 1000
+            recoveries.append(ms)
+            print(f'{addr[0]} back {ms:.0f} ms after the server returned '
+                  f'(avg {sum(recoveries) / len(recoveries):.0f} ms over {len(recoveries)})', flush=True)
+            back_up_at = None
+        else:
+            print(f'{addr[0]} connected', flush=True)
+        restart_at = time.monotonic() + args.restart_every if args.restart_every else None
+        result = session(conn, udp, args, restart_at, sclock)
+        if result == 'eof':
+            print('headset closed the connection', flush=True)
+            conn.close()
+            continue
+
+        print(f'simulating a restart ({args.mode}), down for {args.down:.1f} s', flush=True)
+        lsock.close()
+        udp.close()
+        if args.mode == 'close':
+            conn.close()
+            time.sleep(args.down)
+        else:
+            time.sleep(args.down)
+            # the rebooted host answers the old connection with a reset
+            conn.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+            conn.close()
+        lsock = listen(args.port)
+        udp = listen_udp(args.port)
+        back_up_at = time.monotonic()
+
+
+if __name__ == '__main__':
+    main()
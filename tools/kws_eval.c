@@ -0,0 +1,354 @@
+/* Eric Liu 2026
+
+Host evaluation of the keyword spotter (main/app_kws.c) on WAV fixtures:
+feeds every clip the way the kws task does (24 ms chunks of one mic, the
+detector started over per clip) and reports false rejects on clips of a
+keyword, false accepts on clips without one, and the cost per feature frame
+and per inference.
+
+    cc -O2 -I main tools/kws_eval.c main/app_kws.c main/app_mel.c -lm -o kws_eval
+    ./kws_eval [-t threshold %] [-p period] [-c channel] model.bin \
+        -k lang1 a.wav b.wav ... -k stop c.wav ... -n noise.wav talk.wav ...
+    ./kws_eval -d [-c channel] in.wav ...
+
+-k clips hold one utterance of the keyword; it counts as accepted if the
+detector fires on it within the clip or the second of silence after it.
+-n clips are background (speech, noise) of any length; every detection in
+them is a false accept. -p runs an inference every period feature frames
+(default 1; the headset paces it between 1 and KWS_MAX_PERIOD).
+
+-d writes the headset's features of each in.wav to in.wav.mfcc, frames x
+KWS_MFCC little endian int16 Q8, to train on (no model needed).
+
+*.wav: 16 kHz PCM, mono or stereo, 16, 24 or 32 bit.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_kws.h"
+
+#define CHUNK_FRAMES 384
+#define TAIL_FRAMES MEL_RATE             // silence after a keyword clip
+#define BENCH_RUNS 200
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* loads one channel of a PCM wav as 32 bit left aligned slots */
+static int32_t *load_wav(const char *path, int ch, size_t *frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a wav file\n", path);
+        fclose(f);
+        return NULL;
+    }
+    int channels = 0;
+    int bits = 0;
+    uint32_t rate = 0;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, f) == 8) {
+        uint32_t size = get_le(ck + 4, 4);
+        if (!memcmp(ck, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) {
+                break;
+            }
+            channels = (int)get_le(fmt + 2, 2);
+            rate = get_le(fmt + 4, 4);
+            bits = (int)get_le(fmt + 14, 2);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!memcmp(ck, "data", 4)) {
+            if (channels < 1 || ch >= channels || (bits != 16 && bits != 24 && bits != 32)) {
+                fprintf(stderr, "%s: need 16/24/32 bit PCM with channel %d, got %d ch %d bit\n", path, ch,
+                        channels, bits);
+                break;
+            }
+            if (rate != MEL_RATE) {
+                fprintf(stderr, "%s: %lu Hz, the headset records %d\n", path, (unsigned long)rate, MEL_RATE);
+            }
+            int bytes = bits / 8;
+            *frames = size / (size_t)(channels * bytes);
+            uint8_t *raw = malloc(size);
+            int32_t *slots = malloc((*frames + 1) * sizeof(int32_t));
+            if (!raw || !slots || fread(raw, 1, size, f) != size) {
+                free(raw);
+                free(slots);
+                break;
+            }
+            for (size_t i = 0; i < *frames; i++) {
+                /* 24 bit data left aligned like the I2S slots */
+                uint32_t v = get_le(raw + (i * channels + ch) * bytes, bytes) << (32 - bits);
+                slots[i] = (int32_t)(v & 0xFFFFFF00u);
+            }
+            free(raw);
+            fclose(f);
+            return slots;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no usable audio\n", path);
+    fclose(f);
+    return NULL;
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COST_UNIT "cycles (host TSC)"
+#else
+#define COST_UNIT "ns"
+#endif
+
+static uint64_t spent;
+
+/* n samples in chunks; the first detection of the clip, or KWS_NONE; *hits counts all of them */
+static int feed(kws_t *k, const int32_t *slots, size_t n, int *hits)
+{
+    int first = KWS_NONE;
+    for (size_t pos = 0; pos < n; pos += CHUNK_FRAMES) {
+        size_t len = n - pos < CHUNK_FRAMES ? n - pos : CHUNK_FRAMES;
+        uint64_t t0 = cycles();
+        int c = kws_push(k, slots + pos, len, 1);
+        spent += cycles() - t0;
+        if (c != KWS_NONE) {
+            (*hits)++;
+            if (first == KWS_NONE) {
+                first = c;
+            }
+        }
+    }
+    return first;
+}
+
+static int dump(int argc, char **argv, int ch)
+{
+    static kws_t k;
+    kws_init_features(&k);
+    int16_t *mel = malloc((CHUNK_FRAMES / MEL_HOP + 2) * MEL_FRAME_BYTES);
+    for (int a = 0; a < argc; a++) {
+        size_t n = 0;
+        int32_t *slots = load_wav(argv[a], ch, &n);
+        if (!slots) {
+            free(mel);
+            return 1;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s.mfcc", argv[a]);
+        FILE *f = fopen(path, "wb");
+        if (!f) {
+            perror(path);
+            free(slots);
+            free(mel);
+            return 1;
+        }
+        mel_reset(&k.mel);
+        size_t frames = 0;
+        int phase = 0;
+        for (size_t pos = 0; pos < n; pos += CHUNK_FRAMES) {
+            size_t len = n - pos < CHUNK_FRAMES ? n - pos : CHUNK_FRAMES;
+            size_t got = mel_push(&k.mel, slots + pos, len, 1, mel);
+            for (size_t i = 0; i < got; i++) {
+                if (++phase < KWS_FRAME_STEP) {
+                    continue;
+                }
+                phase = 0;
+                int16_t mfcc[KWS_MFCC];
+                uint8_t out[2 * KWS_MFCC];
+                kws_mfcc(&k, mel + i * MEL_BINS, mfcc);
+                for (int j = 0; j < KWS_MFCC; j++) {
+                    out[2 * j] = (uint8_t)mfcc[j];
+                    out[2 * j + 1] = (uint8_t)((uint16_t)mfcc[j] >> 8);
+                }
+                fwrite(out, 1, sizeof(out), f);
+                frames++;
+            }
+        }
+        fclose(f);
+        printf("%s: %zu frames of %d\n", path, frames, KWS_MFCC);
+        free(slots);
+    }
+    free(mel);
+    return 0;
+}
+
+static long read_file(const char *path, uint8_t **data)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *data = malloc(len > 0 ? (size_t)len : 1);
+    if (!*data || fread(*data, 1, (size_t)len, f) != (size_t)len) {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(f);
+        free(*data);
+        return -1;
+    }
+    fclose(f);
+    return len;
+}
+
+static int find_label(const kws_t *k, const char *name)
+{
+    for (int c = 0; c < k->n_classes; c++) {
+        if (!strcmp(k->labels[c], name)) {
+            return c;
+        }
+    }
+    return KWS_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    int threshold = 85;
+    int period = 1;
+    int ch = 0;
+    int a = 1;
+    bool dump_only = false;
+    for (; a < argc && argv[a][0] == '-' && argv[a][1] != 'k' && argv[a][1] != 'n'; a++) {
+        if (!strcmp(argv[a], "-d")) {
+            dump_only = true;
+        } else if (a + 1 < argc && !strcmp(argv[a], "-t")) {
+            threshold = atoi(argv[++a]);
+        } else if (a + 1 < argc && !strcmp(argv[a], "-p")) {
+            period = atoi(argv[++a]);
+        } else if (a + 1 < argc && !strcmp(argv[a], "-c")) {
+            ch = atoi(argv[++a]);
+        } else {
+            break;
+        }
+    }
+    if (dump_only && a < argc) {
+        return dump(argc - a, argv + a, ch);
+    }
+    if (a >= argc || threshold < 1 || threshold > 100 || period < 1 || period > KWS_MAX_PERIOD) {
+        fprintf(stderr,
+                "usage: %s [-t threshold %%] [-p period] [-c channel] model.bin -k label a.wav ... -n b.wav ...\n"
+                "       %s -d [-c channel] in.wav ...\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+    uint8_t *blob = NULL;
+    long len = read_file(argv[a++], &blob);
+    static kws_t k;
+    if (len < 0 || !kws_init(&k, blob, (size_t)len, (uint8_t)threshold)) {
+        fprintf(stderr, "model does not load\n");
+        free(blob);
+        return 1;
+    }
+    k.period = (uint8_t)period;
+    printf("model: %d layers, %d frames x %d in, classes", k.n_layers, k.in_frames, KWS_MFCC);
+    for (int c = 0; c < k.n_classes; c++) {
+        printf(" %s", k.labels[c]);
+    }
+    printf("\n");
+
+    int32_t *tail = calloc(TAIL_FRAMES, sizeof(int32_t));
+    int expect = KWS_NONE;
+    bool negative = false;
+    int pos_clips = 0, rejected = 0, wrong = 0;
+    int neg_clips = 0, false_accepts = 0;
+    double neg_s = 0.0;
+    for (; a < argc; a++) {
+        if (!strcmp(argv[a], "-n")) {
+            negative = true;
+            continue;
+        }
+        if (!strcmp(argv[a], "-k") && a + 1 < argc) {
+            expect = find_label(&k, argv[++a]);
+            if (expect == KWS_NONE || k.labels[expect][0] == '_') {
+                fprintf(stderr, "%s: not a keyword of the model\n", argv[a]);
+                return 1;
+            }
+            negative = false;
+            continue;
+        }
+        if (!negative && expect == KWS_NONE) {
+            fprintf(stderr, "%s: -k label or -n first\n", argv[a]);
+            return 1;
+        }
+        size_t n = 0;
+        int32_t *slots = load_wav(argv[a], ch, &n);
+        if (!slots) {
+            return 1;
+        }
+        kws_restart(&k);
+        int hits = 0;
+        if (negative) {
+            feed(&k, slots, n, &hits);
+            neg_clips++;
+            neg_s += (double)n / MEL_RATE;
+            false_accepts += hits;
+            if (hits) {
+                printf("%s: %d false accepts\n", argv[a], hits);
+            }
+        } else {
+            int c = feed(&k, slots, n, &hits);
+            if (c == KWS_NONE) {
+                c = feed(&k, tail, TAIL_FRAMES, &hits);
+            }
+            pos_clips++;
+            if (c != expect) {
+                rejected++;
+                wrong += c != KWS_NONE;
+                printf("%s: %s, best %.2f\n", argv[a], c == KWS_NONE ? "missed" : k.labels[c], k.last_prob);
+            }
+        }
+        free(slots);
+    }
+
+    if (pos_clips) {
+        printf("false rejects: %d of %d keyword clips (%.1f%%), %d as another keyword\n", rejected, pos_clips,
+               100.0 * rejected / pos_clips, wrong);
+    }
+    if (neg_clips) {
+        printf("false accepts: %d in %d clips, %.1f min (%.2f per hour)\n", false_accepts, neg_clips, neg_s / 60.0,
+               neg_s > 0.0 ? false_accepts * 3600.0 / neg_s : 0.0);
+    }
+
+    /* the model alone, on whatever window is left over */
+    float prob[KWS_MAX_CLASSES];
+    uint64_t t0 = cycles();
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        kws_infer(&k, k.feat, prob);
+    }
+    double infer = (double)(cycles() - t0) / BENCH_RUNS;
+    printf("%.0f " COST_UNIT " per feature frame (%d ms) at period %d, %.0f per inference\n",
+           (double)spent / (double)(k.frames ? k.frames : 1), KWS_FRAME_MS, period, infer);
+    free(tail);
+    kws_free(&k);
+    free(blob);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+# Eric Liu 2026
+#
+# Quantizes a trained keyword spotting model into the blob main/app_kws.c
+# runs (CONFIG_APP_KWS embeds it from main/kws_model.bin).
+#
+# The model comes as JSON with float weights in Keras layouts, batch norm
+# already folded into weights and bias:
+#
+#   {"labels": ["_silence", "_unknown", "lang1", "lang2", "stop"],
+#    "in_frames": 49,
+#    "input_max": 40.0,             # largest |MFCC| the model was trained on
+#    "layers": [
+#      {"op": "conv", "kernel": [10, 4], "stride": [2, 2], "padding": "same",
+#       "relu": true, "out_max": 6.0,
+#       "weights": kh x kw x in_c x out_c, "bias": out_c},
+#      {"op": "dwconv", ..., "weights": kh x kw x c x 1, "bias": c},
+#      {"op": "avgpool"},
+#      {"op": "fc", "out_max": 16.0, "weights": in x out, "bias": out}]}
+#
+# out_max is the largest |activation| a layer put out on training data. The
+# input is the headset's MFCC (tools/kws_eval.c -d dumps them from WAVs), in
+# natural units: Q8 values / 256.
+#
+# Labels starting with '_' never trigger. The headset acts on "lang1" and
+# "lang2" (start translating that language) and "stop"; other labels are
+# only counted.
+#
+# Every scale is a power of two: weights get the most fractional bits that
+# keep them in int8, activations the most that keep out_max in int8, and a
+# layer's accumulator is shifted right into its output scale.
+#
+#   python3 tools/kws_export.py model.json main/kws_model.bin
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+MFCC = 10
+MFCC_Q = 8
+LABEL_LEN = 12
+MAX_LAYERS = 16
+MAX_CLASSES = 8
+MAX_FRAMES = 64
+OPS = {'conv': 1, 'dwconv': 2, 'avgpool': 3, 'fc': 4}
+
+
+def frac_bits(max_abs, limit=24):
+    """fractional bits that keep max_abs within int8"""
+    if max_abs <= 0:
+        return limit
+    return min(limit, math.floor(math.log2(127.0 / max_abs)))
+
+
+def flatten(x):
+    if isinstance(x, list):
+        for v in x:
+            yield from flatten(v)
+    else:
+        yield float(x)
+
+
+def shape(x):
+    s = []
+    while isinstance(x, list):
+        s.append(len(x))
+        x = x[0]
+    return s
+
+
+def clamp(v, lo, hi):
+    return lo if v < lo else (hi if v > hi else v)
+
+
+def out_len(n, k, s, same):
+    return (n + s - 1) // s if same else (n - k) // s + 1
+
+
+def export(model):
+    labels = model['labels']
+    layers = model['layers']
+    in_frames = model['in_frames']
+    if not 2 <= len(labels) <= MAX_CLASSES or not 1 <= len(layers) <= MAX_LAYERS or not 1 <= in_frames <= MAX_FRAMES:
+        sys.exit('model: 2-%d labels, 1-%d layers, 1-%d frames' % (MAX_CLASSES, MAX_LAYERS, MAX_FRAMES))
+    # model input is Q8 MFCC >> in_shift, at most 15
+    in_frac = clamp(frac_bits(model['input_max']), MFCC_Q - 15, MFCC_Q)
+    in_shift = MFCC_Q - in_frac
+
+    out = bytearray(b'KWS1')
+    out += bytes([len(layers), len(labels), in_frames, MFCC, in_shift])
+    body = bytearray()
+    for name in labels:
+        raw = name.encode()
+        if len(raw) >= LABEL_LEN:
+            sys.exit('label %r longer than %d bytes' % (name, LABEL_LEN - 1))
+        body += raw + bytes(LABEL_LEN - len(raw))
+
+    h, w, c = in_frames, MFCC, 1
+    frac = in_frac
+    for i, layer in enumerate(layers):
+        op = layer['op']
+        if op not in OPS:
+            sys.exit('layer %d: unknown op %r' % (i, op))
+        kh, kw = layer.get('kernel', [1, 1])
+        sh, sw = layer.get('stride', [1, 1])
+        same = layer.get('padding', 'same') == 'same'
+        relu = bool(layer.get('relu', False))
+        if op == 'avgpool':
+            body += struct.pack('<8BHH', OPS[op], 0, 0, 0, 0, 0, 0, 0, c, 0)
+            h, w = 1, 1
+            continue
+
+        wt = layer['weights']
+        bias = list(flatten(layer['bias']))
+        ws = shape(wt)
+        flat = list(flatten(wt))
+        if op == 'conv':
+            if ws != [kh, kw, c, ws[3]]:
+                sys.exit('layer %d: conv weights %s, want [%d, %d, %d, out]' % (i, ws, kh, kw, c))
+            out_c = ws[3]
+            # kh x kw x in x out -> out x kh x kw x in
+            order = [flat[((y * kw + x) * c + ic) * out_c + oc]
+                     for oc in range(out_c) for y in range(kh) for x in range(kw) for ic in range(c)]
+        elif op == 'dwconv':
+            if ws != [kh, kw, c, 1]:
+                sys.exit('layer %d: depthwise weights %s, want [%d, %d, %d, 1]' % (i, ws, kh, kw, c))
+            out_c = c
+            order = flat
+        else:
+            n = h * w * c
+            if ws[0] != n:
+                sys.exit('layer %d: dense weights %s, want [%d, out]' % (i, ws, n))
+            out_c = ws[1]
+            order = [flat[j * out_c + oc] for oc in range(out_c) for j in range(n)]
+        if len(bias) != out_c:
+            sys.exit('layer %d: %d biases for %d outputs' % (i, len(bias), out_c))
+
+        w_frac = frac_bits(max(abs(v) for v in order))
+        o_frac = frac_bits(layer['out_max'])
+        shift = frac + w_frac - o_frac
+        if shift < 0:
+            # output needs more fractional bits than the accumulator has: keep the accumulator's
+            o_frac += shift
+            shift = 0
+        if shift > 31:
+            sys.exit('layer %d: scales too far apart' % i)
+        qw = bytes(clamp(round(v * 2.0 ** w_frac), -127, 127) & 0xFF for v in order)
+        qb = [clamp(round(v * 2.0 ** (frac + w_frac)), -2 ** 31, 2 ** 31 - 1) for v in bias]
+        body += struct.pack('<8BHH', OPS[op], kh, kw, sh, sw, same, relu, shift, out_c, 0)
+        body += qw + bytes(-len(qw) % 4)
+        body += struct.pack('<%di' % out_c, *qb)
+        print('layer %d %-7s %2dx%-2d x%-3d out %dx%dx%d  w 2^%d out 2^%d shift %d' %
+              (i, op, kh, kw, c, out_len(h, kh, sh, same) if op != 'fc' else 1,
+               out_len(w, kw, sw, same) if op != 'fc' else 1, out_c, -w_frac, -o_frac, shift))
+        if op != 'fc':
+            h, w = out_len(h, kh, sh, same), out_len(w, kw, sw, same)
+        else:
+            h, w = 1, 1
+        c = out_c
+        frac = o_frac
+
+    if layers[-1]['op'] != 'fc' or layers[-1].get('relu') or c != len(labels):
+        sys.exit('last layer has to be fc without relu, one output per label')
+    out += struct.pack('<b', clamp(frac, -128, 127)) + bytes(6)
+    return bytes(out + body)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='quantize a KWS model for app_kws.c')
+    ap.add_argument('model', help='model JSON')
+    ap.add_argument('out', help='blob, e.g. main/kws_model.bin')
+    args = ap.parse_args()
+    with open(args.model) as f:
+        blob = export(json.load(f))
+    with open(args.out, 'wb') as f:
+        f.write(blob)
+    print('%s: %d bytes' % (args.out, len(blob)))
+
+
+if __name__ == '__main__':
+    main()
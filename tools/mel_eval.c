@@ -0,0 +1,273 @@
+/* Eric Liu 2026
+
+Host check of the log-mel front end (main/app_mel.c) against Whisper's
+log_mel_spectrogram, computed here in double precision the way whisper/audio.py
+does it: reflect padded STFT (n_fft 400, hop 160, periodic Hann) as a direct
+DFT, power, librosa's Slaney mel filters as a dense matrix, log10 with a 1e-10
+floor, clamp to 8 below the clip's maximum, (x + 4) / 4. The headset's frames
+are fed in 24 ms chunks like i2s_read_task does, dequantized and put through
+the same last two steps. Frames 0 and 1 are skipped: the headset pads with
+silence where Whisper reflects.
+
+    cc -O2 -I main tools/mel_eval.c main/app_mel.c -lm -o mel_eval
+    ./mel_eval in.wav [channel]
+
+in.wav: 16 kHz PCM, mono or stereo, 16, 24 or 32 bit.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_mel.h"
+
+#define CHUNK_FRAMES 384
+#define PI 3.14159265358979
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* loads one channel of a PCM wav as 32 bit left aligned slots */
+static int32_t *load_wav(const char *path, int ch, size_t *frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a wav file\n", path);
+        fclose(f);
+        return NULL;
+    }
+    int channels = 0;
+    int bits = 0;
+    uint32_t rate = 0;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, f) == 8) {
+        uint32_t size = get_le(ck + 4, 4);
+        if (!memcmp(ck, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) {
+                break;
+            }
+            channels = (int)get_le(fmt + 2, 2);
+            rate = get_le(fmt + 4, 4);
+            bits = (int)get_le(fmt + 14, 2);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!memcmp(ck, "data", 4)) {
+            if (channels < 1 || ch >= channels || (bits != 16 && bits != 24 && bits != 32)) {
+                fprintf(stderr, "%s: need 16/24/32 bit PCM with channel %d, got %d ch %d bit\n", path, ch,
+                        channels, bits);
+                break;
+            }
+            if (rate != MEL_RATE) {
+                fprintf(stderr, "%s: %lu Hz, Whisper wants %d\n", path, (unsigned long)rate, MEL_RATE);
+            }
+            int bytes = bits / 8;
+            *frames = size / (size_t)(channels * bytes);
+            uint8_t *raw = malloc(size);
+            int32_t *slots = malloc(*frames * sizeof(int32_t));
+            if (!raw || !slots || fread(raw, 1, size, f) != size) {
+                free(raw);
+                free(slots);
+                break;
+            }
+            for (size_t i = 0; i < *frames; i++) {
+                /* 24 bit data left aligned like the I2S slots */
+                uint32_t v = get_le(raw + (i * channels + ch) * bytes, bytes) << (32 - bits);
+                slots[i] = (int32_t)(v & 0xFFFFFF00u);
+            }
+            free(raw);
+            fclose(f);
+            return slots;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no usable audio\n", path);
+    fclose(f);
+    return NULL;
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static double hz_to_mel(double hz)
+{
+    return hz < 1000.0 ? hz / (200.0 / 3.0) : 15.0 + log(hz / 1000.0) / (log(6.4) / 27.0);
+}
+
+static double mel_to_hz(double mel)
+{
+    return mel < 15.0 ? mel * (200.0 / 3.0) : 1000.0 * exp((mel - 15.0) * (log(6.4) / 27.0));
+}
+
+/* librosa.filters.mel(sr=16000, n_fft=400, n_mels=80, htk=False, norm="slaney") */
+static void librosa_mel(double w[MEL_BINS][MEL_SPEC_BINS])
+{
+    double f[MEL_BINS + 2];
+    for (int i = 0; i < MEL_BINS + 2; i++) {
+        f[i] = mel_to_hz(hz_to_mel(0.0) + (hz_to_mel(MEL_RATE / 2.0) - hz_to_mel(0.0)) * i / (MEL_BINS + 1));
+    }
+    for (int i = 0; i < MEL_BINS; i++) {
+        double enorm = 2.0 / (f[i + 2] - f[i]);
+        for (int k = 0; k < MEL_SPEC_BINS; k++) {
+            double hz = (double)k * MEL_RATE / MEL_N_FFT;
+            double lower = -(f[i] - hz) / (f[i + 1] - f[i]);
+            double upper = (f[i + 2] - hz) / (f[i + 2] - f[i + 1]);
+            double v = lower < upper ? lower : upper;
+            w[i][k] = (v > 0.0 ? v : 0.0) * enorm;
+        }
+    }
+}
+
+/* whisper log_mel_spectrogram up to the log10: frames x MEL_BINS */
+static double *whisper_log_mel(const int32_t *slots, size_t n, size_t *frames)
+{
+    static double w[MEL_BINS][MEL_SPEC_BINS];
+    static double cosv[MEL_N_FFT], sinv[MEL_N_FFT], win[MEL_N_FFT];
+    librosa_mel(w);
+    for (int i = 0; i < MEL_N_FFT; i++) {
+        cosv[i] = cos(2.0 * PI * i / MEL_N_FFT);
+        sinv[i] = sin(2.0 * PI * i / MEL_N_FFT);
+        win[i] = 0.5 - 0.5 * cos(2.0 * PI * i / MEL_N_FFT);
+    }
+    /* torch.stft(center=True) gives 1 + n / hop frames, Whisper drops the last */
+    *frames = n / MEL_HOP;
+    double *out = malloc(*frames * MEL_BINS * sizeof(double));
+    double x[MEL_N_FFT];
+    double power[MEL_SPEC_BINS];
+    for (size_t t = 0; t < *frames; t++) {
+        for (int i = 0; i < MEL_N_FFT; i++) {
+            long j = (long)(t * MEL_HOP) + i - MEL_N_FFT / 2;
+            if (j < 0) {
+                j = -j;
+            }
+            if (j >= (long)n) {
+                j = 2 * ((long)n - 1) - j;
+            }
+            x[i] = slots[j] / 2147483648.0 * win[i];
+        }
+        for (int k = 0; k < MEL_SPEC_BINS; k++) {
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < MEL_N_FFT; i++) {
+                int a = (k * i) % MEL_N_FFT;
+                re += x[i] * cosv[a];
+                im -= x[i] * sinv[a];
+            }
+            power[k] = re * re + im * im;
+        }
+        for (int b = 0; b < MEL_BINS; b++) {
+            double v = 0.0;
+            for (int k = 0; k < MEL_SPEC_BINS; k++) {
+                v += w[b][k] * power[k];
+            }
+            out[t * MEL_BINS + b] = log10(v > 1e-10 ? v : 1e-10);
+        }
+    }
+    return out;
+}
+
+/* Whisper's last two steps, over the whole clip */
+static void whisper_normalize(double *v, size_t count)
+{
+    double max = -1e9;
+    for (size_t i = 0; i < count; i++) {
+        max = v[i] > max ? v[i] : max;
+    }
+    for (size_t i = 0; i < count; i++) {
+        v[i] = ((v[i] > max - 8.0 ? v[i] : max - 8.0) + 4.0) / 4.0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s in.wav [channel]\n", argv[0]);
+        return 2;
+    }
+    size_t n = 0;
+    int32_t *slots = load_wav(argv[1], argc > 2 ? atoi(argv[2]) : 0, &n);
+    if (!slots) {
+        return 1;
+    }
+    size_t frames = 0;
+    double *ref = whisper_log_mel(slots, n, &frames);
+
+    static mel_t mel;
+    mel_init(&mel);
+    int16_t *q = malloc((n / MEL_HOP + 1) * MEL_FRAME_BYTES);
+    size_t got = 0;
+    uint64_t spent = 0;
+    for (size_t pos = 0; pos < n; pos += CHUNK_FRAMES) {
+        size_t len = n - pos < CHUNK_FRAMES ? n - pos : CHUNK_FRAMES;
+        uint64_t t0 = cycles();
+        got += mel_push(&mel, slots + pos, len, 1, q + got * MEL_BINS);
+        spent += cycles() - t0;
+    }
+    frames = got < frames ? got : frames;
+    double *dev = malloc(frames * MEL_BINS * sizeof(double));
+    for (size_t i = 0; i < frames * MEL_BINS; i++) {
+        dev[i] = (double)q[i] / (1 << MEL_Q);
+    }
+
+    /* raw log10, where the reference is within Whisper's 8 decade range */
+    double max = -1e9;
+    for (size_t i = 0; i < frames * MEL_BINS; i++) {
+        max = ref[i] > max ? ref[i] : max;
+    }
+    double log_max = 0.0, log_sum = 0.0;
+    size_t log_n = 0;
+    for (size_t i = 2 * MEL_BINS; i < frames * MEL_BINS; i++) {
+        if (ref[i] > max - 8.0) {
+            double e = fabs(dev[i] - ref[i]);
+            log_max = e > log_max ? e : log_max;
+            log_sum += e * e;
+            log_n++;
+        }
+    }
+    whisper_normalize(ref, frames * MEL_BINS);
+    whisper_normalize(dev, frames * MEL_BINS);
+    double norm_max = 0.0, norm_sum = 0.0;
+    for (size_t i = 2 * MEL_BINS; i < frames * MEL_BINS; i++) {
+        double e = fabs(dev[i] - ref[i]);
+        norm_max = e > norm_max ? e : norm_max;
+        norm_sum += e * e;
+    }
+    size_t norm_n = frames > 2 ? (frames - 2) * MEL_BINS : 1;
+
+    printf("%zu samples (%.1f s), %zu frames\n", n, (double)n / MEL_RATE, frames);
+    printf("log10 mel: max error %.5f, rms %.5f (%zu values in range)\n", log_max,
+           log_n ? sqrt(log_sum / log_n) : 0.0, log_n);
+    printf("whisper input: max error %.5f, rms %.5f\n", norm_max, sqrt(norm_sum / norm_n));
+#if defined(__x86_64__) || defined(__i386__)
+    printf("%.0f cycles per frame (host TSC)\n", (double)spent / (double)(got ? got : 1));
+#else
+    printf("%.0f ns per frame\n", (double)spent / (double)(got ? got : 1));
+#endif
+    free(q);
+    free(dev);
+    free(ref);
+    free(slots);
+    return 0;
+}
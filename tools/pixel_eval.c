@@ -0,0 +1,261 @@
+/* Eric Liu 2026
+
+Host check of the RGB565 kernels (main/app_pixel.c) on the portable path, the
+one every target without CONFIG_APP_PIXEL_SIMD runs and the one the PIE
+routines must match. Swap and fill are compared with a plain per-pixel loop,
+blend with LVGL's lv_color_16_16_mix (copied below from LVGL 9's
+lv_draw_sw_blend_to_rgb565.c, LVGL is not a host dependency). Every width up
+to 67 pixels at every start offset up to 7 pixels is checked, with random
+colours and masks made of runs of 0, runs of 255 and every other opacity, so
+the four-at-a-time skip and fill paths are hit along with the per pixel mix.
+Any mismatch is printed and the exit code is 1.
+
+Then it times the kernels against the per-pixel loops on a 240 x 40 caption
+stripe (blend on a glyph-like mask) and prints the time per pixel of both.
+
+    cc -O2 -I main tools/pixel_eval.c main/app_pixel.c -o pixel_eval
+    ./pixel_eval [timing rounds]
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_pixel.h"
+
+#define MAX_WIDTH 67
+#define MAX_OFFSET 8
+#define STRIPE_W 240
+#define STRIPE_H 40
+#define STRIPE (STRIPE_W * STRIPE_H)
+
+/* LVGL 9 lv_color_16_16_mix, verbatim apart from the attribute */
+static inline uint16_t lv_color_16_16_mix(uint16_t c1, uint16_t c2, uint8_t mix)
+{
+    if(mix == 255) return c1;
+    if(mix == 0) return c2;
+    if(c1 == c2) return c1;
+
+    uint16_t ret;
+
+    /* Source: https://stackoverflow.com/a/50012418/1999969*/
+    mix = (uint32_t)((uint32_t)mix + 4) >> 3;
+
+    /*0x7E0F81F = 0b00000111111000001111100000011111*/
+    uint32_t bg = (uint32_t)(c2 | ((uint32_t)c2 << 16)) & 0x7E0F81F;
+    uint32_t fg = (uint32_t)(c1 | ((uint32_t)c1 << 16)) & 0x7E0F81F;
+    uint32_t result = ((((fg - bg) * mix) >> 5) + bg) & 0x7E0F81F;
+    ret = (uint16_t)(result >> 16) | result;
+
+    return ret;
+}
+
+/* the per-pixel loops the kernels replace, kept out of line so the compiler
+ * does not turn the timing into a comparison of two inlined copies */
+__attribute__((noinline)) static void naive_swap(uint16_t *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = (uint16_t)((buf[i] << 8) | (buf[i] >> 8));
+    }
+}
+
+__attribute__((noinline)) static void naive_fill(uint16_t *dst, size_t count, uint16_t color)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+__attribute__((noinline)) static void naive_blend(uint16_t *dst, const uint8_t *alpha, size_t count, uint16_t color)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = lv_color_16_16_mix(color, dst[i], alpha[i]);
+    }
+}
+
+static uint32_t rng = 12345;
+
+static uint32_t rand32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/* runs of transparent, opaque and partial coverage, like an anti-aliased glyph row */
+static void make_mask(uint8_t *alpha, size_t count)
+{
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1 + rand32() % 12;
+        uint32_t kind = rand32() % 3;
+        for (size_t k = 0; k < run && i < count; k++, i++) {
+            alpha[i] = kind == 0 ? 0 : kind == 1 ? 255 : (uint8_t)rand32();
+        }
+    }
+}
+
+static int failures;
+
+/* count pixels of the buffer, the span of width pixels starting at offset and its guards */
+static void check(const char *what, const uint16_t *got, const uint16_t *want, size_t count, size_t width,
+                  size_t offset)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (got[i] != want[i]) {
+            if (failures++ < 10) {
+                printf("%s: width %zu offset %zu pixel %zu: %04x, want %04x\n", what, width, offset, i, got[i],
+                       want[i]);
+            }
+            return;
+        }
+    }
+}
+
+/* every width and start offset; the guard pixels around the span must stay untouched */
+static void check_exact(void)
+{
+    _Alignas(16) uint16_t got[MAX_OFFSET + MAX_WIDTH + 8];
+    _Alignas(16) uint16_t want[MAX_OFFSET + MAX_WIDTH + 8];
+    uint8_t alpha[MAX_WIDTH];
+    for (size_t offset = 0; offset < MAX_OFFSET; offset++) {
+        for (size_t width = 0; width <= MAX_WIDTH; width++) {
+            for (int round = 0; round < 64; round++) {
+                for (size_t i = 0; i < sizeof(got) / 2; i++) {
+                    got[i] = want[i] = (uint16_t)rand32();
+                }
+                naive_swap(want + offset, width);
+                pixel_rgb565_swap(got + offset, width);
+                check("swap", got, want, sizeof(got) / 2, width, offset);
+
+                uint16_t color = (uint16_t)rand32();
+                naive_fill(want + offset, width, color);
+                pixel_rgb565_fill(got + offset, width, color);
+                check("fill", got, want, sizeof(got) / 2, width, offset);
+
+                for (size_t i = 0; i < sizeof(got) / 2; i++) {
+                    got[i] = want[i] = (uint16_t)rand32();
+                }
+                make_mask(alpha, width);
+                /* the colour itself sometimes, mix565 short cuts fg == bg */
+                color = round & 7 ? (uint16_t)rand32() : want[offset];
+                naive_blend(want + offset, alpha, width, color);
+                pixel_rgb565_blend(got + offset, alpha, width, color);
+                check("blend", got, want, sizeof(got) / 2, width, offset);
+            }
+        }
+    }
+    /* every opacity on every channel extreme and random colours */
+    static const uint16_t edges[] = { 0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x0821, 0xF7DE };
+    for (int a = 0; a < 256; a++) {
+        for (int k = 0; k < 1024; k++) {
+            uint16_t fg = k < 49 ? edges[k % 7] : (uint16_t)rand32();
+            uint16_t bg = k < 49 ? edges[k / 7] : (uint16_t)rand32();
+            uint16_t got1 = bg;
+            uint8_t alpha1 = (uint8_t)a;
+            pixel_rgb565_blend(&got1, &alpha1, 1, fg);
+            uint16_t want1 = lv_color_16_16_mix(fg, bg, (uint8_t)a);
+            check("blend opacity", &got1, &want1, 1, 1, 0);
+        }
+    }
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void report(const char *what, uint64_t kernel, uint64_t naive, int rounds)
+{
+    double px = (double)STRIPE * rounds;
+#if defined(__x86_64__) || defined(__i386__)
+    printf("%-6s %6.3f cycles per pixel, per-pixel loop %6.3f (host TSC), %.1fx\n", what, kernel / px, naive / px,
+           (double)naive / (double)kernel);
+#else
+    printf("%-6s %6.3f ns per pixel, per-pixel loop %6.3f, %.1fx\n", what, kernel / px, naive / px,
+           (double)naive / (double)kernel);
+#endif
+}
+
+static void time_kernels(int rounds)
+{
+    static _Alignas(16) uint16_t buf[STRIPE];
+    static uint8_t alpha[STRIPE];
+    for (size_t i = 0; i < STRIPE; i++) {
+        buf[i] = (uint16_t)rand32();
+    }
+    /* glyph-like mask: background gaps, solid strokes with an anti-aliased pixel each side */
+    for (size_t i = 0; i < STRIPE;) {
+        size_t gap = 4 + rand32() % 24, stroke = rand32() % 6;
+        for (size_t k = 0; k < gap && i < STRIPE; k++) {
+            alpha[i++] = 0;
+        }
+        if (i < STRIPE) {
+            alpha[i++] = (uint8_t)(1 + rand32() % 254);
+        }
+        for (size_t k = 0; k < stroke && i < STRIPE; k++) {
+            alpha[i++] = 255;
+        }
+        if (i < STRIPE) {
+            alpha[i++] = (uint8_t)(1 + rand32() % 254);
+        }
+    }
+    uint64_t kernel = 0, naive = 0, t0;
+
+    for (int r = 0; r < rounds; r++) {
+        t0 = cycles();
+        pixel_rgb565_swap(buf, STRIPE);
+        kernel += cycles() - t0;
+        t0 = cycles();
+        naive_swap(buf, STRIPE);
+        naive += cycles() - t0;
+    }
+    report("swap", kernel, naive, rounds);
+
+    kernel = naive = 0;
+    for (int r = 0; r < rounds; r++) {
+        t0 = cycles();
+        pixel_rgb565_fill(buf, STRIPE, (uint16_t)r);
+        kernel += cycles() - t0;
+        t0 = cycles();
+        naive_fill(buf, STRIPE, (uint16_t)r);
+        naive += cycles() - t0;
+    }
+    report("fill", kernel, naive, rounds);
+
+    kernel = naive = 0;
+    for (int r = 0; r < rounds; r++) {
+        uint16_t color = (uint16_t)rand32();
+        t0 = cycles();
+        pixel_rgb565_blend(buf, alpha, STRIPE, color);
+        kernel += cycles() - t0;
+        t0 = cycles();
+        naive_blend(buf, alpha, STRIPE, color);
+        naive += cycles() - t0;
+    }
+    report("blend", kernel, naive, rounds);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    check_exact();
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 1;
+    }
+    printf("swap, fill, blend: bit exact, widths 0..%d at offsets 0..%d, all 256 opacities\n", MAX_WIDTH,
+           MAX_OFFSET - 1);
+    time_kernels(rounds > 0 ? rounds : 1);
+    return 0;
+}
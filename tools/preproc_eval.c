@@ -0,0 +1,384 @@
+/* Eric Liu 2026
+
+Host check of the capture pre-processing (main/app_preproc.c) against a
+double precision model of the same high-pass and AGC, run the way
+i2s_read_task does: 384 frame stereo chunks, each mic on its own state.
+
+The model filters with the same Q15 pole, so what is left is the fixed
+point rounding. preproc_hpf keeps PREPROC_HPF_FRAC fraction bits and the
+feedback rounding of 1/32 LSB per sample adds up to at most
+1 / (32 * (1 - a)) LSB, plus 1 for flooring the output: the high-pass has
+to stay within that bound of the model, 2 LSB at 80 Hz.
+
+preproc_agc is fed the model's high-pass output, floored like the slots, so
+only the AGC differs. It is checked twice:
+
+- bit exact against an integer model written from the same rules: Q16
+  gain, mean and peak floored, the step down halving the distance and the
+  step up adding g / 64, both floored, and the ramp g0 + i * step in Q24
+  with the step truncated. Every sample and the gain each chunk ends on
+  have to match it exactly, over the whole run.
+- against the double model, restarted every chunk from preproc_agc's gain
+  so the check covers the law of one chunk rather than where the two
+  trajectories have drifted to. The Q16 end gain is off the exact one by
+  the floor of the halving or the 1/64 step and of the want or limit
+  gain, under AGC_GAIN_TOL units together, plus gain / level from the
+  floored level (want moves by that much, the gain by at most as much),
+  1/14917 of the gain at worst. The truncated Q24 step loses
+  under a Q24 unit per sample, under n / 256 Q16 units by the end of the
+  chunk. A sample may be off by its input times those gain errors, plus
+  1 LSB for flooring the output.
+
+The worst error of each stage is printed with its bound, and the exit code
+is 1 if the AGC is not bit exact or either bound is broken.
+
+Then the cost: preproc_run on both mics of a 384 frame stereo chunk, as
+cycles (host TSC) or ns per chunk.
+
+    cc -O2 -I main tools/preproc_eval.c main/app_preproc.c -lm -o preproc_eval
+    ./preproc_eval [in.wav] [hpf Hz] [max gain dB]
+
+in.wav: 16 kHz stereo PCM, 16, 24 or 32 bit. Without it a synthetic test
+runs: tones and noise stepping between -70 and -1 dBFS on a DC offset,
+louder on one mic than the other.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_preproc.h"
+
+#define CHUNK_FRAMES 384
+#define SAMPLE_RATE 16000
+#define FULL_SCALE 8388608.0           // 24 bit
+#define AGC_GAIN_TOL 2.0               // Q16 units: floor of the gain step and of want or limit
+#define PI 3.14159265358979
+
+/* the constants of app_preproc.c */
+#define TARGET 838861.0
+#define GATE 14917.0
+#define LIMIT 7476355.0
+#define MIN_GAIN 0.25
+#define RELEASE (1.0 / 64)
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* loads a stereo PCM wav as 32 bit left aligned slots, L0 R0 L1 R1 */
+static int32_t *load_wav(const char *path, size_t *frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a wav file\n", path);
+        fclose(f);
+        return NULL;
+    }
+    int channels = 0;
+    int bits = 0;
+    uint32_t rate = 0;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, f) == 8) {
+        uint32_t size = get_le(ck + 4, 4);
+        if (!memcmp(ck, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) {
+                break;
+            }
+            channels = (int)get_le(fmt + 2, 2);
+            rate = get_le(fmt + 4, 4);
+            bits = (int)get_le(fmt + 14, 2);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!memcmp(ck, "data", 4)) {
+            if (channels != 2 || (bits != 16 && bits != 24 && bits != 32)) {
+                fprintf(stderr, "%s: need stereo 16/24/32 bit PCM, got %d ch %d bit\n", path, channels, bits);
+                break;
+            }
+            if (rate != SAMPLE_RATE) {
+                fprintf(stderr, "%s: %lu Hz, the headset captures at %d\n", path, (unsigned long)rate, SAMPLE_RATE);
+            }
+            int bytes = bits / 8;
+            *frames = size / (size_t)(2 * bytes);
+            uint8_t *raw = malloc(size);
+            int32_t *slots = malloc(*frames * 2 * sizeof(int32_t));
+            if (!raw || !slots || fread(raw, 1, size, f) != size) {
+                free(raw);
+                free(slots);
+                break;
+            }
+            for (size_t i = 0; i < *frames * 2; i++) {
+                /* 24 bit data left aligned like the I2S slots */
+                slots[i] = (int32_t)((get_le(raw + i * bytes, bytes) << (32 - bits)) & 0xFFFFFF00u);
+            }
+            free(raw);
+            fclose(f);
+            return slots;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no usable audio\n", path);
+    fclose(f);
+    return NULL;
+}
+
+/* 1.5 s segments at levels from -70 to -1 dBFS, tone plus noise on a DC offset; the right mic
+ * 20 dB under the left, like the subject's voice on the wearer's mic */
+static int32_t *make_test(size_t *frames)
+{
+    static const double levels_db[] = { -30, -1, -45, -10, -70, -20, -3, -55, -25, -6, -40, -15 };
+    size_t seg = SAMPLE_RATE * 3 / 2;
+    size_t nseg = sizeof(levels_db) / sizeof(levels_db[0]);
+    *frames = seg * nseg;
+    int32_t *slots = malloc(*frames * 2 * sizeof(int32_t));
+    if (!slots) {
+        return NULL;
+    }
+    uint32_t rng = 1;
+    for (size_t i = 0; i < *frames; i++) {
+        double amp = pow(10.0, levels_db[i / seg] / 20.0) * FULL_SCALE;
+        double t = (double)i / SAMPLE_RATE;
+        rng = rng * 1664525u + 1013904223u;
+        double noise = ((double)(rng >> 8) / 16777216.0 - 0.5) * 0.2;
+        double v = amp * (0.6 * sin(2 * PI * (300.0 + 40.0 * (double)(i / seg)) * t) + 0.2 * sin(2 * PI * 37.0 * t) +
+                          noise);
+        for (int ch = 0; ch < 2; ch++) {
+            double s = (ch ? 0.1 * v : v) + 12000.0;
+            s = s > FULL_SCALE - 1 ? FULL_SCALE - 1 : s < -FULL_SCALE ? -FULL_SCALE : s;
+            slots[2 * i + ch] = (int32_t)lrint(s) * 256;
+        }
+    }
+    return slots;
+}
+
+typedef struct {
+    double x1, y1;
+    double gain;
+    double level;                      // mean |y| of the last chunk
+} model_mic_t;
+
+/* y[n] = x[n] - x[n-1] + a * y[n-1], clipped to 24 bit like preproc_hpf */
+static void model_hpf(model_mic_t *m, double a, const int32_t *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = in[2 * i] >> 8;
+        m->y1 = x - m->x1 + a * m->y1;
+        m->x1 = x;
+        double y = m->y1;
+        out[i] = y > FULL_SCALE - 1 ? FULL_SCALE - 1 : y < -FULL_SCALE ? -FULL_SCALE : y;
+    }
+}
+
+/* mean |y| aimed at TARGET, halve the distance down, 1/64 up, hold under GATE, both ramp ends
+ * limited so the peak stays under LIMIT, linear ramp over the chunk */
+static void model_agc(model_mic_t *m, double max_gain, const double *in, double *out, size_t n)
+{
+    double sum = 0.0, peak = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += fabs(in[i]);
+        peak = fabs(in[i]) > peak ? fabs(in[i]) : peak;
+    }
+    double level = sum / n;
+    m->level = level;
+    double g0 = m->gain;
+    double g = g0;
+    if (level >= GATE) {
+        double want = TARGET / level;
+        want = want < MIN_GAIN ? MIN_GAIN : want > max_gain ? max_gain : want;
+        if (want < g) {
+            g -= (g - want) / 2;
+        } else {
+            g = g * (1 + RELEASE) < want ? g * (1 + RELEASE) : want;
+        }
+    }
+    if (peak > 0) {
+        double lim = LIMIT / peak;
+        g0 = g0 < lim ? g0 : lim;
+        g = g < lim ? g : lim;
+    }
+    m->gain = g;
+    for (size_t i = 0; i < n; i++) {
+        double v = in[i] * (g0 + (g - g0) * i / n);
+        out[i] = v > FULL_SCALE - 1 ? FULL_SCALE - 1 : v < -FULL_SCALE ? -FULL_SCALE : v;
+    }
+}
+
+/* preproc_agc's rules in integers, gain in Q16 and the ramp in Q24 */
+static int32_t model_agc_int(int32_t gain, int32_t max_gain, const int32_t *in, int32_t *out, size_t n)
+{
+    int64_t sum = 0;
+    int64_t peak = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t y = in[i] < 0 ? -(int64_t)in[i] : in[i];
+        sum += y;
+        peak = y > peak ? y : peak;
+    }
+    int64_t level = sum / (int64_t)n;
+    int64_t g0 = gain;
+    int64_t g = g0;
+    if (level >= (int64_t)GATE) {
+        int64_t want = ((int64_t)TARGET * 65536) / level;
+        want = want < PREPROC_GAIN_ONE / 4 ? PREPROC_GAIN_ONE / 4 : want > max_gain ? max_gain : want;
+        if (want < g) {
+            g -= (g - want) / 2;
+        } else {
+            g = g + g / 64 < want ? g + g / 64 : want;
+        }
+    }
+    if (peak > 0) {
+        int64_t lim = ((int64_t)LIMIT * 65536) / peak;
+        g0 = g0 < lim ? g0 : lim;
+        g = g < lim ? g : lim;
+    }
+    int64_t step = (g - g0) * 256 / (int64_t)n;
+    for (size_t i = 0; i < n; i++) {
+        int64_t v = (int64_t)in[i] * (g0 * 256 + (int64_t)i * step);
+        /* floor, not truncation, like the arithmetic shift */
+        v = (v >= 0 ? v : v - ((1 << 24) - 1)) / (1 << 24);
+        out[i] = (int32_t)(v > FULL_SCALE - 1 ? FULL_SCALE - 1 : v < -FULL_SCALE ? -FULL_SCALE : v);
+    }
+    return (int32_t)g;
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    size_t frames = 0;
+    int32_t *slots = argc > 1 && strcmp(argv[1], "-") ? load_wav(argv[1], &frames) : make_test(&frames);
+    if (!slots) {
+        return 1;
+    }
+    uint32_t hpf_hz = argc > 2 ? (uint32_t)atoi(argv[2]) : 80;
+    uint32_t max_gain_db = argc > 3 ? (uint32_t)atoi(argv[3]) : 30;
+
+    preproc_t pre;
+    preproc_init(&pre, SAMPLE_RATE, hpf_hz, max_gain_db);
+    double a = pre.hpf_a / 32768.0;
+    double max_gain = pre.max_gain / (double)PREPROC_GAIN_ONE;
+    model_mic_t model[2] = { { 0.0, 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0, 0.0 } };
+    int32_t int_gain[2] = { PREPROC_GAIN_ONE, PREPROC_GAIN_ONE };
+
+    double hpf_err = 0.0, agc_err = 0.0, agc_worst = 0.0, gain_worst = 0.0;
+    size_t hpf_at = 0, agc_at = 0, int_bad = 0, int_at = 0;
+    double ref_hpf[CHUNK_FRAMES], ref_agc[CHUNK_FRAMES];
+    int32_t chunk[CHUNK_FRAMES * 2], agc_in[CHUNK_FRAMES], ref_int[CHUNK_FRAMES];
+    for (size_t pos = 0; pos < frames; pos += CHUNK_FRAMES) {
+        size_t n = frames - pos < CHUNK_FRAMES ? frames - pos : CHUNK_FRAMES;
+        int32_t *s = slots + 2 * pos;
+        for (int mic = 0; mic < 2; mic++) {
+            model_hpf(&model[mic], a, s + mic, ref_hpf, n);
+            memcpy(chunk, s, n * 8);
+            preproc_hpf(&pre, (uint8_t)mic, chunk + mic, n, 2);
+            for (size_t i = 0; i < n; i++) {
+                double e = fabs((double)(chunk[2 * i + mic] >> 8) - ref_hpf[i]);
+                if (e > hpf_err) {
+                    hpf_err = e;
+                    hpf_at = pos + i;
+                }
+            }
+
+            /* both AGCs get the model's high-pass output, the fixed point one rounded to slots */
+            for (size_t i = 0; i < n; i++) {
+                double y = floor(ref_hpf[i]);
+                chunk[2 * i + mic] = (int32_t)y * 256;
+                agc_in[i] = (int32_t)y;
+                ref_hpf[i] = y;
+            }
+            double g0 = pre.mic[mic].gain;
+            model[mic].gain = g0 / PREPROC_GAIN_ONE;
+            model_agc(&model[mic], max_gain, ref_hpf, ref_agc, n);
+            int_gain[mic] = model_agc_int(int_gain[mic], pre.max_gain, agc_in, ref_int, n);
+            preproc_agc(&pre, (uint8_t)mic, chunk + mic, n, 2);
+
+            /* bound of the chunk in Q16 units, the end gain's and the ramp's */
+            double g_tol = AGC_GAIN_TOL + model[mic].gain * PREPROC_GAIN_ONE / fmax(model[mic].level, GATE);
+            double g_err = fabs(pre.mic[mic].gain - model[mic].gain * PREPROC_GAIN_ONE) / g_tol;
+            gain_worst = fmax(gain_worst, g_err);
+            double tol = g_tol + (double)n / 256;
+            for (size_t i = 0; i < n; i++) {
+                int32_t got = chunk[2 * i + mic] >> 8;
+                if (got != ref_int[i] && int_bad++ == 0) {
+                    int_at = pos + i;
+                }
+                /* flooring the output takes up to 1 LSB whatever the gain, the rest is the gain's */
+                double e = fabs((double)got - ref_agc[i]);
+                double used = fmax(e - 1.0, 0.0) / (fabs(ref_hpf[i]) * tol / PREPROC_GAIN_ONE);
+                if (e > agc_err) {
+                    agc_err = e;
+                }
+                if (ref_hpf[i] != 0.0 && used > agc_worst) {
+                    agc_worst = used;
+                    agc_at = pos + i;
+                }
+            }
+            if (int_gain[mic] != pre.mic[mic].gain && int_bad++ == 0) {
+                int_at = pos;
+            }
+        }
+    }
+
+    double hpf_bound = 1.0 / (32.0 * (1.0 - a)) + 1.0;
+    printf("%zu frames (%.1f s), high-pass %lu Hz (pole %ld/32768, %.2f Hz), max gain %lu dB\n", frames,
+           (double)frames / SAMPLE_RATE, (unsigned long)hpf_hz, (long)pre.hpf_a,
+           -log(a) * SAMPLE_RATE / (2 * PI), (unsigned long)max_gain_db);
+    printf("high-pass: max error %.2f LSB at frame %zu, allowed %.2f\n", hpf_err, hpf_at, hpf_bound);
+    if (int_bad) {
+        printf("AGC: %zu samples or gains off the integer model, the first at frame %zu\n", int_bad, int_at);
+    } else {
+        printf("AGC: bit exact with the integer model\n");
+    }
+    printf("AGC against the double model: max error %.1f LSB, at most %.1f%% of its bound (frame %zu); "
+           "end gains at most %.1f%% of theirs\n", agc_err, agc_worst * 100, agc_at, gain_worst * 100);
+    printf("gains at the end: left %.3f dB, right %.3f dB\n", 20 * log10(pre.mic[0].gain / 65536.0),
+           20 * log10(pre.mic[1].gain / 65536.0));
+    int ret = hpf_err > hpf_bound || int_bad || agc_worst > 1.0 || gain_worst > 1.0;
+
+    /* cost: both mics of a stereo chunk through preproc_run */
+    int rounds = 2000;
+    int32_t block[CHUNK_FRAMES * 2];
+    uint64_t spent = 0;
+    for (int r = 0; r < rounds; r++) {
+        size_t pos = (r * (size_t)CHUNK_FRAMES) % (frames - CHUNK_FRAMES + 1);
+        memcpy(block, slots + 2 * pos, sizeof(block));
+        uint64_t t0 = cycles();
+        preproc_run(&pre, 0, block, CHUNK_FRAMES, 2);
+        preproc_run(&pre, 1, block + 1, CHUNK_FRAMES, 2);
+        spent += cycles() - t0;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    printf("%.0f cycles per %d frame stereo chunk (host TSC), %.2f per sample\n", (double)spent / rounds,
+           CHUNK_FRAMES, (double)spent / rounds / (2 * CHUNK_FRAMES));
+#else
+    printf("%.0f ns per %d frame stereo chunk\n", (double)spent / rounds, CHUNK_FRAMES);
+#endif
+    free(slots);
+    if (ret) {
+        printf("FAILED\n");
+    }
+    return ret;
+}
@@ -0,0 +1,208 @@
+/* Eric Liu 2026
+
+Host check of the polyphase resampler (main/app_resample.c) for the two
+conversions the codec makes from the 16 kHz capture: 16 to 8 kHz and 16 to
+12 kHz. A sine at every sweep step is pushed through resample_push one
+sample at a time, the way codec_encode does, and the output after the filter
+has filled is measured:
+
+- passband, up to out_rate / 2 - 0.08 * out_rate: the gain of the tone (a
+  least squares fit of a sine at its frequency) may not ripple by more than
+  RIPPLE_DB peak to peak
+- stopband, out_rate / 2 up to 8 kHz: everything that comes out is alias,
+  its RMS against the tone's has to be under STOP_DB (the -70 dB the
+  resampler's Q15 coefficients are said to hold)
+- DC: every phase sums to exactly 1, so a constant must come out unchanged,
+  to the LSB, at any level including full scale
+
+The transition band in between is only printed. Any failure is printed and
+the exit code is 1.
+
+Then the cost: resample_push on a second of noise, as cycles (host TSC) or
+ns per output sample.
+
+    cc -O2 -I main tools/resample_eval.c main/app_resample.c -lm -o resample_eval
+    ./resample_eval [sweep step Hz]
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_resample.h"
+
+#define IN_RATE 16000
+#define AMPLITUDE 29000.0            // -1 dBFS, well above the output rounding floor
+#define MEASURE 4096                 // output samples per tone after the filter has filled
+#define RIPPLE_DB 0.02
+#define STOP_DB -70.0
+#define TRANSITION 0.08              // RESAMPLE_TRANSITION in app_resample.c
+#define PI 3.14159265358979
+
+static int failures;
+static volatile int16_t sink;       // keeps the timed outputs alive
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* MEASURE outputs of a tone at f Hz, after enough inputs to fill the filter */
+static size_t run_tone(resample_t *r, double f, double *out)
+{
+    resample_reset(r);
+    size_t settle = (size_t)r->taps * r->down / r->up + r->taps;
+    size_t n = 0;
+    for (size_t i = 0; n < MEASURE; i++) {
+        int16_t in = (int16_t)lrint(AMPLITUDE * sin(2.0 * PI * f * i / IN_RATE));
+        int16_t s;
+        if (resample_push(r, in, &s) && i >= settle) {
+            out[n++] = s;
+        }
+    }
+    return n;
+}
+
+/* amplitude of the sine at f in out, least squares over sin, cos */
+static double fit_amplitude(const double *out, size_t n, double f, uint32_t rate)
+{
+    double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double s = sin(2.0 * PI * f * i / rate);
+        double c = cos(2.0 * PI * f * i / rate);
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += out[i] * s;
+        yc += out[i] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+    return sqrt(a * a + b * b);
+}
+
+static double rms(const double *out, size_t n)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += out[i] * out[i];
+    }
+    return sqrt(sum / n);
+}
+
+static void check_rate(uint32_t out_rate, double step)
+{
+    resample_t r;
+    if (!resample_init(&r, IN_RATE, out_rate)) {
+        printf("%u Hz: resample_init failed\n", (unsigned)out_rate);
+        failures++;
+        return;
+    }
+    static double out[MEASURE];
+    double pass = out_rate / 2.0 - TRANSITION * out_rate;
+    double stop = out_rate / 2.0;
+
+    double lo = 1e9, hi = -1e9, lo_at = 0.0, hi_at = 0.0;
+    for (double f = step; f <= pass; f += step) {
+        size_t n = run_tone(&r, f, out);
+        double g = 20.0 * log10(fit_amplitude(out, n, f, out_rate) / AMPLITUDE);
+        if (g < lo) {
+            lo = g;
+            lo_at = f;
+        }
+        if (g > hi) {
+            hi = g;
+            hi_at = f;
+        }
+    }
+    double worst = -1e9, worst_at = 0.0;
+    for (double f = stop; f < IN_RATE / 2.0; f += step) {
+        size_t n = run_tone(&r, f, out);
+        double a = 20.0 * log10(rms(out, n) / (AMPLITUDE / sqrt(2.0)) + 1e-12);
+        if (a > worst) {
+            worst = a;
+            worst_at = f;
+        }
+    }
+    size_t n = run_tone(&r, pass + (stop - pass) / 2.0, out);
+    double edge = 20.0 * log10(rms(out, n) / (AMPLITUDE / sqrt(2.0)) + 1e-12);
+
+    /* DC to the LSB: every phase has to be hit, so a few hundred outputs at each level */
+    static const int16_t levels[] = { 1, -1, 1000, -12345, 32767, -32768 };
+    int dc_bad = 0;
+    for (size_t k = 0; k < sizeof(levels) / sizeof(levels[0]); k++) {
+        resample_reset(&r);
+        size_t settle = (size_t)r.taps * r.down / r.up + r.taps;
+        for (size_t i = 0; i < settle + 512; i++) {
+            int16_t s;
+            if (resample_push(&r, levels[k], &s) && i >= settle && s != levels[k]) {
+                if (dc_bad++ < 5) {
+                    printf("%u Hz: DC %d came out as %d\n", (unsigned)out_rate, levels[k], s);
+                }
+            }
+        }
+    }
+
+    printf("16 kHz to %u Hz (L %u M %u, %u taps per phase):\n", (unsigned)out_rate, r.up, r.down, r.taps);
+    printf("  passband 0-%.0f Hz: gain %+.4f to %+.4f dB (at %.0f and %.0f Hz), ripple %.4f dB, allowed %.2f\n",
+           pass, lo, hi, lo_at, hi_at, hi - lo, RIPPLE_DB);
+    printf("  transition middle %.0f Hz: %.1f dB\n", pass + (stop - pass) / 2.0, edge);
+    printf("  stopband %.0f-%d Hz: worst %.1f dB at %.0f Hz, allowed %.0f\n", stop, IN_RATE / 2, worst, worst_at,
+           STOP_DB);
+    printf("  DC: %s\n", dc_bad ? "NOT exact" : "exact at every level");
+    if (hi - lo > RIPPLE_DB || worst > STOP_DB || dc_bad) {
+        failures++;
+    }
+
+    /* cost on a second of white noise at -6 dBFS */
+    static int16_t noise[IN_RATE];
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < IN_RATE; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        noise[i] = (int16_t)((int32_t)(rng >> 16) - 32768) / 2;
+    }
+    uint64_t spent = 0;
+    size_t outputs = 0;
+    for (int round = 0; round < 20; round++) {
+        uint64_t t0 = cycles();
+        for (size_t i = 0; i < IN_RATE; i++) {
+            int16_t s;
+            if (resample_push(&r, noise[i], &s)) {
+                sink = s;
+                outputs++;
+            }
+        }
+        spent += cycles() - t0;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    printf("  %.1f cycles per output sample (host TSC)\n", (double)spent / outputs);
+#else
+    printf("  %.1f ns per output sample\n", (double)spent / outputs);
+#endif
+    resample_free(&r);
+}
+
+int main(int argc, char **argv)
+{
+    double step = argc > 1 ? atof(argv[1]) : 10.0;
+    if (step <= 0.0) {
+        step = 10.0;
+    }
+    check_rate(8000, step);
+    check_rate(12000, step);
+    if (failures) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,424 @@
+/* Eric Liu 2026
+
+Host replay of captions through the display tile diff (main/app_tile.c) on
+both panel geometries, to see how many SPI bytes the diff saves per panel.
+
+Each caption is wrapped into the log the way app_display.c does it (letter
+by letter to the content width, oldest line dropped when full, the text
+bottom aligned in the textarea), the whole textarea is rendered again and
+flushed in stripes of the render buffer height, as LVGL does after
+lv_textarea_set_text. Every stripe goes through tile_map_flush, and the
+emitted rects are copied onto a simulated panel.
+
+The glyphs are synthetic: a fixed anti-aliased pattern per letter, with
+widths and line heights close to montserrat 14 (screen 1) and 28 (screen 2).
+The counts depend on where text changes and not on the glyph shapes, so
+this is close enough to judge tile sizes and render buffer heights.
+
+Checked after every frame:
+- the simulated panel shows exactly the rendered frame, i.e. no skipped
+  tile was stale
+- bytes sent + bytes skipped = the bytes the frame costs without tile diff
+
+Any failure is printed and the exit code is 1.
+
+    cc -O2 -I main tools/tile_eval.c main/app_tile.c -o tile_eval
+    ./tile_eval [tile size] [caption file, one caption per line]
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_tile.h"
+
+#define MAX_LINES 16                 // DISPLAY_MAX_LINES in app_display.c
+#define LINE_SIZE 128                // LOG_LINE_SIZE
+#define MAX_CAPTIONS 256
+#define CAPTION_SIZE 512
+
+typedef struct {
+    const char *name;
+    uint16_t hres;
+    uint16_t vres;
+    uint8_t bpp;                     // render format: 16, 8 or 1
+    int32_t x, y, w, h;              // textarea
+    int32_t pad;
+    int32_t line_h;
+    int32_t scale;                   // glyph scale, 1 = montserrat 14, 2 = 28
+    int32_t max_lines;               // DISPLAY_MAX_LINES / _2, lowered to what fits
+    int32_t render_lines;
+} panel_t;
+
+/* app_display.c: screen 1 240x240 with the textarea at 30,40 180x160 pad 2, 40 render lines
+ * (CONFIG_APP_DISP1_DRAW_BUF_LINES); screen 2 480x128 with a 8 px margin, pad 4, montserrat 28,
+ * 4 render lines by default (CONFIG_APP_DISP2_DRAW_BUF_LINES) and at one tile row */
+static const panel_t panels[] = {
+    { "screen 1 RGB565", 240, 240, 16, 30, 40, 180, 160, 2, 16, 1, 16, 40 },
+    { "screen 2 L8", 480, 128, 8, 8, 8, 464, 112, 4, 31, 2, 8, 4 },
+    { "screen 2 L8", 480, 128, 8, 8, 8, 464, 112, 4, 31, 2, 8, 0 },
+    { "screen 2 I1", 480, 128, 1, 8, 8, 464, 112, 4, 31, 2, 8, 4 },
+    { "screen 2 I1", 480, 128, 1, 8, 8, 464, 112, 4, 31, 2, 8, 0 },
+};
+
+static const char *default_captions[] = {
+    "Good morning everyone, thanks for joining.",
+    "Can you hear me at the back?",
+    "Yes.",
+    "Today we look at the quarterly numbers and then the roadmap for next year.",
+    "Revenue is up eleven percent on last quarter.",
+    "Most of that came from the new region.",
+    "Costs went up too, mainly hiring.",
+    "Any questions so far?",
+    "What about the delay on the second product line?",
+    "We expect it to ship in March.",
+    "OK.",
+    "The supplier had problems with the display panels, that is solved now.",
+    "Next slide please.",
+    "Here you see the plan per team for the first half of the year.",
+    "Thank you.",
+    "Let's take a short break and continue at eleven.",
+};
+
+static int failures;
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint32_t mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    return h ^ (h >> 16);
+}
+
+/* advance of a letter in pixels, 4 to 10 at montserrat 14 */
+static int32_t glyph_width(const panel_t *p, unsigned char c)
+{
+    return p->scale * ((c == ' ') ? 4 : 5 + (int32_t)(mix(c) % 6));
+}
+
+/* coverage 0-255 of pixel (gx, gy) of a letter, gy from the top of the line */
+static uint8_t glyph_px(const panel_t *p, unsigned char c, int32_t gx, int32_t gy)
+{
+    gx /= p->scale;
+    gy /= p->scale;
+    if (c == ' ' || gx >= glyph_width(p, c) / p->scale - 1 || gy < 3 || gy > 13) {
+        return 0;
+    }
+    uint32_t h = mix((uint32_t)c * 977u + (uint32_t)gx * 31u + (uint32_t)gy);
+    return ((h & 3) == 0) ? 0 : (uint8_t)(h >> 24);
+}
+
+typedef struct {
+    char text[MAX_LINES][LINE_SIZE + 1];
+    int count;
+} log_t;
+
+static void push_line(const panel_t *p, log_t *log, const char *text, size_t len)
+{
+    while (len > 0 && *text == ' ') {
+        text++;
+        len--;
+    }
+    if (len == 0) {
+        return;
+    }
+    if (log->count >= p->max_lines) {
+        memmove(log->text[0], log->text[1], (size_t)(log->count - 1) * sizeof(log->text[0]));
+        log->count--;
+    }
+    if (len > LINE_SIZE) {
+        len = LINE_SIZE;
+    }
+    memcpy(log->text[log->count], text, len);
+    log->text[log->count][len] = '\0';
+    log->count++;
+}
+
+/* add_wrapped_lines: letter by letter to the content width */
+static void add_caption(const panel_t *p, log_t *log, const char *text)
+{
+    const int32_t max_width = p->w - 2 * p->pad;
+    size_t len = strlen(text), start = 0, line_len = 0;
+    int32_t width = 0;
+    for (size_t i = 0; i < len; i++) {
+        int32_t gw = glyph_width(p, (unsigned char)text[i]);
+        if (line_len > 0 && (width + gw > max_width || i - start >= LINE_SIZE)) {
+            push_line(p, log, text + start, i - start);
+            start = i;
+            width = 0;
+            line_len = 0;
+        }
+        width += gw;
+        line_len++;
+    }
+    if (line_len > 0) {
+        push_line(p, log, text + start, len - start);
+    }
+}
+
+/* coverage of the whole panel: the textarea's lines bottom aligned under padding lines */
+static void render_coverage(const panel_t *p, const log_t *log, uint8_t *cov)
+{
+    const int32_t padding = p->max_lines - log->count;
+    memset(cov, 0, (size_t)p->hres * p->vres);
+    for (int32_t i = 0; i < log->count; i++) {
+        int32_t x = p->x + p->pad;
+        const int32_t y = p->y + p->pad + (padding + i) * p->line_h;
+        for (const char *s = log->text[i]; *s; s++) {
+            unsigned char c = (unsigned char)*s;
+            int32_t gw = glyph_width(p, c);
+            for (int32_t gy = 0; gy < p->line_h && y + gy < p->y + p->h - p->pad; gy++) {
+                for (int32_t gx = 0; gx < gw && x + gx < p->x + p->w - p->pad; gx++) {
+                    cov[(size_t)(y + gy) * p->hres + x + gx] = glyph_px(p, c, gx, gy);
+                }
+            }
+            x += gw;
+        }
+    }
+}
+
+/* pixel as the panel sees it: green text on screen 1, white on screen 2 */
+static uint16_t panel_px(uint8_t bpp, uint8_t cov)
+{
+    switch (bpp) {
+    case 1:
+        return (cov >= 128) ? 0xFFFF : 0;
+    case 8:
+        return (uint16_t)(((cov >> 3) << 11) | ((cov >> 2) << 5) | (cov >> 3));
+    default:
+        return (uint16_t)((cov >> 2) << 5);
+    }
+}
+
+static uint32_t render_stride(uint8_t bpp, int32_t w)
+{
+    return (bpp == 1) ? (uint32_t)(w + 7) / 8 : (uint32_t)w * (bpp / 8);
+}
+
+/* the stripe's rect of the panel into a render buffer of its width, as LVGL lays it out */
+static void render_stripe(const panel_t *p, const uint8_t *cov, const tile_src_t *src, uint8_t *buf)
+{
+    const int32_t w = src->x2 - src->x1 + 1;
+    memset(buf, 0, (size_t)src->stride * (src->y2 - src->y1 + 1));
+    for (int32_t y = src->y1; y <= src->y2; y++) {
+        const uint8_t *c = cov + (size_t)y * p->hres + src->x1;
+        uint8_t *row = buf + (size_t)(y - src->y1) * src->stride;
+        for (int32_t i = 0; i < w; i++) {
+            switch (p->bpp) {
+            case 1:
+                row[i >> 3] |= (uint8_t)((c[i] >= 128) << (7 - (i & 7)));
+                break;
+            case 8:
+                row[i] = c[i];
+                break;
+            default:
+                ((uint16_t *)row)[i] = panel_px(16, c[i]);
+                break;
+            }
+        }
+    }
+}
+
+typedef struct {
+    const panel_t *p;
+    const tile_src_t *src;
+    const uint8_t *cov;
+    uint16_t *panel;                 // what the simulated panel shows
+    uint64_t bytes_sent;
+    uint32_t transfers;
+} sink_t;
+
+static void emit(void *arg, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    sink_t *s = (sink_t *)arg;
+    const panel_t *p = s->p;
+    for (int32_t r = s->src->y1 + y; r < s->src->y1 + y + h; r++) {
+        for (int32_t i = s->src->x1 + x; i < s->src->x1 + x + w; i++) {
+            s->panel[(size_t)r * p->hres + i] = panel_px(p->bpp, s->cov[(size_t)r * p->hres + i]);
+        }
+    }
+    s->bytes_sent += (uint64_t)w * h * sizeof(uint16_t);
+    s->transfers++;
+}
+
+typedef struct {
+    uint32_t tiles_sent;
+    uint32_t tiles_skipped;
+    uint64_t bytes_sent;
+    uint64_t bytes_skipped;
+    double transfers;                // per frame
+    double spent;                    // tile_map_flush per frame
+} result_t;
+
+/* every caption re-renders the textarea; round widens the flushed area to the tile grid */
+static result_t replay(const panel_t *cfg, uint16_t tile_size, bool round, const char **captions, int n)
+{
+    int32_t x1 = cfg->x, y1 = cfg->y, x2 = cfg->x + cfg->w - 1, y2 = cfg->y + cfg->h - 1;
+    if (round) {
+        x1 -= x1 % tile_size;
+        y1 -= y1 % tile_size;
+        x2 = (x2 / tile_size + 1) * tile_size - 1;
+        y2 = (y2 / tile_size + 1) * tile_size - 1;
+        x2 = (x2 < cfg->hres) ? x2 : cfg->hres - 1;
+        y2 = (y2 < cfg->vres) ? y2 : cfg->vres - 1;
+    }
+    const uint32_t stride = render_stride(cfg->bpp, x2 - x1 + 1);
+
+    tile_map_t tiles;
+    uint8_t *cov = malloc((size_t)cfg->hres * cfg->vres);
+    uint8_t *buf = malloc((size_t)stride * cfg->render_lines);
+    uint16_t *panel = calloc((size_t)cfg->hres * cfg->vres, sizeof(uint16_t));
+    if (!cov || !buf || !panel || !tile_map_init(&tiles, cfg->hres, cfg->vres, tile_size, cfg->bpp)) {
+        printf("out of memory\n");
+        exit(1);
+    }
+
+    log_t log = { 0 };
+    sink_t sink = { .p = cfg, .cov = cov, .panel = panel };
+    uint64_t spent = 0;
+    int stale = 0;
+    for (int f = 0; f < n; f++) {
+        add_caption(cfg, &log, captions[f]);
+        render_coverage(cfg, &log, cov);
+        const uint64_t sent_before = sink.bytes_sent, skipped_before = tiles.bytes_skipped;
+        for (int32_t y = y1; y <= y2; y += cfg->render_lines) {
+            const tile_src_t src = {
+                .px = buf,
+                .stride = stride,
+                .x1 = x1,
+                .y1 = y,
+                .x2 = x2,
+                .y2 = (y + cfg->render_lines - 1 < y2) ? y + cfg->render_lines - 1 : y2,
+            };
+            render_stripe(cfg, cov, &src, buf);
+            sink.src = &src;
+            uint64_t t0 = cycles();
+            tile_map_flush(&tiles, &src, emit, &sink);
+            spent += cycles() - t0;
+        }
+
+        for (size_t i = 0; i < (size_t)cfg->hres * cfg->vres && !stale; i++) {
+            if (panel[i] != panel_px(cfg->bpp, cov[i])) {
+                printf("  caption %d: panel pixel %d,%d is stale\n", f, (int)(i % cfg->hres), (int)(i / cfg->hres));
+                stale = 1;
+            }
+        }
+        const uint64_t frame = (uint64_t)(x2 - x1 + 1) * (y2 - y1 + 1) * sizeof(uint16_t);
+        if ((sink.bytes_sent - sent_before) + (tiles.bytes_skipped - skipped_before) != frame) {
+            printf("  caption %d: %llu bytes sent + %llu skipped, frame is %llu\n", f,
+                   (unsigned long long)(sink.bytes_sent - sent_before),
+                   (unsigned long long)(tiles.bytes_skipped - skipped_before), (unsigned long long)frame);
+            failures++;
+        }
+    }
+    failures += stale;
+
+    const result_t res = {
+        .tiles_sent = tiles.tiles_sent,
+        .tiles_skipped = tiles.tiles_skipped,
+        .bytes_sent = sink.bytes_sent,
+        .bytes_skipped = tiles.bytes_skipped,
+        .transfers = (double)sink.transfers / n,
+        .spent = (double)spent / n,
+    };
+    tile_map_free(&tiles);
+    free(panel);
+    free(buf);
+    free(cov);
+    return res;
+}
+
+static void report(const panel_t *p, uint16_t tile_size, const char **captions, int n)
+{
+    panel_t cfg = *p;
+    if (cfg.render_lines == 0) {
+        cfg.render_lines = tile_size;
+    }
+    if (cfg.max_lines > (cfg.h - 2 * cfg.pad) / cfg.line_h) {
+        cfg.max_lines = (cfg.h - 2 * cfg.pad) / cfg.line_h;
+    }
+    const uint64_t plain = (uint64_t)n * cfg.w * cfg.h * sizeof(uint16_t);
+    const result_t r = replay(&cfg, tile_size, false, captions, n);
+    const result_t rr = replay(&cfg, tile_size, true, captions, n);
+
+    printf("%s %ux%u, textarea %dx%d at %d,%d, %d render lines, %u px tiles, %d captions:\n", cfg.name,
+           (unsigned)cfg.hres, (unsigned)cfg.vres, (int)cfg.w, (int)cfg.h, (int)cfg.x, (int)cfg.y,
+           (int)cfg.render_lines, (unsigned)tile_size, n);
+    printf("  tiles %lu sent, %lu skipped, %.1f transfers per frame\n", (unsigned long)r.tiles_sent,
+           (unsigned long)r.tiles_skipped, r.transfers);
+    printf("  SPI bytes %llu sent, %llu skipped, %llu without tile diff: %.1f%% saved\n",
+           (unsigned long long)r.bytes_sent, (unsigned long long)r.bytes_skipped, (unsigned long long)plain,
+           100.0 - 100.0 * r.bytes_sent / plain);
+    printf("  area rounded to the tile grid: SPI bytes %llu sent, %llu skipped: %.1f%% saved\n",
+           (unsigned long long)rr.bytes_sent, (unsigned long long)rr.bytes_skipped,
+           100.0 - 100.0 * rr.bytes_sent / plain);
+#if defined(__x86_64__) || defined(__i386__)
+    printf("  tile_map_flush %.0f cycles per frame (host TSC)\n", r.spent);
+#else
+    printf("  tile_map_flush %.0f ns per frame\n", r.spent);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t tile_size = 16;
+    if (argc > 1) {
+        int t = atoi(argv[1]);
+        if (t < 8 || t > 64) {
+            printf("tile size must be 8 to 64 (CONFIG_APP_DISP_TILE_SIZE)\n");
+            return 1;
+        }
+        tile_size = (uint16_t)t;
+    }
+
+    const char **captions = default_captions;
+    int n = (int)(sizeof(default_captions) / sizeof(default_captions[0]));
+    if (argc > 2) {
+        static char text[MAX_CAPTIONS][CAPTION_SIZE];
+        static const char *list[MAX_CAPTIONS];
+        FILE *fp = fopen(argv[2], "r");
+        if (!fp) {
+            perror(argv[2]);
+            return 1;
+        }
+        n = 0;
+        while (n < MAX_CAPTIONS && fgets(text[n], CAPTION_SIZE, fp)) {
+            text[n][strcspn(text[n], "\r\n")] = '\0';
+            if (text[n][0]) {
+                list[n] = text[n];
+                n++;
+            }
+        }
+        fclose(fp);
+        if (n == 0) {
+            printf("%s: no captions\n", argv[2]);
+            return 1;
+        }
+        captions = list;
+    }
+
+    for (size_t i = 0; i < sizeof(panels) / sizeof(panels[0]); i++) {
+        report(&panels[i], tile_size, captions, n);
+    }
+    if (failures) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
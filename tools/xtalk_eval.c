@@ -0,0 +1,226 @@
+/* Eric Liu 2026
+
+Host evaluation of the cross-talk canceller (main/app_xtalk.c) on a stereo
+recording: runs it the way i2s_read_task does (high-pass on both mics, then
+the canceller, in 24 ms chunks) and reports how much the forward mic drops
+while only the wearer talks, how much it changes otherwise, and the cost.
+
+    cc -O2 -I main tools/xtalk_eval.c main/app_xtalk.c main/app_preproc.c -lm -o xtalk_eval
+    ./xtalk_eval in.wav [out.wav] [taps] [forward channel, 0 left]
+
+in.wav: 16 kHz stereo PCM, 16, 24 or 32 bit. out.wav gets the processed
+audio as 32 bit PCM.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_preproc.h"
+#include "app_xtalk.h"
+
+#define CHUNK_FRAMES 384
+#define SAMPLE_RATE 16000
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int n)
+{
+    for (int i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+/* loads a stereo PCM wav as 32 bit left aligned slots, L0 R0 L1 R1 */
+static int32_t *load_wav(const char *path, size_t *frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a wav file\n", path);
+        fclose(f);
+        return NULL;
+    }
+    int channels = 0;
+    int bits = 0;
+    uint32_t rate = 0;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, f) == 8) {
+        uint32_t size = get_le(ck + 4, 4);
+        if (!memcmp(ck, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) {
+                break;
+            }
+            channels = (int)get_le(fmt + 2, 2);
+            rate = get_le(fmt + 4, 4);
+            bits = (int)get_le(fmt + 14, 2);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!memcmp(ck, "data", 4)) {
+            if (channels != 2 || (bits != 16 && bits != 24 && bits != 32)) {
+                fprintf(stderr, "%s: need stereo 16/24/32 bit PCM, got %d ch %d bit\n", path, channels, bits);
+                break;
+            }
+            if (rate != SAMPLE_RATE) {
+                fprintf(stderr, "%s: %lu Hz, the headset captures at %d\n", path, (unsigned long)rate, SAMPLE_RATE);
+            }
+            int bytes = bits / 8;
+            *frames = size / (size_t)(2 * bytes);
+            uint8_t *raw = malloc(size);
+            int32_t *slots = malloc(*frames * 2 * sizeof(int32_t));
+            if (!raw || !slots || fread(raw, 1, size, f) != size) {
+                free(raw);
+                free(slots);
+                break;
+            }
+            for (size_t i = 0; i < *frames * 2; i++) {
+                /* 24 bit data left aligned like the I2S slots */
+                slots[i] = (int32_t)((get_le(raw + i * bytes, bytes) << (32 - bits)) & 0xFFFFFF00u);
+            }
+            free(raw);
+            fclose(f);
+            return slots;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no usable audio\n", path);
+    fclose(f);
+    return NULL;
+}
+
+static void save_wav(const char *path, const int32_t *slots, size_t frames)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    uint8_t hdr[44];
+    uint32_t size = (uint32_t)(frames * 8);
+    memcpy(hdr, "RIFF", 4);
+    put_le(hdr + 4, 36 + size, 4);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    put_le(hdr + 16, 16, 4);
+    put_le(hdr + 20, 1, 2);
+    put_le(hdr + 22, 2, 2);
+    put_le(hdr + 24, SAMPLE_RATE, 4);
+    put_le(hdr + 28, SAMPLE_RATE * 8, 4);
+    put_le(hdr + 32, 8, 2);
+    put_le(hdr + 34, 32, 2);
+    memcpy(hdr + 36, "data", 4);
+    put_le(hdr + 40, size, 4);
+    fwrite(hdr, 1, sizeof(hdr), f);
+    fwrite(slots, 8, frames, f);
+    fclose(f);
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static double energy(const int32_t *slots, size_t frames, int ch)
+{
+    double e = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        double v = slots[2 * i + ch] / 2147483648.0;
+        e += v * v;
+    }
+    return e;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s in.wav [out.wav] [taps] [forward channel]\n", argv[0]);
+        return 2;
+    }
+    size_t frames = 0;
+    int32_t *slots = load_wav(argv[1], &frames);
+    if (!slots) {
+        return 1;
+    }
+    int taps = argc > 3 ? atoi(argv[3]) : 32;
+    int fwd = argc > 4 ? atoi(argv[4]) & 1 : 0;
+
+    preproc_t pre;
+    preproc_init(&pre, SAMPLE_RATE, 80, 0);
+    static xtalk_t xt;
+    xtalk_init(&xt, (uint16_t)taps);
+
+    /* wearer alone: the canceller's own test, reference 6 dB over the forward mic */
+    double alone_in = 0.0, alone_out = 0.0, other_in = 0.0, other_out = 0.0;
+    double late_in = 0.0, late_out = 0.0;
+    uint64_t spent = 0;
+    int32_t chunk[CHUNK_FRAMES * 2];
+    for (size_t pos = 0; pos < frames; pos += CHUNK_FRAMES) {
+        size_t n = frames - pos < CHUNK_FRAMES ? frames - pos : CHUNK_FRAMES;
+        int32_t *s = slots + 2 * pos;
+        preproc_hpf(&pre, 0, s, n, 2);
+        preproc_hpf(&pre, 1, s + 1, n, 2);
+        memcpy(chunk, s, n * 8);
+        uint64_t t0 = cycles();
+        xtalk_run(&xt, s, n, (uint8_t)fwd);
+        spent += cycles() - t0;
+        for (size_t b = 0; b < n; b += XTALK_BLOCK) {
+            size_t len = n - b < XTALK_BLOCK ? n - b : XTALK_BLOCK;
+            double ref = energy(chunk + 2 * b, len, fwd ^ 1);
+            double in = energy(chunk + 2 * b, len, fwd);
+            double out = energy(s + 2 * b, len, fwd);
+            if (ref > 4.0 * in && ref > 1e-6 * len) {
+                alone_in += in;
+                alone_out += out;
+                if (pos >= frames / 2) {
+                    late_in += in;
+                    late_out += out;
+                }
+            } else {
+                other_in += in;
+                other_out += out;
+            }
+        }
+    }
+
+    printf("%zu frames (%.1f s), %d taps, forward mic %s\n", frames, (double)frames / SAMPLE_RATE, taps,
+           fwd ? "right" : "left");
+    if (alone_out > 0.0) {
+        printf("wearer alone: %.1f dB attenuation, %.1f dB over the second half\n",
+               10.0 * log10(alone_in / alone_out), late_out > 0.0 ? 10.0 * log10(late_in / late_out) : 0.0);
+    }
+    if (other_out > 0.0) {
+        printf("rest: %.1f dB attenuation\n", 10.0 * log10(other_in / other_out));
+    }
+    printf("canceller's own estimate %.1f dB\n", xt.atten_db10 / 10.0);
+#if defined(__x86_64__) || defined(__i386__)
+    printf("%.1f cycles per frame (host TSC)\n", (double)spent / (double)frames);
+#else
+    printf("%.1f ns per frame\n", (double)spent / (double)frames);
+#endif
+    if (argc > 2) {
+        save_wav(argv[2], slots, frames);
+    }
+    free(slots);
+    return 0;
+}